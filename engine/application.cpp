@@ -1,10 +1,23 @@
 #include "application.h"
 
+#include "argumentparser/argumentparser.h"
+#include "lib/microtar/microtar.h"
+#include "memory/memorytracker.h"
+#include "profiler/profiler.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <thread>
 #include <vector>
 
 Application::Application() {}
-Application::~Application() {}
+Application::~Application() {
+  // Configs are still members here; free them so they don't count.
+  configWatcher.clear();
+  // Everything the game and its resources allocated should be gone by now.
+  Memory::reportLeaks();
+}
 bool Application::tryInitializeRenderer() {
   // TODO: implement default renderer
   return EXIT_SUCCESS;
@@ -42,29 +55,289 @@ bool Application::tryInitializeIO() {
 
 bool Application::mainLoop() {
   while (!exitIsQueued) {
-    log(LOG_FATAL, "Main loop has not been reimplemented!");
+    log(LOG_WARNING, "Main loop has not been reimplemented!");
+    configWatcher.update();
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
   }
   return EXIT_SUCCESS;
 }
+bool Application::headlessLoop() {
+  using clock = std::chrono::steady_clock;
+  const auto step = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(1.0 / tickRate));
+  const double stepSeconds = 1.0 / tickRate;
+
+  Metrics::Registry &metrics = Metrics::Registry::instance();
+  Metrics::Histogram &tickDuration = metrics.histogram(
+      "engine_tick_duration_us", "Time spent in Application::tick");
+  Metrics::Counter &tickCount =
+      metrics.counter("engine_ticks_total", "Simulation steps run");
+  Metrics::Counter &overrunCount = metrics.counter(
+      "engine_tick_overruns_total", "Steps that took longer than one tick");
+  Metrics::Gauge &arenaPeak = metrics.gauge(
+      "engine_frame_arena_peak_bytes", "Most frame arena memory used in a tick");
+
+  auto begin = clock::now();
+  auto next = begin;
+  while (!exitIsQueued && (!tickLimit || stats.ticks < tickLimit)) {
+    auto start = clock::now();
+    {
+      PROFILE_ZONE("Application::tick");
+      MemoryScope scope(MEMTAG_GAME);
+      if (tick(stepSeconds))
+        return EXIT_FAILURE;
+    }
+    auto end = clock::now();
+    recordTick(end - start, step);
+    frameArena.reset();
+    configWatcher.update();
+    PROFILE_FRAME();
+
+    tickDuration.record(static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+            .count()));
+    tickCount.add();
+    if (end - start > step)
+      overrunCount.add();
+    arenaPeak.set(static_cast<double>(frameArena.peak()));
+    publishMemoryMetrics();
+
+    if (!unthrottled) {
+      next += step;
+      if (next > end)
+        std::this_thread::sleep_until(next);
+      else
+        next = end;  // fell behind; don't try to catch up in a burst
+    }
+  }
+  stats.elapsedMs =
+      std::chrono::duration<double, std::milli>(clock::now() - begin).count();
+
+  char summary[256];
+  snprintf(summary, sizeof(summary),
+           "%llu ticks in %.1f ms (last %.3f, min %.3f, mean %.3f, max %.3f "
+           "ms; %llu overruns)\n",
+           stats.ticks, stats.elapsedMs, stats.lastMs, stats.minMs,
+           stats.meanMs, stats.maxMs, stats.overruns);
+  log(LOG_NONFATAL, summary);
+
+#if ENGINE_PROFILER
+  std::vector<Profiler::ZoneStats> zones = Profiler::instance().totals();
+  for (size_t i = 0; i < zones.size() && i < 8; i++)
+    logf(LOG_NONFATAL, "  {}: {} calls, {} ms total, {} ms max",
+         zones[i].name, zones[i].calls, zones[i].totalMs, zones[i].maxMs);
+#endif
+  return EXIT_SUCCESS;
+}
+bool Application::tick(double) { return EXIT_SUCCESS; }
+void Application::publishMemoryMetrics() {
+  struct tagGauges {
+    Metrics::Gauge *live;
+    Metrics::Gauge *peak;
+    Metrics::Gauge *allocations;
+  };
+  static tagGauges gauges[MEMTAG_COUNT] = {};
+  static char names[MEMTAG_COUNT][3][64];
+
+  for (unsigned char i = 0; i < MEMTAG_COUNT; i++) {
+    memoryTag tag = static_cast<memoryTag>(i);
+    if (!gauges[i].live) {
+      const char *name = Memory::tagName(tag);
+      snprintf(names[i][0], 64, "memory_%s_live_bytes", name);
+      snprintf(names[i][1], 64, "memory_%s_peak_bytes", name);
+      snprintf(names[i][2], 64, "memory_%s_allocations", name);
+      Metrics::Registry &metrics = Metrics::Registry::instance();
+      gauges[i].live = &metrics.gauge(names[i][0], "Bytes currently allocated");
+      gauges[i].peak = &metrics.gauge(names[i][1], "Most bytes ever allocated");
+      gauges[i].allocations =
+          &metrics.gauge(names[i][2], "Allocations made so far");
+    }
+    Memory::TagStats s = Memory::stats(tag);
+    gauges[i].live->set(static_cast<double>(s.liveBytes));
+    gauges[i].peak->set(static_cast<double>(s.peakBytes));
+    gauges[i].allocations->set(static_cast<double>(s.allocations));
+  }
+}
+void Application::recordTick(std::chrono::steady_clock::duration duration,
+                             std::chrono::steady_clock::duration step) {
+  double ms = std::chrono::duration<double, std::milli>(duration).count();
+  stats.ticks++;
+  stats.lastMs = ms;
+  if (stats.ticks == 1 || ms < stats.minMs)
+    stats.minMs = ms;
+  if (ms > stats.maxMs)
+    stats.maxMs = ms;
+  stats.meanMs += (ms - stats.meanMs) / stats.ticks;
+  if (duration > step)
+    stats.overruns++;
+}
 bool Application::beginMainLoop() {
-  if (tryInitializeRenderer() && tryInitializeAudio() && tryInitializeIO())
-    return EXIT_FAILURE;
+  if (exitIsQueued)
+    return argumentsInvalid ? EXIT_FAILURE : EXIT_SUCCESS;
+
+  if (configPollInterval > 0) configWatcher.start(configPollInterval);
+  jobs.start(workers);
+
+  bool failed;
+  if (headless)
+    failed = tryInitializeIO() || headlessLoop();
   else {
-    if (!mainLoop())
-      return EXIT_SUCCESS;
-    else
-      return EXIT_FAILURE;
+    MemoryScope scope(MEMTAG_GAME);
+    failed = tryInitializeRenderer() || tryInitializeAudio() ||
+             tryInitializeIO() || mainLoop();
   }
-}
-void Application::argumentHandler(int, char *[]) {}
-void Application::exit() {}
-void Application::log(bool isFatal, std::string contents) {
-  FILE *type;
-  if (isFatal)
-    type = stderr;
+  Profiler::instance().endCapture();
+  jobs.stop();
+  metricsExporter.stop();
+  configWatcher.stop();
+
+  if (!failed)
+    return EXIT_SUCCESS;
   else
-    type = stdout;
+    return EXIT_FAILURE;
+}
+void Application::registerArguments(ArgumentParser &parser) {
+  parser.addFlag("headless", &headless,
+                 "run the simulation without a window, renderer or audio");
+  parser.addOption("tick-rate", &tickRate, "simulation steps per second");
+  parser.addOption("ticks", &tickLimit, "exit after this many ticks; 0 = never");
+  parser.addFlag("unthrottled", &unthrottled,
+                 "tick as fast as possible instead of holding the tick rate");
+  parser.addOption("workers", &workers,
+                   "threads for parallel work besides the main one; "
+                   "-1 = one per extra core");
+  parser.addList("pack", &packs, "mount an additional .grc resource pack");
+  parser.addList("memory-budget", &memoryBudgets,
+                 "warn when a memory tag exceeds this size, as tag=megabytes");
+  parser.addOption("log-level", &logLevel,
+                   "drop messages below this severity (0 trace .. 5 fatal)");
+  parser.addOption("log-binary", &binaryLogPath,
+                   "write unformatted log records to this file");
+  parser.addOption("decode-log", &decodeLogPath,
+                   "print a binary log file as text and exit");
+  parser.addList("encode-config", &encodeConfigs,
+                 "write a TOML file's binary form for packing, as in=out, "
+                 "and exit");
+  parser.addOption("profile-output", &profileOutputPath,
+                   "write a Chrome trace of profiled zones to this file");
+  parser.addOption("metrics-output", &metricsOutputPath,
+                   "periodically write Prometheus metrics to this file");
+  parser.addOption("metrics-socket", &metricsSocketPath,
+                   "serve Prometheus metrics on this UNIX socket");
+  parser.addOption("metrics-interval", &metricsInterval,
+                   "seconds between metrics file snapshots");
+  parser.addOption("config-poll", &configPollInterval,
+                   "seconds between checks for edited configs; 0 = never");
+  parser.addFlag("dev", &devMode,
+                 "also reload configs inside packs when the packs change");
+}
+void Application::argumentHandler(int argc, char *argv[]) {
+  ArgumentParser parser;
+  registerArguments(parser);
+  bool failed = parser.parse(argc, argv);
+
+  if (!failed && tickRate == 0) {
+    failed = true;
+    log(LOG_ERROR, "--tick-rate must be greater than zero\n");
+  } else if (failed)
+    log(LOG_ERROR, parser.error());
+
+  for (const char *budget : memoryBudgets) {
+    if (failed)
+      break;
+    char name[32];
+    double megabytes;
+    memoryTag tag;
+    if (sscanf(budget, "%31[^=]=%lf", name, &megabytes) != 2 ||
+        megabytes < 0 || Memory::tagFromName(name, &tag)) {
+      failed = true;
+      logf(LOG_ERROR, "invalid memory budget '{}'", budget);
+    } else
+      Memory::setBudget(tag, static_cast<size_t>(megabytes * 1024 * 1024));
+  }
+  if (logLevel > LOG_FATAL)
+    logLevel = LOG_FATAL;
+  Logger::instance().setLevel(static_cast<logSeverity>(logLevel));
+
+  if (!failed && decodeLogPath) {
+    if (Logger::decode(decodeLogPath, stdout)) {
+      log(LOG_ERROR, "Could not decode log file\n");
+      argumentsInvalid = true;
+    }
+    exitIsQueued = true;
+  } else if (!failed && !encodeConfigs.empty()) {
+    for (const char *job : encodeConfigs)
+      if (encodeConfig(job))
+        argumentsInvalid = true;
+    exitIsQueued = true;
+  } else if (!failed && binaryLogPath &&
+             Logger::instance().openBinary(binaryLogPath))
+    log(LOG_ERROR, "Could not open binary log file\n");
 
-  fputs(contents.c_str(), type);
+  if (!failed && profileOutputPath) {
+    if (!ENGINE_PROFILER)
+      log(LOG_WARNING, "Profiling zones are compiled out of this build\n");
+    if (Profiler::instance().beginCapture(profileOutputPath))
+      log(LOG_ERROR, "Could not open profile output file\n");
+  }
+  if (!failed && (metricsOutputPath || metricsSocketPath) &&
+      metricsExporter.start(metricsOutputPath, metricsSocketPath,
+                            metricsInterval))
+    log(LOG_ERROR, "Could not start the metrics exporter\n");
+
+  if (failed || parser.helpRequested()) {
+    Logger::instance().flush();
+    parser.printHelp(failed ? stderr : stdout);
+    argumentsInvalid = failed;
+    exitIsQueued = true;
+  }
+}
+bool Application::encodeConfig(const char *job) {
+  const char *separator = strchr(job, '=');
+  if (!separator || separator == job || !separator[1]) {
+    logf(LOG_ERROR, "--encode-config expects in=out, not '{}'", job);
+    return EXIT_FAILURE;
+  }
+  std::string input(job, separator);
+  toml::table table;
+#if TOML_EXCEPTIONS
+  try {
+    table = toml::parse_file(input);
+  } catch (const toml::parse_error &error) {
+    logf(LOG_ERROR, "Could not parse {}: {}", input, error.description());
+    return EXIT_FAILURE;
+  }
+#else
+  toml::parse_result result = toml::parse_file(input);
+  if (!result) {
+    logf(LOG_ERROR, "Could not parse {}: {}", input,
+         result.error().description());
+    return EXIT_FAILURE;
+  }
+  table = std::move(result).table();
+#endif
+  std::string encoded = ConfigEncoding::encode(table);
+  std::ofstream output(separator + 1, std::ios::binary);
+  output.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+  if (!output) {
+    logf(LOG_ERROR, "Could not write {}", separator + 1);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+void Application::exit() {}
+LiveConfig *Application::watchConfig(const std::string &name) {
+  std::error_code error;
+  if (std::filesystem::is_regular_file(name, error))
+    return configWatcher.watch(name);
+  // The first --pack that has it wins, as in Resource::getFile.
+  for (const char *pack : packs) {
+    mtar_t tar;
+    mtar_header_t header;
+    if (mtar_open(&tar, pack, "r") != MTAR_ESUCCESS) continue;
+    bool found = mtar_find(&tar, name.c_str(), &header) == MTAR_ESUCCESS;
+    mtar_close(&tar);
+    if (found) return configWatcher.watchPacked(pack, name, devMode);
+  }
+  return nullptr;
 }
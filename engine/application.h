@@ -3,19 +3,56 @@
 
 #include <chrono>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "configinterface/configwatcher.h"
+#include "jobs/jobsystem.h"
+#include "logger/logger.h"
+#include "memory/framearena.h"
+#include "metrics/metrics.h"
+
+class ArgumentParser;
+
 class Application {
 public:
   Application();
   virtual ~Application();
   virtual bool beginMainLoop();
   virtual void argumentHandler(int, char *[]);
-  virtual void log(bool isFatal, std::string contents);
+  // Both drop messages below ENGINE_LOG_LEVEL before reaching the logger,
+  // so calls with a constant severity under it compile to nothing;
+  // --log-level filters the rest at runtime.
+  void log(logSeverity severity, std::string_view contents) {
+    if (severity >= ENGINE_LOG_LEVEL)
+      Logger::instance().write(severity, contents);
+  }
+  // Queues the format and raw arguments; formatting happens off-thread,
+  // so the format must be a string literal, as for Logger::writeFormat().
+  template <size_t N, typename... Args>
+  void logf(logSeverity severity, const char (&format)[N],
+            const Args &...args) {
+    if (severity >= ENGINE_LOG_LEVEL)
+      Logger::instance().writeFormat(severity, format, args...);
+  }
+  template <size_t N, typename... Args>
+  void logf(logSeverity, char (&)[N], const Args &...) = delete;
 
-  enum logFatality { LOG_FATAL = 0, LOG_NONFATAL = 1 };
   bool exitIsQueued = false;
 
+  // Timing of the fixed-step simulation; all durations in milliseconds.
+  struct TickStats {
+    unsigned long long ticks = 0;
+    unsigned long long overruns = 0; // ticks that took longer than one step
+    double lastMs = 0;
+    double minMs = 0;
+    double maxMs = 0;
+    double meanMs = 0;
+    double elapsedMs = 0;
+  };
+  const TickStats &tickStats() const { return stats; }
+  bool isHeadless() const { return headless; }
+
   //  struct Arguments {
   //    void *data;
   //  };
@@ -25,6 +62,44 @@ public:
   //  };
 
 protected:
+  // Headless mode skips the renderer and audio and drives tick() from
+  // headlessLoop() instead of calling mainLoop().
+  bool headless = false;
+  bool unthrottled = false;           // tick as fast as possible
+  unsigned int tickRate = 60;         // simulation steps per second
+  unsigned long long tickLimit = 0;   // stop after this many ticks; 0 = never
+  std::vector<const char *> packs;    // extra .grc files to mount
+  std::vector<const char *> memoryBudgets;  // "tag=megabytes"
+  unsigned int logLevel = LOG_TRACE;  // runtime threshold, see logSeverity
+  const char *binaryLogPath = nullptr;
+  const char *decodeLogPath = nullptr;
+  std::vector<const char *> encodeConfigs;  // "in.toml=out.gcfg"
+  const char *profileOutputPath = nullptr;
+  const char *metricsOutputPath = nullptr;
+  const char *metricsSocketPath = nullptr;
+  double metricsInterval = 10;        // seconds between file snapshots
+  bool devMode = false;               // also reload configs inside packs
+  double configPollInterval = 1;      // seconds; 0 = never reload configs
+  int workers = -1;  // job threads besides the main one; -1 = one per core
+
+  // Worker threads for splitting up simulation work, e.g. for
+  // Physics::World::step. Running from beginMainLoop() until it returns.
+  JobSystem jobs;
+
+  // Scratch memory for the current tick; reset after every tick().
+  FrameArena frameArena;
+
+  // Reloads edited configs in the background. headlessLoop() calls update()
+  // after every tick; a mainLoop() of your own should do the same.
+  ConfigWatcher configWatcher;
+  // A config file on disk, or failing that the copy in the first mounted
+  // pack that has one. Packed configs are only watched for changes in dev mode.
+  // Returns nullptr if there is no such config or it doesn't parse.
+  LiveConfig *watchConfig(const std::string &name);
+
+  // Called by argumentHandler(); override to add options of your own.
+  virtual void registerArguments(ArgumentParser &parser);
+
   //  std::vector<Event> eventQueue;
   virtual bool tryInitializeRenderer();
   virtual bool tryInitializeAudio();
@@ -33,7 +108,18 @@ protected:
   //  virtual void schedule(void (*function)());
   //  virtual void eventPoll();
   virtual bool mainLoop();
+  virtual bool headlessLoop();
+  virtual bool tick(double step);
   virtual void exit();
+
+private:
+  void recordTick(std::chrono::steady_clock::duration duration,
+                  std::chrono::steady_clock::duration step);
+  void publishMemoryMetrics();
+  bool encodeConfig(const char *job);  /// Returns 1 on failure.
+  TickStats stats;
+  bool argumentsInvalid = false;
+  Metrics::Exporter metricsExporter;
 };
 
 #endif // APPLICATION_H
@@ -0,0 +1,199 @@
+#include "argumentparser.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+
+#include <cstring>
+
+void ArgumentParser::add(const char *name, type kind, void *target,
+                         const char *help) {
+  if (optionCount == maxOptions) {
+    if (!overflow) overflow = name;
+    return;
+  }
+  option &opt = options[optionCount++];
+  opt.name = name;
+  opt.help = help;
+  opt.kind = kind;
+  opt.target = target;
+
+  char *d = opt.defaultValue;
+  size_t n = sizeof(opt.defaultValue);
+  switch (kind) {
+    case TYPE_FLAG:
+      snprintf(d, n, "%s", *static_cast<bool *>(target) ? "on" : "off");
+      break;
+    case TYPE_INT:
+      snprintf(d, n, "%d", *static_cast<int *>(target));
+      break;
+    case TYPE_UINT:
+      snprintf(d, n, "%u", *static_cast<unsigned int *>(target));
+      break;
+    case TYPE_ULONGLONG:
+      snprintf(d, n, "%llu", *static_cast<unsigned long long *>(target));
+      break;
+    case TYPE_DOUBLE:
+      snprintf(d, n, "%g", *static_cast<double *>(target));
+      break;
+    case TYPE_STRING: {
+      const char *value = *static_cast<const char **>(target);
+      snprintf(d, n, "%s", value ? value : "");
+      break;
+    }
+    case TYPE_LIST:
+      d[0] = '\0';
+      break;
+  }
+}
+
+void ArgumentParser::addFlag(const char *name, bool *target,
+                             const char *help) {
+  add(name, TYPE_FLAG, target, help);
+}
+void ArgumentParser::addOption(const char *name, int *target,
+                               const char *help) {
+  add(name, TYPE_INT, target, help);
+}
+void ArgumentParser::addOption(const char *name, unsigned int *target,
+                               const char *help) {
+  add(name, TYPE_UINT, target, help);
+}
+void ArgumentParser::addOption(const char *name, unsigned long long *target,
+                               const char *help) {
+  add(name, TYPE_ULONGLONG, target, help);
+}
+void ArgumentParser::addOption(const char *name, double *target,
+                               const char *help) {
+  add(name, TYPE_DOUBLE, target, help);
+}
+void ArgumentParser::addOption(const char *name, const char **target,
+                               const char *help) {
+  add(name, TYPE_STRING, target, help);
+}
+void ArgumentParser::addList(const char *name,
+                             std::vector<const char *> *target,
+                             const char *help) {
+  add(name, TYPE_LIST, target, help);
+}
+
+const ArgumentParser::option *ArgumentParser::find(const char *name,
+                                                   size_t length) const {
+  for (size_t i = 0; i < optionCount; i++)
+    if (strlen(options[i].name) == length &&
+        !strncmp(options[i].name, name, length))
+      return &options[i];
+  return nullptr;
+}
+
+bool ArgumentParser::assign(const option &opt, const char *value) {
+  char *end = nullptr;
+  errno = 0;
+  switch (opt.kind) {
+    case TYPE_FLAG:
+      *static_cast<bool *>(opt.target) = true;
+      return 0;
+    case TYPE_INT: {
+      long v = strtol(value, &end, 10);
+      if (v < INT_MIN || v > INT_MAX) errno = ERANGE;
+      *static_cast<int *>(opt.target) = static_cast<int>(v);
+      break;
+    }
+    case TYPE_UINT: {
+      unsigned long v = strtoul(value, &end, 10);
+      if (v > UINT_MAX || *value == '-') errno = ERANGE;
+      *static_cast<unsigned int *>(opt.target) = static_cast<unsigned int>(v);
+      break;
+    }
+    case TYPE_ULONGLONG:
+      if (*value == '-') errno = ERANGE;
+      *static_cast<unsigned long long *>(opt.target) =
+          strtoull(value, &end, 10);
+      break;
+    case TYPE_DOUBLE:
+      *static_cast<double *>(opt.target) = strtod(value, &end);
+      break;
+    case TYPE_STRING:
+      *static_cast<const char **>(opt.target) = value;
+      return 0;
+    case TYPE_LIST:
+      static_cast<std::vector<const char *> *>(opt.target)->push_back(value);
+      return 0;
+  }
+  if (errno || end == value || *end != '\0') {
+    snprintf(errorMessage, sizeof(errorMessage),
+             "invalid value '%s' for --%s\n", value, opt.name);
+    return 1;
+  }
+  return 0;
+}
+
+bool ArgumentParser::parse(int argc, char *argv[]) {
+  if (argc > 0) programName = argv[0];
+  if (overflow) {
+    snprintf(errorMessage, sizeof(errorMessage),
+             "too many options registered; --%s and later were dropped\n",
+             overflow);
+    return 1;
+  }
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if (!strcmp(arg, "-h") || !strcmp(arg, "--help")) {
+      help = true;
+      continue;
+    }
+    if (strncmp(arg, "--", 2)) {
+      snprintf(errorMessage, sizeof(errorMessage),
+               "unexpected argument '%s'\n", arg);
+      return 1;
+    }
+    arg += 2;
+
+    const char *value = strchr(arg, '=');
+    size_t length = value ? static_cast<size_t>(value - arg) : strlen(arg);
+    const option *opt = find(arg, length);
+    if (!opt) {
+      snprintf(errorMessage, sizeof(errorMessage), "unknown option '--%.*s'\n",
+               static_cast<int>(length), arg);
+      return 1;
+    }
+
+    if (value)
+      value++;
+    else if (opt->kind != TYPE_FLAG) {
+      if (i + 1 == argc) {
+        snprintf(errorMessage, sizeof(errorMessage),
+                 "missing value for --%s\n", opt->name);
+        return 1;
+      }
+      value = argv[++i];
+    } else
+      value = "";
+
+    if (opt->kind == TYPE_FLAG && *value) {
+      snprintf(errorMessage, sizeof(errorMessage),
+               "--%s does not take a value\n", opt->name);
+      return 1;
+    }
+    if (assign(*opt, value)) return 1;
+  }
+  return 0;
+}
+
+void ArgumentParser::printHelp(FILE *out) const {
+  static const char *placeholders[] = {"",    "<int>",  "<uint>", "<uint>",
+                                       "<num>", "<str>", "<str>"};
+  fprintf(out, "usage: %s [options]\n\n", programName);
+  for (size_t i = 0; i < optionCount; i++) {
+    const option &opt = options[i];
+    char left[48];
+    snprintf(left, sizeof(left), "--%s %s", opt.name, placeholders[opt.kind]);
+    fprintf(out, "  %-28s %s", left, opt.help);
+    if (opt.kind == TYPE_LIST)
+      fputs(" (repeatable)", out);
+    else if (opt.kind != TYPE_FLAG && opt.defaultValue[0])
+      fprintf(out, " (default: %s)", opt.defaultValue);
+    fputc('\n', out);
+  }
+  fprintf(out, "  %-28s %s\n", "--help", "show this message");
+}
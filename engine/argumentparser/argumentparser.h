@@ -0,0 +1,64 @@
+#ifndef ARGUMENTPARSER_H
+#define ARGUMENTPARSER_H
+
+#include <stdio.h>
+
+#include <cstddef>
+#include <vector>
+
+// Declarative command line parser. Options are registered against variables
+// that already hold their defaults; parse() writes straight into them.
+// Nothing is copied: string values point into argv, which outlives main().
+// Registering more than maxOptions makes parse() fail, naming the first
+// option that didn't fit.
+class ArgumentParser {
+ public:
+  static constexpr size_t maxOptions = 48;
+
+  void addFlag(const char *name, bool *target, const char *help);
+  void addOption(const char *name, int *target, const char *help);
+  void addOption(const char *name, unsigned int *target, const char *help);
+  void addOption(const char *name, unsigned long long *target,
+                 const char *help);
+  void addOption(const char *name, double *target, const char *help);
+  void addOption(const char *name, const char **target, const char *help);
+  void addList(const char *name, std::vector<const char *> *target,
+               const char *help);  /// May be given more than once.
+
+  bool parse(int argc, char *argv[]);  /// Returns 1 on bad arguments.
+  void printHelp(FILE *out) const;
+
+  bool helpRequested() const { return help; }
+  const char *error() const { return errorMessage; }
+
+ private:
+  enum type {
+    TYPE_FLAG,
+    TYPE_INT,
+    TYPE_UINT,
+    TYPE_ULONGLONG,
+    TYPE_DOUBLE,
+    TYPE_STRING,
+    TYPE_LIST
+  };
+  struct option {
+    const char *name;
+    const char *help;
+    type kind;
+    void *target;
+    char defaultValue[24];
+  };
+
+  void add(const char *name, type kind, void *target, const char *help);
+  const option *find(const char *name, size_t length) const;
+  bool assign(const option &opt, const char *value);
+
+  option options[maxOptions];
+  size_t optionCount = 0;
+  const char *overflow = nullptr;  // first option past maxOptions
+  const char *programName = "";
+  bool help = false;
+  char errorMessage[128] = "";
+};
+
+#endif  // ARGUMENTPARSER_H
@@ -0,0 +1,209 @@
+#ifndef CONFIGBINDING_H
+#define CONFIGBINDING_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "configtypes.h"
+
+// Compile-time field lists that map TOML tables onto plain structs:
+//
+//   struct WindowSettings {
+//     int width = 640;
+//     std::string title = "demo";
+//   };
+//   CONFIG_FIELDS(WindowSettings,
+//                 CONFIG_FIELD(width, ConfigCheck::range(1, 8192)),
+//                 CONFIG_FIELD(title));
+//
+// Members keep their default when the key is missing. Fields may be numbers,
+// bool, std::string, Time / Date / DateTime or the toml date/time types,
+// other structs with their own CONFIG_FIELDS, or std::vectors of any of
+// those. CONFIG_FIELDS must be used at global scope.
+
+template <typename T>
+struct ConfigFields;  // specialised by CONFIG_FIELDS
+
+#define CONFIG_FIELDS(Type, ...)                 \
+  template <>                                    \
+  struct ConfigFields<Type> {                    \
+    using self = Type;                           \
+    static auto fields() {                       \
+      return std::make_tuple(__VA_ARGS__);       \
+    }                                            \
+  }
+#define CONFIG_FIELD(member, ...) \
+  ConfigBinding::field(#member, &self::member, ##__VA_ARGS__)
+
+namespace ConfigCheck {
+// A check returns nullptr if the value is acceptable, otherwise a message.
+template <typename T>
+auto range(T min, T max) {
+  return [min, max](const auto &value) -> const char * {
+    return value < min || value > max ? "out of range" : nullptr;
+  };
+}
+inline auto nonEmpty() {
+  return [](const auto &value) -> const char * {
+    return value.empty() ? "must not be empty" : nullptr;
+  };
+}
+}  // namespace ConfigCheck
+
+namespace ConfigBinding {
+
+struct noCheck {
+  template <typename T>
+  const char *operator()(const T &) const {
+    return nullptr;
+  }
+};
+
+template <typename Struct, typename Member, typename Check>
+struct Field {
+  const char *name;
+  Member Struct::*member;
+  Check check;
+};
+
+template <typename Struct, typename Member, typename Check = noCheck>
+Field<Struct, Member, Check> field(const char *name, Member Struct::*member,
+                                   Check check = Check()) {
+  return {name, member, check};
+}
+
+template <typename T, typename = void>
+struct isBound : std::false_type {};
+template <typename T>
+struct isBound<T, std::void_t<decltype(ConfigFields<T>::fields())>>
+    : std::true_type {};
+
+template <typename T>
+struct isCalendar
+    : std::bool_constant<std::is_same_v<T, Time> || std::is_same_v<T, Date> ||
+                         std::is_same_v<T, DateTime>> {};
+
+template <typename T>
+struct isVector : std::false_type {};
+template <typename T, typename A>
+struct isVector<std::vector<T, A>> : std::true_type {};
+
+using errorList = std::vector<std::string>;
+
+template <typename T>
+bool load(const toml::table &table, T &out, errorList *errors = nullptr,
+          const std::string &prefix = "");
+template <typename T>
+toml::table save(const T &value);
+
+//--- Reading
+
+template <typename M>
+bool read(const toml::node &node, M &out, errorList *errors,
+          const std::string &path) {
+  if constexpr (isBound<M>::value) {
+    if (const toml::table *table = node.as_table())
+      return load(*table, out, errors, path + ".");
+  } else if constexpr (isVector<M>::value) {
+    if (const toml::array *array = node.as_array()) {
+      M list;
+      list.reserve(array->size());
+      bool failed = false;
+      for (size_t i = 0; i < array->size(); i++) {
+        typename M::value_type element{};
+        failed |= read(*array->get(i), element, errors,
+                       path + "." + std::to_string(i));
+        list.push_back(std::move(element));
+      }
+      out = std::move(list);
+      return failed;
+    }
+  } else if constexpr (isCalendar<M>::value) {
+    if (auto value = node.value<decltype(M().toToml())>()) {
+      out = M::fromToml(*value);
+      return 0;
+    }
+  } else {
+    // toml++ converts between integer and float types where lossless.
+    if (std::optional<M> value = node.value<M>()) {
+      out = *std::move(value);
+      return 0;
+    }
+  }
+  if (errors) errors->push_back(path + ": wrong type");
+  return 1;
+}
+
+template <typename T>
+bool load(const toml::table &table, T &out, errorList *errors,
+          const std::string &prefix) {
+  static_assert(isBound<T>::value, "T needs a CONFIG_FIELDS list");
+  bool failed = false;
+  std::apply(
+      [&](const auto &...fields) {
+        auto one = [&](const auto &f) {
+          const toml::node *node = table.get(f.name);
+          if (!node) return;
+          std::string path = prefix + f.name;
+          auto value = out.*f.member;
+          if (read(*node, value, errors, path)) {
+            failed = true;
+            return;
+          }
+          if (const char *problem = f.check(value)) {
+            if (errors) errors->push_back(path + ": " + problem);
+            failed = true;
+            return;
+          }
+          out.*f.member = std::move(value);
+        };
+        (one(fields), ...);
+      },
+      ConfigFields<T>::fields());
+  return failed;
+}
+
+//--- Writing
+
+template <typename M>
+auto toNode(const M &value) {
+  if constexpr (isBound<M>::value)
+    return save(value);
+  else if constexpr (isCalendar<M>::value)
+    return value.toToml();
+  else if constexpr (isVector<M>::value) {
+    toml::array array;
+    for (const auto &element : value) array.push_back(toNode(element));
+    return array;
+  } else if constexpr (std::is_same_v<M, bool>)
+    return value;
+  else if constexpr (std::is_integral_v<M>)
+    return static_cast<int64_t>(value);
+  else if constexpr (std::is_floating_point_v<M>)
+    return static_cast<double>(value);
+  else
+    return value;  // strings and toml date/time types
+}
+
+template <typename T>
+toml::table save(const T &value) {
+  static_assert(isBound<T>::value, "T needs a CONFIG_FIELDS list");
+  toml::table table;
+  std::apply(
+      [&](const auto &...fields) {
+        (table.insert_or_assign(std::string_view(fields.name),
+                                toNode(value.*fields.member)),
+         ...);
+      },
+      ConfigFields<T>::fields());
+  return table;
+}
+
+}  // namespace ConfigBinding
+
+#endif  // CONFIGBINDING_H
@@ -0,0 +1,441 @@
+#include "configencoding.h"
+
+namespace {
+
+const char magic[8] = {'G', 'E', 'C', 'F', 'G', 1, 0, 0};
+const size_t headerSize = 16;
+const unsigned int maxDepth = 128;
+
+uint32_t hashKey(std::string_view key) {
+  uint32_t hash = 2166136261u;  // FNV-1a
+  for (char c : key) hash = (hash ^ static_cast<unsigned char>(c)) * 16777619u;
+  return hash;
+}
+
+uint32_t read32(const unsigned char *p) {
+  return static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+         static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24;
+}
+
+//--- Writing
+
+class Writer {
+ public:
+  std::string out;
+
+  uint32_t node(const toml::node &node) {
+    switch (node.type()) {
+      case toml::node_type::table:
+        return table(*node.as_table());
+      case toml::node_type::array: {
+        const toml::array &array = *node.as_array();
+        uint32_t at = begin(node.type(), static_cast<uint32_t>(array.size()));
+        size_t slots = reserve(array.size());
+        for (size_t i = 0; i < array.size(); i++)
+          patch(slots + 4 * i, this->node(*array.get(i)));
+        return at;
+      }
+      case toml::node_type::string:
+        return string(**node.as_string());
+      case toml::node_type::integer:
+        return wide(node.type(), static_cast<uint64_t>(**node.as_integer()));
+      case toml::node_type::floating_point: {
+        double value = **node.as_floating_point();
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return wide(node.type(), bits);
+      }
+      case toml::node_type::boolean:
+        return begin(node.type(), **node.as_boolean());
+      case toml::node_type::date:
+        return begin(node.type(), date(**node.as_date()));
+      case toml::node_type::time: {
+        const toml::time &value = **node.as_time();
+        uint32_t at = begin(node.type(), clock(value));
+        put(value.nanosecond);
+        return at;
+      }
+      case toml::node_type::date_time: {
+        const toml::date_time &value = **node.as_date_time();
+        uint32_t at = begin(node.type(), date(value.date));
+        put(clock(value.time));
+        put(value.time.nanosecond);
+        put(value.offset ? static_cast<uint16_t>(value.offset->minutes) |
+                               1u << 16
+                         : 0);
+        return at;
+      }
+      default:
+        return begin(toml::node_type::none, 0);
+    }
+  }
+
+ private:
+  uint32_t table(const toml::table &table) {
+    uint32_t count = static_cast<uint32_t>(table.size());
+    uint32_t buckets = 1;
+    while (buckets <= count * 2) buckets *= 2;  // always leaves an empty slot
+
+    uint32_t at = begin(toml::node_type::table, count);
+    put(buckets);
+    size_t entries = reserve(2 * size_t(count));
+    size_t index = reserve(2 * size_t(buckets));
+    uint32_t i = 0;
+    for (auto &&[key, value] : table) {
+      patch(entries + 8 * i, string(key));
+      patch(entries + 8 * i + 4, node(value));
+      uint32_t hash = hashKey(key);
+      for (uint32_t slot = hash & (buckets - 1);;
+           slot = (slot + 1) & (buckets - 1)) {
+        size_t bucket = index + 8 * slot;
+        if (read32(bytes() + bucket + 4)) continue;
+        patch(bucket, hash);
+        patch(bucket + 4, i + 1);
+        break;
+      }
+      i++;
+    }
+    return at;
+  }
+  uint32_t string(std::string_view value) {
+    uint32_t at = begin(toml::node_type::string,
+                        static_cast<uint32_t>(value.size()));
+    out.append(value.data(), value.size());
+    out.push_back('\0');
+    return at;
+  }
+  uint32_t wide(toml::node_type type, uint64_t value) {
+    uint32_t at = begin(type, 0);
+    put(static_cast<uint32_t>(value));
+    put(static_cast<uint32_t>(value >> 32));
+    return at;
+  }
+  static uint32_t date(const toml::date &value) {
+    return value.year | static_cast<uint32_t>(value.month) << 16 |
+           static_cast<uint32_t>(value.day) << 24;
+  }
+  static uint32_t clock(const toml::time &value) {
+    return value.hour | static_cast<uint32_t>(value.minute) << 8 |
+           static_cast<uint32_t>(value.second) << 16;
+  }
+
+  const unsigned char *bytes() const {
+    return reinterpret_cast<const unsigned char *>(out.data());
+  }
+  uint32_t begin(toml::node_type type, uint32_t word) {
+    out.resize((out.size() + 3) & ~size_t(3));
+    uint32_t at = static_cast<uint32_t>(out.size());
+    put(static_cast<uint32_t>(type));
+    put(word);
+    return at;
+  }
+  size_t reserve(size_t words) {
+    size_t at = out.size();
+    out.resize(at + 4 * words);
+    return at;
+  }
+  void put(uint32_t value) {
+    out.resize(out.size() + 4);
+    patch(out.size() - 4, value);
+  }
+  void patch(size_t at, uint32_t value) {
+    for (int i = 0; i < 4; i++)
+      out[at + i] = static_cast<char>(value >> (8 * i));
+  }
+};
+
+//--- Checking
+
+// Walks every node once, checking that it lies inside the blob. A valid
+// blob has no shared nodes, so the visit budget also stops crafted ones
+// that reuse nodes from blowing up.
+class Checker {
+ public:
+  Checker(const unsigned char *blob, size_t size)
+      : blob(blob), size(size), budget(size / 8) {}
+
+  bool node(uint32_t at, unsigned int depth, toml::node_type *type = nullptr) {
+    if (at % 4 || at < headerSize || at > size || size - at < 8 ||
+        depth > maxDepth || !budget--)
+      return 0;
+    uint32_t kind = read32(blob + at);
+    uint32_t count = read32(blob + at + 4);
+    if (type) *type = static_cast<toml::node_type>(kind);
+    switch (static_cast<toml::node_type>(kind)) {
+      case toml::node_type::table: {
+        if (!fits(at, 12)) return 0;
+        uint32_t buckets = read32(blob + at + 8);
+        if (buckets <= count || buckets & (buckets - 1) ||
+            !fits(at, 12 + 8 * (uint64_t(count) + buckets)))
+          return 0;
+        const unsigned char *entries = blob + at + 12;
+        for (uint32_t i = 0; i < count; i++) {
+          toml::node_type keyType;
+          if (!node(read32(entries + 8 * i), depth + 1, &keyType) ||
+              keyType != toml::node_type::string ||
+              !node(read32(entries + 8 * i + 4), depth + 1))
+            return 0;
+        }
+        const unsigned char *index = entries + 8 * size_t(count);
+        for (uint32_t b = 0; b < buckets; b++)
+          if (read32(index + 8 * b + 4) > count) return 0;
+        return 1;
+      }
+      case toml::node_type::array:
+        if (!fits(at, 8 + 4 * uint64_t(count))) return 0;
+        for (uint32_t i = 0; i < count; i++)
+          if (!node(read32(blob + at + 8 + 4 * i), depth + 1)) return 0;
+        return 1;
+      case toml::node_type::string:
+        return fits(at, 8 + uint64_t(count) + 1) &&
+               blob[at + 8 + count] == '\0';
+      case toml::node_type::integer:
+      case toml::node_type::floating_point:
+        return fits(at, 16);
+      case toml::node_type::boolean:
+      case toml::node_type::date:
+        return 1;
+      case toml::node_type::time:
+        return fits(at, 12);
+      case toml::node_type::date_time:
+        return fits(at, 20);
+      default:
+        return 0;
+    }
+  }
+
+ private:
+  bool fits(uint32_t at, uint64_t length) const { return length <= size - at; }
+
+  const unsigned char *blob;
+  size_t size;
+  size_t budget;
+};
+
+//--- Decoding
+
+bool rebuild(BinaryConfig::Node node, toml::table &out);
+bool rebuild(BinaryConfig::Node node, toml::array &out);
+
+template <typename Insert>
+bool rebuildValue(BinaryConfig::Node node, Insert insert) {
+  switch (node.type()) {
+    case toml::node_type::table: {
+      toml::table table;
+      if (rebuild(node, table)) return 1;
+      insert(std::move(table));
+      return 0;
+    }
+    case toml::node_type::array: {
+      toml::array array;
+      if (rebuild(node, array)) return 1;
+      insert(std::move(array));
+      return 0;
+    }
+    case toml::node_type::string:
+      insert(*node.value<std::string>());
+      return 0;
+    case toml::node_type::integer:
+      insert(*node.value<int64_t>());
+      return 0;
+    case toml::node_type::floating_point:
+      insert(*node.value<double>());
+      return 0;
+    case toml::node_type::boolean:
+      insert(*node.value<bool>());
+      return 0;
+    case toml::node_type::date:
+      insert(*node.value<toml::date>());
+      return 0;
+    case toml::node_type::time:
+      insert(*node.value<toml::time>());
+      return 0;
+    case toml::node_type::date_time:
+      insert(*node.value<toml::date_time>());
+      return 0;
+    default:
+      return 1;
+  }
+}
+
+bool rebuild(BinaryConfig::Node node, toml::table &out) {
+  for (size_t i = 0; i < node.size(); i++) {
+    std::string_view key = node.keyAt(i);
+    if (rebuildValue(node.valueAt(i), [&](auto &&value) {
+          out.insert(key, std::forward<decltype(value)>(value));
+        }))
+      return 1;
+  }
+  return 0;
+}
+
+bool rebuild(BinaryConfig::Node node, toml::array &out) {
+  out.reserve(node.size());
+  for (size_t i = 0; i < node.size(); i++)
+    if (rebuildValue(node[i], [&](auto &&value) {
+          out.push_back(std::forward<decltype(value)>(value));
+        }))
+      return 1;
+  return 0;
+}
+
+}  // namespace
+
+namespace ConfigEncoding {
+
+bool isEncoded(std::string_view blob) {
+  return blob.size() >= headerSize && !memcmp(blob.data(), magic, 8);
+}
+
+std::string encode(const toml::table &table) {
+  Writer writer;
+  writer.out.assign(magic, sizeof(magic));
+  writer.out.resize(headerSize);
+  uint32_t root = writer.node(table);
+  uint32_t size = static_cast<uint32_t>(writer.out.size());
+  for (int i = 0; i < 4; i++) {
+    writer.out[8 + i] = static_cast<char>(size >> (8 * i));
+    writer.out[12 + i] = static_cast<char>(root >> (8 * i));
+  }
+  return std::move(writer.out);
+}
+
+bool decode(std::string_view blob, toml::table &out) {
+  BinaryConfig config(blob);
+  if (!config.valid()) return 1;
+  out = toml::table();
+  return rebuild(config.root(), out);
+}
+
+}  // namespace ConfigEncoding
+
+//--- BinaryConfig
+
+BinaryConfig::BinaryConfig(std::string_view blob) {
+  if (!ConfigEncoding::isEncoded(blob) || blob.size() > UINT32_MAX) return;
+  const unsigned char *bytes =
+      reinterpret_cast<const unsigned char *>(blob.data());
+  if (read32(bytes + 8) != blob.size()) return;
+  toml::node_type type;
+  if (Checker(bytes, blob.size()).node(read32(bytes + 12), 0, &type) &&
+      type == toml::node_type::table)
+    data = bytes;
+}
+
+BinaryConfig::Node BinaryConfig::root() const {
+  return data ? Node(data, read32(data + 12)) : Node();
+}
+
+BinaryConfig::Node BinaryConfig::find(std::string_view path) const {
+  Node node = root();
+  while (node && !path.empty()) {
+    size_t dot = path.find('.');
+    std::string_view segment = path.substr(0, dot);
+    path = dot == std::string_view::npos ? std::string_view()
+                                         : path.substr(dot + 1);
+    if (node.type() == toml::node_type::array) {
+      size_t index = 0;
+      bool numeric = !segment.empty();
+      for (char c : segment) {
+        if (c < '0' || c > '9') numeric = false;
+        index = index * 10 + static_cast<size_t>(c - '0');
+      }
+      node = numeric ? node[index] : Node();
+    } else
+      node = node[segment];
+  }
+  return node;
+}
+
+uint32_t BinaryConfig::Node::word(size_t index) const {
+  return read32(blob + offset + 4 + 4 * index);
+}
+
+toml::node_type BinaryConfig::Node::type() const {
+  return blob ? static_cast<toml::node_type>(blob[offset])
+              : toml::node_type::none;
+}
+
+size_t BinaryConfig::Node::size() const {
+  toml::node_type kind = type();
+  return kind == toml::node_type::table || kind == toml::node_type::array
+             ? word(0)
+             : 0;
+}
+
+BinaryConfig::Node BinaryConfig::Node::operator[](std::string_view key) const {
+  if (type() != toml::node_type::table) return Node();
+  uint32_t count = word(0), mask = word(1) - 1;
+  uint32_t hash = hashKey(key);
+  // Bounded, as a damaged index might have no empty bucket to stop at.
+  for (uint32_t probe = 0, slot = hash & mask; probe <= mask;
+       probe++, slot = (slot + 1) & mask) {
+    uint32_t entry = word(3 + 2 * size_t(count) + 2 * size_t(slot));
+    if (!entry) break;
+    if (word(2 + 2 * size_t(count) + 2 * size_t(slot)) == hash &&
+        keyAt(entry - 1) == key)
+      return valueAt(entry - 1);
+  }
+  return Node();
+}
+
+BinaryConfig::Node BinaryConfig::Node::operator[](size_t index) const {
+  if (type() != toml::node_type::array || index >= word(0)) return Node();
+  return Node(blob, word(1 + index));
+}
+
+std::string_view BinaryConfig::Node::keyAt(size_t index) const {
+  if (type() != toml::node_type::table || index >= word(0)) return {};
+  return Node(blob, word(2 + 2 * index)).string();
+}
+
+BinaryConfig::Node BinaryConfig::Node::valueAt(size_t index) const {
+  if (type() != toml::node_type::table || index >= word(0)) return Node();
+  return Node(blob, word(3 + 2 * index));
+}
+
+std::string_view BinaryConfig::Node::string() const {
+  return std::string_view(reinterpret_cast<const char *>(blob + offset + 8),
+                          word(0));
+}
+
+int64_t BinaryConfig::Node::integer() const {
+  return static_cast<int64_t>(word(1) | static_cast<uint64_t>(word(2)) << 32);
+}
+
+double BinaryConfig::Node::floating() const {
+  uint64_t bits = word(1) | static_cast<uint64_t>(word(2)) << 32;
+  double value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+toml::date BinaryConfig::Node::date() const {
+  uint32_t packed = word(0);
+  toml::date value;
+  value.year = static_cast<uint16_t>(packed);
+  value.month = static_cast<uint8_t>(packed >> 16);
+  value.day = static_cast<uint8_t>(packed >> 24);
+  return value;
+}
+
+toml::time BinaryConfig::Node::time() const {
+  uint32_t packed = word(type() == toml::node_type::date_time ? 1 : 0);
+  toml::time value;
+  value.hour = static_cast<uint8_t>(packed);
+  value.minute = static_cast<uint8_t>(packed >> 8);
+  value.second = static_cast<uint8_t>(packed >> 16);
+  value.nanosecond = word(type() == toml::node_type::date_time ? 2 : 1);
+  return value;
+}
+
+toml::date_time BinaryConfig::Node::dateTime() const {
+  toml::date_time value{date(), time()};
+  uint32_t offset = word(3);
+  if (offset >> 16) {
+    toml::time_offset zone;
+    zone.minutes = static_cast<int16_t>(offset & 0xffff);
+    value.offset = zone;
+  }
+  return value;
+}
@@ -0,0 +1,126 @@
+#ifndef CONFIGENCODING_H
+#define CONFIGENCODING_H
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "configtypes.h"
+
+// A compact binary form of a toml::table, written at pack time so release
+// builds never lex TOML. Every table carries a hash index, so a key lookup is
+// one hash and usually one probe, straight out of the (possibly mmapped)
+// bytes:
+//
+//   header   "GECFG" 1 0 0, u32 total size, u32 root offset
+//   node     u8 type, 3 bytes padding, u32 count or length, then
+//     table    u32 bucket count, {u32 key, u32 value} x count,
+//              {u32 hash, u32 entry + 1} x buckets
+//     array    {u32 value} x count
+//     string   the bytes and a null terminator
+//     integer  u64, float u64 (IEEE bits), bool in the count
+//     date     in the count; time u32 h/m/s, u32 ns; date_time date, time,
+//              i16 offset minutes, u8 has offset
+//
+// Offsets are from the start of the blob and everything is little-endian,
+// regardless of host. Nodes are 4-byte aligned.
+
+namespace ConfigEncoding {
+
+bool isEncoded(std::string_view blob);
+std::string encode(const toml::table &table);
+// Rebuilds the toml tree, e.g. for a ConfigInterface. Returns 1 if the blob
+// is malformed.
+bool decode(std::string_view blob, toml::table &out);
+
+}  // namespace ConfigEncoding
+
+// Reads an encoded blob in place, without building a tree or allocating.
+// The blob is checked once on construction; if valid() is false every
+// lookup comes back empty.
+class BinaryConfig {
+ public:
+  class Node {
+   public:
+    Node() = default;
+    explicit operator bool() const { return blob != nullptr; }
+    toml::node_type type() const;
+    size_t size() const;  // entries in a table or array; 0 otherwise
+
+    Node operator[](std::string_view key) const;  // tables
+    Node operator[](size_t index) const;          // arrays
+    // The index-th entry of a table, in key order.
+    std::string_view keyAt(size_t index) const;
+    Node valueAt(size_t index) const;
+
+    // Integers (if they fit), floating point, bool, std::string_view (valid
+    // as long as the blob), std::string and toml::date / time / date_time.
+    template <typename T>
+    std::optional<T> value() const;
+
+   private:
+    friend class BinaryConfig;
+    Node(const unsigned char *blob, uint32_t offset)
+        : blob(blob), offset(offset) {}
+    uint32_t word(size_t index) const;  // index-th u32 after the type byte
+    std::string_view string() const;
+    int64_t integer() const;
+    double floating() const;
+    toml::date date() const;
+    toml::time time() const;
+    toml::date_time dateTime() const;
+
+    const unsigned char *blob = nullptr;
+    uint32_t offset = 0;
+  };
+
+  BinaryConfig() = default;
+  explicit BinaryConfig(std::string_view blob);
+  bool valid() const { return data != nullptr; }
+  Node root() const;
+  // Dotted paths, as ConfigInterface::resolve takes them.
+  Node find(std::string_view path) const;
+
+ private:
+  const unsigned char *data = nullptr;
+};
+
+template <typename T>
+std::optional<T> BinaryConfig::Node::value() const {
+  toml::node_type kind = type();
+  if constexpr (std::is_same_v<T, bool>) {
+    if (kind == toml::node_type::boolean) return word(0) != 0;
+  } else if constexpr (std::is_integral_v<T>) {
+    if (kind == toml::node_type::integer) {
+      int64_t value = integer();
+      if constexpr (std::is_signed_v<T>) {
+        if (value >= static_cast<int64_t>(std::numeric_limits<T>::min()) &&
+            value <= static_cast<int64_t>(std::numeric_limits<T>::max()))
+          return static_cast<T>(value);
+      } else if (value >= 0 && static_cast<uint64_t>(value) <=
+                                   std::numeric_limits<T>::max())
+        return static_cast<T>(value);
+    }
+  } else if constexpr (std::is_floating_point_v<T>) {
+    if (kind == toml::node_type::floating_point)
+      return static_cast<T>(floating());
+    if (kind == toml::node_type::integer) return static_cast<T>(integer());
+  } else if constexpr (std::is_same_v<T, std::string_view> ||
+                       std::is_same_v<T, std::string>) {
+    if (kind == toml::node_type::string) return T(string());
+  } else if constexpr (std::is_same_v<T, toml::date>) {
+    if (kind == toml::node_type::date) return date();
+  } else if constexpr (std::is_same_v<T, toml::time>) {
+    if (kind == toml::node_type::time) return time();
+  } else if constexpr (std::is_same_v<T, toml::date_time>) {
+    if (kind == toml::node_type::date_time) return dateTime();
+  } else
+    static_assert(sizeof(T) == 0, "unsupported config value type");
+  return std::nullopt;
+}
+
+#endif  // CONFIGENCODING_H
@@ -1,10 +1,12 @@
 #include "configinterface.h"
 
+#include <fstream>
+
 void ConfigInterface::initialize(toml::parse_result *toml) {}
 
 //--- Section
 
-bool ConfigInterface::beginSection(std::string sectionName) {
+bool ConfigInterface::beginSection(std::string_view sectionName) {
   if (currentSection.empty()) {
     currentSection = sectionName;
     return 0;
@@ -15,31 +17,90 @@ bool ConfigInterface::beginSection(std::string sectionName) {
 void ConfigInterface::endSection() { currentSection = ""; }
 
 std::string ConfigInterface::readValueFromCurrentSection(
-    std::string key, std::string fallback = "invalid") {
+    std::string_view key, const std::string &fallback = "invalid") {
   if (currentSection.empty())
     return fallback;
   else
     return toml[currentSection][key].value_or(fallback);
 }
 
-std::string ConfigInterface::readValueFromSection(std::string key,
-                                                  std::string section,
-                                                  std::string fallback) {
-  std::string tmp = currentSection;
-  endSection();
-  beginSection(section);
-  std::string value = readValueFromCurrentSection(key, fallback);
-  endSection();
-  beginSection(tmp);
-  return value;
+std::string ConfigInterface::readValueFromSection(std::string_view key,
+                                                  std::string_view section,
+                                                  const std::string &fallback) {
+  return toml[section][key].value_or(fallback);
 }
 
-// TODO: make write functions
-
 //--- Non-Section
 
-std::string ConfigInterface::readValue(std::string key, std::string fallback) {
+std::string ConfigInterface::readValue(std::string_view key,
+                                       const std::string &fallback) {
   return toml[key].value_or(fallback);
 }
 
-// TODO: make write functions
+//--- Writing
+
+toml::table *ConfigInterface::makeTable(std::string_view path) {
+  toml::table *table = &toml;
+  while (table && !path.empty()) {
+    size_t dot = path.find('.');
+    std::string_view segment = path.substr(0, dot);
+    path = dot == std::string_view::npos ? std::string_view()
+                                         : path.substr(dot + 1);
+    toml::node *node = table->get(segment);
+    if (!node) node = &table->insert(segment, toml::table()).first->second;
+    table = node->as_table();
+  }
+  return table;
+}
+
+void ConfigInterface::invalidate() {
+  resolved.clear();
+  resolvedPaths.clear();
+  revision++;
+}
+
+bool ConfigInterface::saveToFile(const std::string &pathToFile) const {
+  std::ofstream file(pathToFile);
+  if (!file) return 1;
+  file << toml << "\n";
+  return !file;
+}
+
+//--- Typed access
+
+const toml::node *ConfigInterface::resolve(std::string_view path) {
+  auto cached = resolved.find(path);
+  if (cached != resolved.end()) return cached->second;
+
+  const toml::node *node = find(toml, path);
+  MemoryScope scope(MEMTAG_CONFIG);
+  resolvedPaths.emplace_back(path);
+  resolved.emplace(resolvedPaths.back(), node);
+  return node;
+}
+
+const toml::node *ConfigInterface::find(const toml::node &root,
+                                        std::string_view path) {
+  const toml::node *node = &root;
+  std::string_view rest = path;
+  while (node && !rest.empty()) {
+    size_t dot = rest.find('.');
+    std::string_view segment = rest.substr(0, dot);
+    rest = dot == std::string_view::npos ? std::string_view()
+                                         : rest.substr(dot + 1);
+
+    if (const toml::table *table = node->as_table())
+      node = table->get(segment);
+    else if (const toml::array *array = node->as_array()) {
+      size_t index = 0;
+      bool numeric = !segment.empty();
+      for (char c : segment) {
+        if (c < '0' || c > '9') numeric = false;
+        index = index * 10 + static_cast<size_t>(c - '0');
+      }
+      node = numeric ? array->get(index) : nullptr;
+    } else
+      node = nullptr;
+  }
+  return node;
+}
@@ -1,9 +1,20 @@
 #ifndef CONFIGINTERFACE_H
 #define CONFIGINTERFACE_H
 
+#include <deque>
 #include <filesystem>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
+#include "configbinding.h"
+#include "configencoding.h"
 #include "configtypes.h"
+#include "memory/memorytracker.h"
+
+template <typename T>
+class ConfigValue;
 
 class ConfigInterface {
  private:
@@ -11,26 +22,179 @@ class ConfigInterface {
   std::string currentSection;
   toml::parse_result toml;
 
+  // Dotted paths resolved so far. Keys are views into resolvedPaths, so a
+  // lookup never has to build a std::string.
+  std::unordered_map<std::string_view, const toml::node *> resolved;
+  std::deque<std::string> resolvedPaths;
+  unsigned int revision = 0;  // bumped whenever cached nodes go stale
+
+  toml::table *makeTable(std::string_view path);
+  void invalidate();
+
+  template <typename T>
+  friend class ConfigValue;
+
  public:
   ConfigInterface(std::string pathToFile) {
+    MemoryScope scope(MEMTAG_CONFIG);
     toml = toml::parse_file(pathToFile);
     initialize(&toml);
   }
   ConfigInterface(char *buf) {
+    MemoryScope scope(MEMTAG_CONFIG);
     toml = toml::parse(std::string_view(buf));
     initialize(&toml);
   }
-  bool beginSection(std::string sectionName);
+  // Parses straight out of memory that needn't be null-terminated, such as
+  // Resource::view(); nothing is copied first. `sourceName` is used in error
+  // messages. Documents made by ConfigEncoding::encode are decoded instead,
+  // skipping TOML parsing; a malformed one gives an empty config.
+  ConfigInterface(std::string_view document, std::string_view sourceName) {
+    MemoryScope scope(MEMTAG_CONFIG);
+    if (ConfigEncoding::isEncoded(document)) {
+      toml::table table;
+      ConfigEncoding::decode(document, table);
+      toml = toml::parse_result(std::move(table));
+    } else
+      toml = toml::parse(document, sourceName);
+    initialize(&toml);
+  }
+  // The path cache points into this object's own tree and strings.
+  ConfigInterface(const ConfigInterface &) = delete;
+  ConfigInterface &operator=(const ConfigInterface &) = delete;
+  bool beginSection(std::string_view sectionName);
   void endSection();
-  std::string readValueFromCurrentSection(std::string key,
-                                          std::string fallback);
-  std::string readValueFromSection(std::string key, std::string section,
-                                   std::string fallback);
-  std::string readValue(std::string key, std::string fallback);
-  ~ConfigInterface() { delete &toml; }
+  std::string readValueFromCurrentSection(std::string_view key,
+                                          const std::string &fallback);
+  std::string readValueFromSection(std::string_view key,
+                                   std::string_view section,
+                                   const std::string &fallback);
+  std::string readValue(std::string_view key, const std::string &fallback);
+
+  //--- Typed access
+  // Paths are dotted ("window.width"); a segment made of digits indexes an
+  // array ("spawns.2.x"). Each path is resolved once and cached.
+  const toml::node *resolve(std::string_view path);
+  // The uncached walk behind resolve(), for trees not owned by a
+  // ConfigInterface.
+  static const toml::node *find(const toml::node &root, std::string_view path);
+  const toml::table *getTable(std::string_view path) {
+    const toml::node *node = resolve(path);
+    return node ? node->as_table() : nullptr;
+  }
+  const toml::array *getArray(std::string_view path) {
+    const toml::node *node = resolve(path);
+    return node ? node->as_array() : nullptr;
+  }
+  // Integers, floating point, bool, std::string, std::string_view (valid
+  // while this ConfigInterface is) and toml::date / time / date_time.
+  template <typename T>
+  std::optional<T> get(std::string_view path) {
+    const toml::node *node = resolve(path);
+    return node ? node->value<T>() : std::nullopt;
+  }
+  template <typename T>
+  T get(std::string_view path, T fallback) {
+    std::optional<T> value = get<T>(path);
+    return value ? *std::move(value) : std::move(fallback);
+  }
+  // Elements that can't be converted to T are skipped.
+  template <typename T>
+  std::vector<T> getList(std::string_view path) {
+    std::vector<T> list;
+    if (const toml::array *array = getArray(path)) {
+      list.reserve(array->size());
+      for (const toml::node &element : *array)
+        if (std::optional<T> value = element.value<T>())
+          list.push_back(*std::move(value));
+    }
+    return list;
+  }
+
+  // Binds a path once so hot code can read it every frame without any
+  // lookup; see ConfigValue.
+  template <typename T>
+  ConfigValue<T> bind(std::string_view path, T fallback) {
+    return ConfigValue<T>(this, path, std::move(fallback));
+  }
+
+  //--- Struct binding (see configbinding.h)
+  // Fills `out` from the table at `path` (the root if empty) in one pass.
+  // Returns 1 if anything had the wrong type or failed its check; those
+  // members keep their previous values and `errors` says why.
+  template <typename T>
+  bool load(T &out, std::string_view path = {},
+            std::vector<std::string> *errors = nullptr) {
+    const toml::table *table = path.empty() ? &toml : getTable(path);
+    if (!table) return 0;
+    return ConfigBinding::load(*table, out, errors,
+                               path.empty() ? "" : std::string(path) + ".");
+  }
+  template <typename T>
+  void store(const T &value, std::string_view path = {}) {
+    MemoryScope scope(MEMTAG_CONFIG);
+    toml::table table = ConfigBinding::save(value);
+    if (path.empty()) {
+      for (auto &&[key, node] : table)
+        toml.insert_or_assign(key, std::move(node));
+      invalidate();
+    } else
+      writeValue(path, std::move(table));
+  }
+
+  //--- Writing
+  // Missing tables along `path` are created. Returns 1 if part of the path
+  // exists but isn't a table.
+  template <typename T>
+  bool writeValue(std::string_view path, T value) {
+    MemoryScope scope(MEMTAG_CONFIG);
+    size_t dot = path.rfind('.');
+    toml::table *parent =
+        dot == std::string_view::npos ? &toml : makeTable(path.substr(0, dot));
+    if (!parent) return 1;
+    std::string_view key =
+        dot == std::string_view::npos ? path : path.substr(dot + 1);
+    parent->insert_or_assign(key, ConfigBinding::toNode(value));
+    invalidate();
+    return 0;
+  }
+  bool saveToFile(const std::string &pathToFile) const;  /// Returns 1 on
+                                                         /// failure.
 };
-// TODO: implement all toml types not supported by stdlib; time and dates &
-// abstractions for hashmaps (tables), vectors (arrays)
-// there is no point to having them if they aren't any easier to use than the
-// original; make them friendly
+
+// A config value bound to a path. The converted value is cached and only
+// re-read if the ConfigInterface it came from has changed since, so get() is
+// a comparison and a load.
+template <typename T>
+class ConfigValue {
+ public:
+  ConfigValue() = default;
+  ConfigValue(ConfigInterface *config, std::string_view path, T fallback)
+      : config(config), path(path), fallback(std::move(fallback)) {
+    refresh();
+  }
+
+  const T &get() const {
+    if (config && config->revision != revision) refresh();
+    return value;
+  }
+  operator const T &() const { return get(); }
+  bool isSet() const { return get(), found; }  /// False if using fallback.
+
+ private:
+  void refresh() const {
+    revision = config->revision;
+    std::optional<T> read = config->get<T>(path);
+    found = read.has_value();
+    value = found ? *std::move(read) : fallback;
+  }
+
+  ConfigInterface *config = nullptr;
+  std::string path;
+  T fallback{};
+  mutable T value{};
+  mutable unsigned int revision = 0;
+  mutable bool found = false;
+};
+
 #endif  // CONFIGINTERFACE_H
@@ -0,0 +1,202 @@
+#include "configwatcher.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#include "lib/microtar/microtar.h"
+#include "logger/logger.h"
+#include "metrics/metrics.h"
+
+namespace {
+
+// Returns 1 if the file or pack entry can't be read.
+bool readFile(const std::string &path, std::string &text) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return 1;
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  text = contents.str();
+  return 0;
+}
+bool readPacked(const std::string &pack, const std::string &entry,
+                std::string &text) {
+  mtar_t tar;
+  if (mtar_open(&tar, pack.c_str(), "r") != MTAR_ESUCCESS) return 1;
+  mtar_header_t header;
+  bool failed = mtar_find(&tar, entry.c_str(), &header) != MTAR_ESUCCESS;
+  if (!failed) {
+    text.resize(header.size);
+    failed = mtar_read_data(&tar, text.data(), header.size) != MTAR_ESUCCESS;
+  }
+  mtar_close(&tar);
+  return failed;
+}
+
+}  // namespace
+
+ConfigWatcher::~ConfigWatcher() { clear(); }
+
+void ConfigWatcher::clear() {
+  stop();
+  std::lock_guard<std::mutex> lock(mutex);
+  for (std::unique_ptr<LiveConfig> &config : configs)
+    delete config->snapshot.load();
+  configs.clear();
+}
+
+LiveConfig *ConfigWatcher::watch(const std::string &path) {
+  auto config = std::make_unique<LiveConfig>();
+  config->path = path;
+  return add(std::move(config));
+}
+
+LiveConfig *ConfigWatcher::watchPacked(const std::string &pack,
+                                       const std::string &entry, bool follow) {
+  auto config = std::make_unique<LiveConfig>();
+  config->path = pack;
+  config->entry = entry;
+  config->follow = follow;
+  return add(std::move(config));
+}
+
+LiveConfig *ConfigWatcher::add(std::unique_ptr<LiveConfig> config) {
+  if (reload(*config)) return nullptr;
+  config->notified = 1;  // nobody has subscribed to the first parse yet
+  std::lock_guard<std::mutex> lock(mutex);
+  configs.push_back(std::move(config));
+  return configs.back().get();
+}
+
+bool ConfigWatcher::reload(LiveConfig &config) {
+  MemoryScope scope(MEMTAG_CONFIG);
+  std::error_code error;
+  config.modified = std::filesystem::last_write_time(config.path, error);
+
+  const std::string &name = config.entry.empty() ? config.path : config.entry;
+  std::string text;
+  if (error || (config.entry.empty()
+                    ? readFile(config.path, text)
+                    : readPacked(config.path, config.entry, text))) {
+    ENGINE_LOGF(LOG_WARNING, "Could not read config {} from {}", name,
+                config.source());
+    return 1;
+  }
+
+  auto snapshot = std::make_unique<ConfigSnapshot>();
+  if (ConfigEncoding::isEncoded(text)) {
+    if (ConfigEncoding::decode(text, snapshot->root)) {
+      ENGINE_LOGF(LOG_WARNING, "Malformed binary config {}", config.source());
+      return 1;
+    }
+  } else {
+#if TOML_EXCEPTIONS
+    try {
+      snapshot->root = toml::parse(text, name);
+    } catch (const toml::parse_error &failure) {
+      ENGINE_LOGF(LOG_WARNING, "Could not parse config {}: {}",
+                  config.source(), failure.description());
+      return 1;
+    }
+#else
+    toml::parse_result result = toml::parse(text, name);
+    if (!result) {
+      ENGINE_LOGF(LOG_WARNING, "Could not parse config {}: {}",
+                  config.source(), result.error().description());
+      return 1;
+    }
+    snapshot->root = std::move(result).table();
+#endif
+  }
+
+  const ConfigSnapshot *previous = config.snapshot.load();
+  snapshot->number = previous ? previous->number + 1 : 1;
+  previous = config.snapshot.exchange(snapshot.release(),
+                                      std::memory_order_acq_rel);
+  if (previous) {
+    std::lock_guard<std::mutex> lock(mutex);
+    config.retired.emplace_back(previous);
+  }
+  return 0;
+}
+
+void ConfigWatcher::poll() {
+  static Metrics::Counter &reloads = Metrics::Registry::instance().counter(
+      "config_reloads_total", "Config files reparsed after changing");
+  static Metrics::Counter &failures = Metrics::Registry::instance().counter(
+      "config_reload_failures_total", "Changed config files that didn't parse");
+
+  // Sources are never removed, so the list can be walked without the lock
+  // held; watch() only appends.
+  std::vector<LiveConfig *> sources;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::unique_ptr<LiveConfig> &config : configs)
+      if (config->follow) sources.push_back(config.get());
+  }
+  for (LiveConfig *config : sources) {
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(config->path, error);
+    if (error || modified == config->modified) continue;
+    // A failed parse keeps the last good snapshot; the mtime is recorded
+    // either way so a broken file isn't reparsed until it's saved again.
+    if (reload(*config))
+      failures.add();
+    else
+      reloads.add();
+    config->modified = modified;
+  }
+}
+
+void ConfigWatcher::update() {
+  std::vector<LiveConfig *> changed;
+  std::vector<std::unique_ptr<const ConfigSnapshot>> garbage;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::unique_ptr<LiveConfig> &config : configs) {
+      for (auto &snapshot : config->retired)
+        garbage.push_back(std::move(snapshot));
+      config->retired.clear();
+      if (config->current().revision() != config->notified)
+        changed.push_back(config.get());
+    }
+  }
+  // Subscribers run without the lock so they can watch() more sources.
+  for (LiveConfig *config : changed) {
+    const ConfigSnapshot &snapshot = config->current();
+    config->notified = snapshot.revision();
+    for (LiveConfig::callback &subscriber : config->subscribers)
+      subscriber(snapshot);
+  }
+}
+
+bool ConfigWatcher::start(double intervalSeconds) {
+  if (running.exchange(true)) return 1;
+  interval = intervalSeconds > 0 ? intervalSeconds : 1;
+  worker = std::thread(&ConfigWatcher::run, this);
+  return 0;
+}
+
+void ConfigWatcher::stop() {
+  if (!running.exchange(false)) return;
+  worker.join();
+}
+
+void ConfigWatcher::run() {
+  using clock = std::chrono::steady_clock;
+  auto period = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(interval));
+  auto next = clock::now() + period;
+
+  while (running.load()) {
+    // Wake at least every 100ms so stop() doesn't wait out a long interval.
+    auto now = clock::now();
+    if (now < next) {
+      std::this_thread::sleep_for(std::min<clock::duration>(
+          next - now, std::chrono::milliseconds(100)));
+      continue;
+    }
+    poll();
+    next = clock::now() + period;
+  }
+}
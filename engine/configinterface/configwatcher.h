@@ -0,0 +1,135 @@
+#ifndef CONFIGWATCHER_H
+#define CONFIGWATCHER_H
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "configinterface.h"
+
+// Live configuration. A ConfigWatcher polls config files (or configs inside
+// .grc packs) for changes and reparses them on its own thread. Each parse is
+// published as an immutable ConfigSnapshot through an atomic pointer, so
+// readers never lock or wait:
+//
+//   LiveConfig *server = watcher.watch("server.toml");
+//   watcher.start(0.5);
+//   ...
+//   int limit = server->current().get<int>("players.max", 16);
+//
+// Replaced snapshots are freed by update(), which the owner calls at a safe
+// point (Application does so after every tick), with no grace period. So
+// current() may only be read on the thread that calls update() and in the
+// jobs it runs and waits for between two updates, and a snapshot reference
+// must not be kept across an update(). Threads that run on their own, such
+// as network or audio ones, should copy what they need in a subscriber.
+
+class ConfigSnapshot {
+ public:
+  const toml::table &table() const { return root; }
+  unsigned int revision() const { return number; }  // 1 for the first parse
+
+  const toml::node *resolve(std::string_view path) const {
+    return ConfigInterface::find(root, path);
+  }
+  template <typename T>
+  std::optional<T> get(std::string_view path) const {
+    const toml::node *node = resolve(path);
+    return node ? node->value<T>() : std::nullopt;
+  }
+  template <typename T>
+  T get(std::string_view path, T fallback) const {
+    std::optional<T> value = get<T>(path);
+    return value ? *std::move(value) : std::move(fallback);
+  }
+  // See ConfigInterface::load().
+  template <typename T>
+  bool load(T &out, std::string_view path = {},
+            std::vector<std::string> *errors = nullptr) const {
+    const toml::node *node = path.empty() ? &root : resolve(path);
+    const toml::table *table = node ? node->as_table() : nullptr;
+    if (!table) return 0;
+    return ConfigBinding::load(*table, out, errors,
+                               path.empty() ? "" : std::string(path) + ".");
+  }
+
+ private:
+  friend class ConfigWatcher;
+  toml::table root;
+  unsigned int number = 0;
+};
+
+class LiveConfig {
+ public:
+  using callback = std::function<void(const ConfigSnapshot &)>;
+
+  // Lock-free; see the note above about which threads may call it and how
+  // long the reference lives.
+  const ConfigSnapshot &current() const {
+    return *snapshot.load(std::memory_order_acquire);
+  }
+  // Called from ConfigWatcher::update() whenever a new snapshot has been
+  // published, on the thread that calls update().
+  void subscribe(callback function) {
+    subscribers.push_back(std::move(function));
+  }
+  const std::string &source() const { return path; }
+
+ private:
+  friend class ConfigWatcher;
+
+  std::string path;   // the file on disk; a .grc if entry is set
+  std::string entry;  // file name inside the pack
+  bool follow = true;  // check for changes
+  std::filesystem::file_time_type modified;
+  std::atomic<const ConfigSnapshot *> snapshot{nullptr};
+  std::vector<std::unique_ptr<const ConfigSnapshot>> retired;
+  unsigned int notified = 0;  // revision subscribers last saw
+  std::vector<callback> subscribers;
+};
+
+class ConfigWatcher {
+ public:
+  ~ConfigWatcher();
+
+  // Parses the source now. Returns nullptr if it can't be read or parsed.
+  LiveConfig *watch(const std::string &path);
+  // A config stored in a .grc pack. With `follow` it is reloaded whenever the
+  // pack is rebuilt, which is meant for development; release packs are
+  // embedded or don't change.
+  LiveConfig *watchPacked(const std::string &pack, const std::string &entry,
+                          bool follow);
+
+  bool start(double intervalSeconds);  /// Returns 1 if already running.
+  void stop();
+  // Reparses any changed sources on this thread; for use without start().
+  void poll();
+  // The safe point: notifies subscribers of new snapshots and frees the ones
+  // they replaced.
+  void update();
+  // Stops the thread and frees every config and snapshot, so that none are
+  // left to count as leaks. LiveConfig pointers are invalid afterwards.
+  void clear();
+
+ private:
+  LiveConfig *add(std::unique_ptr<LiveConfig> config);
+  bool reload(LiveConfig &config);  /// Returns 1 if it couldn't be parsed.
+  void run();
+
+  // Guards configs and every LiveConfig's retired list. Readers never take
+  // it; only the watcher thread and update() do.
+  std::mutex mutex;
+  std::vector<std::unique_ptr<LiveConfig>> configs;
+  double interval = 1;
+  std::atomic<bool> running{false};
+  std::thread worker;
+};
+
+#endif  // CONFIGWATCHER_H
@@ -0,0 +1,253 @@
+#ifndef DATETIME_H
+#define DATETIME_H
+
+#include <chrono>
+#include <ctime>
+#include <utility>  // toml++ uses std::exchange without including this
+
+#include "lib/toml++/toml.h"
+
+// Calendar value types that are constexpr, trivially copyable and never
+// allocate. Dates are proleptic Gregorian; all arithmetic goes through a
+// day count from 1970-01-01 rather than ctime.
+
+using DateTimeMilliseconds = std::chrono::duration<long long, std::milli>;
+using DateTimeDays = std::chrono::duration<int, std::ratio<86400>>;
+
+class Time {
+ public:
+  constexpr Time() = default;
+  constexpr Time(int hour, int minute, int second, int millisecond = 0)
+      : h(hour), m(minute), s(second), ms(millisecond) {}
+  // Wraps around midnight in either direction.
+  static constexpr Time fromDuration(DateTimeMilliseconds sinceMidnight) {
+    long long total = sinceMidnight.count() % millisecondsPerDay;
+    if (total < 0) total += millisecondsPerDay;
+    return Time(static_cast<int>(total / 3600000),
+                static_cast<int>(total / 60000 % 60),
+                static_cast<int>(total / 1000 % 60),
+                static_cast<int>(total % 1000));
+  }
+  // Sub-millisecond precision is dropped.
+  static constexpr Time fromToml(const toml::time &time) {
+    return Time(time.hour, time.minute, time.second,
+                static_cast<int>(time.nanosecond / 1000000));
+  }
+
+  void setTime(int hour, int minute, int second, int millisecond) {
+    *this = Time(hour, minute, second, millisecond);
+  }
+  void setCurrentTime() {  // local time
+    time_t now = ::time(nullptr);
+    tm *local = localtime(&now);
+    *this = Time(local->tm_hour, local->tm_min, local->tm_sec);
+  }
+
+  constexpr DateTimeMilliseconds toDuration() const {
+    return DateTimeMilliseconds(((h * 60LL + m) * 60 + s) * 1000 + ms);
+  }
+  constexpr toml::time toToml() const {
+    toml::time time{};
+    time.hour = static_cast<uint8_t>(h);
+    time.minute = static_cast<uint8_t>(m);
+    time.second = static_cast<uint8_t>(s);
+    time.nanosecond = static_cast<uint32_t>(ms) * 1000000;
+    return time;
+  }
+  constexpr bool isValid() const {
+    // 60 seconds allows for a leap second.
+    return h >= 0 && h < 24 && m >= 0 && m < 60 && s >= 0 && s <= 60 &&
+           ms >= 0 && ms < 1000;
+  }
+
+  static constexpr long long millisecondsPerDay = 86400000;
+
+  int h = 0;
+  int m = 0;
+  int s = 0;
+  int ms = 0;
+};
+
+class Date {
+ public:
+  constexpr Date() = default;
+  constexpr Date(int year, int month, int day) : y(year), m(month), d(day) {}
+  // Days since 1970-01-01, which may be negative.
+  static constexpr Date fromDays(DateTimeDays sinceEpoch) {
+    // Howard Hinnant's civil_from_days, for 400-year eras of 146097 days.
+    int z = sinceEpoch.count() + 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    int dayOfEra = z - era * 146097;
+    int yearOfEra =
+        (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+        365;
+    int dayOfYear =
+        dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int shiftedMonth = (5 * dayOfYear + 2) / 153;  // March = 0
+    int day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    int month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+    return Date(yearOfEra + era * 400 + (month <= 2), month, day);
+  }
+  static constexpr Date fromToml(const toml::date &date) {
+    return Date(date.year, date.month, date.day);
+  }
+
+  constexpr DateTimeDays toDays() const {
+    // days_from_civil, the inverse of the above.
+    int year = y - (m <= 2);
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    int dayOfEra =
+        yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return DateTimeDays(era * 146097 + dayOfEra - 719468);
+  }
+  constexpr toml::date toToml() const {
+    toml::date date{};
+    date.year = static_cast<uint16_t>(y);
+    date.month = static_cast<uint8_t>(m);
+    date.day = static_cast<uint8_t>(d);
+    return date;
+  }
+  constexpr int weekday() const {  // 0 = Sunday
+    return (toDays().count() % 7 + 11) % 7;  // 1970-01-01 was a Thursday
+  }
+  static constexpr bool isLeapYear(int year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+  }
+  static constexpr int daysInMonth(int year, int month) {
+    return month == 2 ? 28 + isLeapYear(year)
+                      : 30 + ((month + (month > 7)) & 1);
+  }
+  constexpr bool isValid() const {
+    return m >= 1 && m <= 12 && d >= 1 && d <= daysInMonth(y, m);
+  }
+
+  int y = 1970;
+  int m = 1;
+  int d = 1;
+};
+
+// A date and time of day at some offset from UTC. Comparisons and
+// differences are between the instants they name, so 12:00+01:00 equals
+// 11:00Z.
+class DateTime {
+ public:
+  using clock = std::chrono::system_clock;
+  using timePoint = std::chrono::time_point<clock, DateTimeMilliseconds>;
+
+  constexpr DateTime() = default;
+  constexpr DateTime(Date date, Time time, int offsetMinutes = 0)
+      : date(date), time(time), offset(offsetMinutes) {}
+  static constexpr DateTime fromUnixMilliseconds(long long milliseconds,
+                                                 int offsetMinutes = 0) {
+    long long local = milliseconds + offsetMinutes * 60000LL;
+    long long days = local / Time::millisecondsPerDay;
+    if (local % Time::millisecondsPerDay < 0) days--;
+    return DateTime(Date::fromDays(DateTimeDays(static_cast<int>(days))),
+                    Time::fromDuration(DateTimeMilliseconds(
+                        local - days * Time::millisecondsPerDay)),
+                    offsetMinutes);
+  }
+  // system_clock counts from the Unix epoch on every platform we support,
+  // and from C++20 that is guaranteed.
+  static constexpr DateTime fromChrono(timePoint point,
+                                       int offsetMinutes = 0) {
+    return fromUnixMilliseconds(point.time_since_epoch().count(),
+                                offsetMinutes);
+  }
+  static DateTime now() {  // UTC
+    return fromChrono(
+        std::chrono::time_point_cast<DateTimeMilliseconds>(clock::now()));
+  }
+  // A local date-time (no offset) is taken to be UTC.
+  static constexpr DateTime fromToml(const toml::date_time &dateTime) {
+    return DateTime(Date::fromToml(dateTime.date),
+                    Time::fromToml(dateTime.time),
+                    dateTime.offset ? dateTime.offset->minutes : 0);
+  }
+
+  constexpr long long toUnixMilliseconds() const {
+    return date.toDays().count() * Time::millisecondsPerDay +
+           time.toDuration().count() - offset * 60000LL;
+  }
+  constexpr timePoint toChrono() const {
+    return timePoint(DateTimeMilliseconds(toUnixMilliseconds()));
+  }
+  constexpr toml::date_time toToml() const {
+    toml::time_offset zone;
+    zone.minutes = static_cast<int16_t>(offset);
+    return toml::date_time(date.toToml(), time.toToml(), zone);
+  }
+  // The same instant seen from another offset.
+  constexpr DateTime withOffset(int offsetMinutes) const {
+    return fromUnixMilliseconds(toUnixMilliseconds(), offsetMinutes);
+  }
+  constexpr bool isValid() const { return date.isValid() && time.isValid(); }
+
+  Date date;
+  Time time;
+  int offset = 0;  // minutes east of UTC
+};
+
+//--- Comparisons and arithmetic
+
+constexpr bool operator==(const Time &a, const Time &b) {
+  return a.toDuration() == b.toDuration();
+}
+constexpr bool operator<(const Time &a, const Time &b) {
+  return a.toDuration() < b.toDuration();
+}
+constexpr DateTimeMilliseconds operator-(const Time &a, const Time &b) {
+  return a.toDuration() - b.toDuration();
+}
+constexpr Time operator+(const Time &time, DateTimeMilliseconds change) {
+  return Time::fromDuration(time.toDuration() + change);
+}
+
+constexpr bool operator==(const Date &a, const Date &b) {
+  return a.y == b.y && a.m == b.m && a.d == b.d;
+}
+constexpr bool operator<(const Date &a, const Date &b) {
+  return a.y != b.y ? a.y < b.y : a.m != b.m ? a.m < b.m : a.d < b.d;
+}
+constexpr DateTimeDays operator-(const Date &a, const Date &b) {
+  return a.toDays() - b.toDays();
+}
+constexpr Date operator+(const Date &date, DateTimeDays change) {
+  return Date::fromDays(date.toDays() + change);
+}
+
+constexpr bool operator==(const DateTime &a, const DateTime &b) {
+  return a.toUnixMilliseconds() == b.toUnixMilliseconds();
+}
+constexpr bool operator<(const DateTime &a, const DateTime &b) {
+  return a.toUnixMilliseconds() < b.toUnixMilliseconds();
+}
+constexpr DateTimeMilliseconds operator-(const DateTime &a,
+                                         const DateTime &b) {
+  return DateTimeMilliseconds(a.toUnixMilliseconds() - b.toUnixMilliseconds());
+}
+constexpr DateTime operator+(const DateTime &dateTime,
+                             DateTimeMilliseconds change) {
+  return DateTime::fromUnixMilliseconds(
+      dateTime.toUnixMilliseconds() + change.count(), dateTime.offset);
+}
+
+#define DATETIME_DERIVED_COMPARISONS(Type)                              \
+  constexpr bool operator!=(const Type &a, const Type &b) {             \
+    return !(a == b);                                                   \
+  }                                                                     \
+  constexpr bool operator>(const Type &a, const Type &b) { return b < a; } \
+  constexpr bool operator<=(const Type &a, const Type &b) {             \
+    return !(b < a);                                                    \
+  }                                                                     \
+  constexpr bool operator>=(const Type &a, const Type &b) {             \
+    return !(a < b);                                                    \
+  }
+DATETIME_DERIVED_COMPARISONS(Time)
+DATETIME_DERIVED_COMPARISONS(Date)
+DATETIME_DERIVED_COMPARISONS(DateTime)
+#undef DATETIME_DERIVED_COMPARISONS
+
+#endif  // DATETIME_H
@@ -0,0 +1,106 @@
+#include "commandbuffer.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "memory/memorytracker.h"
+#include "registry.h"
+
+namespace Ecs {
+
+CommandBuffer::~CommandBuffer() {
+  clear();
+  for (page &p : pages) Memory::deallocate(p.data);
+}
+
+Entity CommandBuffer::create() {
+  Entity placeholder{placeholderBit | placeholders++, epoch};
+  record(COMMAND_CREATE, placeholder, 0, nullptr);
+  return placeholder;
+}
+
+void CommandBuffer::apply(Registry &registry) {
+  created.clear();
+  for (command &c : commands) {
+    Entity entity = c.entity;
+    if (entity.index & placeholderBit) {
+      if (c.type == COMMAND_CREATE) {
+        created.push_back(registry.create());
+        continue;
+      }
+      unsigned int index = entity.index & ~placeholderBit;
+      entity = entity.generation == epoch && index < created.size()
+                   ? created[index]
+                   : Entity{};
+    }
+    switch (c.type) {
+      case COMMAND_CREATE:
+        break;
+      case COMMAND_DESTROY:
+        registry.destroy(entity);
+        break;
+      case COMMAND_ADD: {
+        const ComponentInfo &info = componentInfo(c.component);
+        if (void *storage = registry.addComponent(entity, c.component))
+          info.relocate(storage, c.value);
+        else
+          info.destroy(c.value);
+        c.value = nullptr;
+        break;
+      }
+      case COMMAND_REMOVE:
+        registry.removeComponent(entity, c.component);
+        break;
+    }
+  }
+  commands.clear();
+  resetPages();
+}
+
+void CommandBuffer::clear() {
+  for (const command &c : commands)
+    if (c.value) componentInfo(c.component).destroy(c.value);
+  commands.clear();
+  resetPages();
+}
+
+// Values too big for a page get a page of their own size.
+void *CommandBuffer::reserve(size_t size, size_t alignment) {
+  while (currentPage < pages.size()) {
+    page &p = pages[currentPage];
+    size_t base = reinterpret_cast<size_t>(p.data);
+    size_t offset = ((base + used + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + size <= p.size) {
+      used = offset + size;
+      return p.data + offset;
+    }
+    currentPage++;
+    used = 0;
+  }
+  size_t bytes = std::max(pageSize, size);
+  pages.push_back({static_cast<unsigned char *>(Memory::allocate(
+                       bytes, MEMTAG_GAME, std::max<size_t>(alignment, 64))),
+                   bytes});
+  used = size;
+  return pages.back().data;
+}
+
+void CommandBuffer::resetPages() {
+  currentPage = 0;
+  used = 0;
+  placeholders = 0;
+  epoch = nextEpoch();
+}
+
+// Epochs are shared by every buffer, so no two hand out the same
+// placeholder until the counter wraps.
+unsigned int CommandBuffer::nextEpoch() {
+  static std::atomic<unsigned int> epochs{0};
+  unsigned int next;
+  do
+    next = epochs.fetch_add(1, std::memory_order_relaxed) + 1;
+  while (next == 0);  // Handle{} is null
+  return next;
+}
+
+}  // namespace Ecs
@@ -0,0 +1,97 @@
+#ifndef ECS_COMMANDBUFFER_H
+#define ECS_COMMANDBUFFER_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "component.h"
+
+namespace Ecs {
+
+class Registry;
+
+// Structural changes recorded now and made later, for when making them
+// at once would move entities out from under a Query pass. apply() plays
+// them back in the order they were recorded; a change to an entity that
+// is gone by then is skipped. Give each job its own buffer and apply them
+// in a fixed order, and the result won't depend on which thread ran what.
+//
+// Values are moved into pages the buffer keeps between uses, so a buffer
+// used every tick settles at its high-water mark and stops allocating.
+class CommandBuffer {
+ public:
+  CommandBuffer() = default;
+  ~CommandBuffer();
+  CommandBuffer(const CommandBuffer &) = delete;
+  CommandBuffer &operator=(const CommandBuffer &) = delete;
+
+  // A placeholder for an entity made by apply(). It works with the other
+  // commands in this buffer until the buffer is next applied or cleared,
+  // but the registry has never heard of it. Commands given a placeholder
+  // from another buffer, or an old one, are skipped like stale handles.
+  Entity create();
+  void destroy(Entity entity) { record(COMMAND_DESTROY, entity, 0, nullptr); }
+  template <typename T>
+  void add(Entity entity, T value);
+  template <typename T>
+  void remove(Entity entity) {
+    record(COMMAND_REMOVE, entity, componentId<T>(), nullptr);
+  }
+
+  void apply(Registry &registry);
+  void clear();  /// Drops every command without applying it.
+  bool empty() const { return commands.empty(); }
+
+ private:
+  static constexpr size_t pageSize = 16 * 1024;
+  static constexpr unsigned int placeholderBit = 1u << 31;
+
+  enum commandType : unsigned char {
+    COMMAND_CREATE = 0,
+    COMMAND_DESTROY,
+    COMMAND_ADD,
+    COMMAND_REMOVE,
+  };
+  struct command {
+    commandType type;
+    ComponentId component;
+    Entity entity;
+    void *value;  // moved from by apply()
+  };
+  struct page {
+    unsigned char *data;
+    size_t size;
+  };
+
+  void record(commandType type, Entity entity, ComponentId component,
+              void *value) {
+    commands.push_back({type, component, entity, value});
+  }
+  void *reserve(size_t size, size_t alignment);
+  void resetPages();
+  static unsigned int nextEpoch();
+
+  std::vector<command> commands;
+  std::vector<page> pages;
+  size_t currentPage = 0;
+  size_t used = 0;  // of the current page
+  unsigned int placeholders = 0;
+  unsigned int epoch = nextEpoch();  // the generation of its placeholders
+  std::vector<Entity> created;  // scratch for apply()
+};
+
+template <typename T>
+void CommandBuffer::add(Entity entity, T value) {
+  void *storage = reserve(sizeof(T), alignof(T));
+  new (storage) T(std::move(value));
+  record(COMMAND_ADD, entity, componentId<T>(), storage);
+}
+
+}  // namespace Ecs
+
+#endif  // ECS_COMMANDBUFFER_H
@@ -0,0 +1,68 @@
+#ifndef ECS_COMPONENT_H
+#define ECS_COMPONENT_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "memory/objectpool.h"
+
+namespace Ecs {
+
+struct EntityTag;  // only ever named through handles
+using Entity = Handle<EntityTag>;
+
+using ComponentId = unsigned int;
+using ComponentMask = uint64_t;  // bit n set = has component n
+constexpr ComponentId maxComponents = 64;
+
+// What the registry needs to store values of a component type it can't
+// name: their size and alignment, and how to move and destroy them.
+struct ComponentInfo {
+  size_t size;
+  size_t alignment;
+  void (*relocate)(void *to, void *from);  // move-constructs, destroys from
+  void (*destroy)(void *value);
+
+  template <typename T>
+  static ComponentInfo of() {
+    return {sizeof(T), alignof(T),
+            [](void *to, void *from) {
+              T *source = static_cast<T *>(from);
+              new (to) T(std::move(*source));
+              source->~T();
+            },
+            [](void *value) { static_cast<T *>(value)->~T(); }};
+  }
+};
+
+// Ids are handed out on first use, so they differ between runs that touch
+// component types in a different order. Registering more than
+// maxComponents types throws std::length_error. Thread safe.
+ComponentId registerComponent(const ComponentInfo &info);
+const ComponentInfo &componentInfo(ComponentId id);
+
+// Any movable type can be a component; const is ignored.
+template <typename T>
+ComponentId componentId() {
+  if constexpr (std::is_const_v<T>) {
+    return componentId<std::remove_const_t<T>>();
+  } else {
+    static_assert(std::is_move_constructible_v<T>,
+                  "components are moved between chunks");
+    static const ComponentId id = registerComponent(ComponentInfo::of<T>());
+    return id;
+  }
+}
+
+template <typename... Ts>
+ComponentMask maskOf() {
+  return (ComponentMask{0} | ... | (ComponentMask{1} << componentId<Ts>()));
+}
+
+}  // namespace Ecs
+
+#endif  // ECS_COMPONENT_H
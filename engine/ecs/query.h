@@ -0,0 +1,113 @@
+#ifndef ECS_QUERY_H
+#define ECS_QUERY_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "jobs/jobsystem.h"
+#include "registry.h"
+
+namespace Ecs {
+
+// The entities that have all of Ts (and none of `exclude`), e.g.
+//
+//   Ecs::Query<Position, const Velocity> moving(registry);
+//   moving.each([dt](Position &p, const Velocity &v) { p.x += v.x * dt; });
+//
+// The matching archetypes are cached; each pass only checks the archetypes
+// created since the last one, so keep queries around instead of making
+// them per tick. Declaring a component const documents that the pass
+// doesn't write it.
+template <typename... Ts>
+class Query {
+ public:
+  explicit Query(Registry &registry, ComponentMask exclude = 0)
+      : registry(registry), all(maskOf<Ts...>()), exclude(exclude) {}
+
+  // f(size_t count, const Entity *entities, Ts *...arrays) for each chunk,
+  // with one entry per entity in each array. A loop over the arrays is the
+  // place for per-component work to vectorize. With `jobs`, chunks run in
+  // parallel, so f may only touch the chunk it was given.
+  template <typename F>
+  void eachChunk(F &&f, JobSystem *jobs = nullptr);
+  // f(Ts &...values) or f(Entity, Ts &...values) for each entity.
+  template <typename F>
+  void each(F &&f, JobSystem *jobs = nullptr);
+
+  size_t count();
+
+ private:
+  struct chunkRef {
+    uint32_t archetype;
+    uint32_t chunk;
+  };
+
+  void refresh() { registry.match(all, exclude, &archetypes, &seen); }
+
+  Registry &registry;
+  ComponentMask all;
+  ComponentMask exclude;
+  std::vector<uint32_t> archetypes;  // matching, in creation order
+  size_t seen = 0;                   // archetypes checked so far
+  std::vector<chunkRef> chunks;      // scratch for parallel passes
+};
+
+template <typename... Ts>
+template <typename F>
+void Query<Ts...>::eachChunk(F &&f, JobSystem *jobs) {
+  refresh();
+  auto run = [this, &f](uint32_t index, uint32_t chunk) {
+    const Registry::archetype &a = registry.archetypes[index];
+    f(size_t{a.chunkCount(chunk)},
+      static_cast<const Entity *>(a.entities(chunk)),
+      registry.template column<Ts>(index, chunk)...);
+  };
+  if (!jobs) {
+    for (uint32_t index : archetypes) {
+      uint32_t used = registry.archetypes[index].chunksUsed();
+      for (uint32_t chunk = 0; chunk < used; chunk++) run(index, chunk);
+    }
+    return;
+  }
+  chunks.clear();
+  for (uint32_t index : archetypes) {
+    uint32_t used = registry.archetypes[index].chunksUsed();
+    for (uint32_t chunk = 0; chunk < used; chunk++)
+      chunks.push_back({index, chunk});
+  }
+  jobs->parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+      run(chunks[i].archetype, chunks[i].chunk);
+  });
+}
+
+template <typename... Ts>
+template <typename F>
+void Query<Ts...>::each(F &&f, JobSystem *jobs) {
+  eachChunk(
+      [&f](size_t count, const Entity *entities, Ts *...arrays) {
+        for (size_t i = 0; i < count; i++) {
+          if constexpr (std::is_invocable_v<F &, Entity, Ts &...>)
+            f(entities[i], arrays[i]...);
+          else
+            f(arrays[i]...);
+        }
+      },
+      jobs);
+}
+
+template <typename... Ts>
+size_t Query<Ts...>::count() {
+  refresh();
+  size_t total = 0;
+  for (uint32_t index : archetypes) total += registry.archetypes[index].count;
+  return total;
+}
+
+}  // namespace Ecs
+
+#endif  // ECS_QUERY_H
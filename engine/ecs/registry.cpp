@@ -0,0 +1,252 @@
+#include "registry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+
+#include "memory/memorytracker.h"
+
+namespace Ecs {
+
+namespace {
+// Each column starts on its own cache line.
+constexpr size_t columnAlignment = 64;
+
+ComponentInfo infos[maxComponents];
+std::atomic<ComponentId> infoCount{0};
+std::mutex infoMutex;
+
+size_t alignUp(size_t offset, size_t alignment) {
+  return (offset + alignment - 1) & ~(alignment - 1);
+}
+}  // namespace
+
+ComponentId registerComponent(const ComponentInfo &info) {
+  std::lock_guard<std::mutex> lock(infoMutex);
+  ComponentId id = infoCount.load(std::memory_order_relaxed);
+  if (id == maxComponents)
+    throw std::length_error("more than Ecs::maxComponents component types");
+  infos[id] = info;
+  infoCount.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+const ComponentInfo &componentInfo(ComponentId id) { return infos[id]; }
+
+Registry::Registry() { findArchetype(0); }
+
+Registry::~Registry() {
+  clear();
+  for (archetype &a : archetypes)
+    for (unsigned char *chunk : a.chunks) Memory::deallocate(chunk);
+}
+
+//--- Entities
+
+Entity Registry::allocateRecord() {
+  uint32_t index;
+  if (freeRecord != none) {
+    index = freeRecord;
+    freeRecord = records[index].row;
+  } else {
+    index = static_cast<uint32_t>(records.size());
+    records.push_back({0, 0, 1, false});
+  }
+  records[index].live = true;
+  live++;
+  return Entity{index, records[index].generation};
+}
+
+Entity Registry::create() {
+  Entity entity = allocateRecord();
+  records[entity.index].archetype = 0;
+  records[entity.index].row = pushRow(0, entity);
+  return entity;
+}
+
+bool Registry::destroy(Entity entity) {
+  if (!valid(entity)) return 1;
+  record &r = records[entity.index];
+  removeRow(r.archetype, r.row, true);
+  r.live = false;
+  if (++r.generation == 0) r.generation = 1;
+  r.row = freeRecord;
+  freeRecord = entity.index;
+  live--;
+  return 0;
+}
+
+void Registry::clear() {
+  for (size_t i = 0; i < archetypes.size(); i++) {
+    archetype &a = archetypes[i];
+    for (size_t c = 0; c < a.components.size(); c++) {
+      const ComponentInfo &info = componentInfo(a.components[c]);
+      for (uint32_t row = 0; row < a.count; row++)
+        info.destroy(a.at(c, row, info.size));
+    }
+    for (uint32_t row = 0; row < a.count; row++) {
+      Entity entity = a.entities(row / a.capacity)[row % a.capacity];
+      record &r = records[entity.index];
+      r.live = false;
+      if (++r.generation == 0) r.generation = 1;
+      r.row = freeRecord;
+      freeRecord = entity.index;
+    }
+    a.count = 0;
+  }
+  live = 0;
+}
+
+void *Registry::addComponent(Entity entity, ComponentId id) {
+  if (!valid(entity)) return nullptr;
+  record &r = records[entity.index];
+  ComponentMask bit = ComponentMask{1} << id;
+  const ComponentInfo &info = componentInfo(id);
+  if (archetypes[r.archetype].mask & bit) {
+    const archetype &a = archetypes[r.archetype];
+    void *value = a.at(a.column[id], r.row, info.size);
+    info.destroy(value);
+    return value;
+  }
+  uint32_t to = archetypes[r.archetype].addEdge[id];
+  if (to == none) {
+    to = findArchetype(archetypes[r.archetype].mask | bit);
+    archetypes[r.archetype].addEdge[id] = to;
+    archetypes[to].removeEdge[id] = r.archetype;
+  }
+  moveEntity(entity, to);
+  const archetype &a = archetypes[to];
+  return a.at(a.column[id], r.row, info.size);
+}
+
+bool Registry::removeComponent(Entity entity, ComponentId id) {
+  if (!valid(entity)) return 1;
+  record &r = records[entity.index];
+  ComponentMask bit = ComponentMask{1} << id;
+  if (!(archetypes[r.archetype].mask & bit)) return 0;
+  uint32_t to = archetypes[r.archetype].removeEdge[id];
+  if (to == none) {
+    to = findArchetype(archetypes[r.archetype].mask & ~bit);
+    archetypes[r.archetype].removeEdge[id] = to;
+    archetypes[to].addEdge[id] = r.archetype;
+  }
+  moveEntity(entity, to);
+  return 0;
+}
+
+//--- Archetypes
+
+// Lays a chunk out as the entity array followed by one array per component,
+// fitting as many entities into chunkSize as the padding allows. An entity
+// too big for that gets a chunk of its own size.
+uint32_t Registry::findArchetype(ComponentMask mask) {
+  auto found = archetypeIndex.find(mask);
+  if (found != archetypeIndex.end()) return found->second;
+
+  archetype a;
+  a.mask = mask;
+  std::fill(std::begin(a.column), std::end(a.column), 0);
+  std::fill(std::begin(a.addEdge), std::end(a.addEdge), none);
+  std::fill(std::begin(a.removeEdge), std::end(a.removeEdge), none);
+  size_t perEntity = sizeof(Entity);
+  for (ComponentId id = 0; id < maxComponents; id++) {
+    if (!(mask & ComponentMask{1} << id)) continue;
+    a.column[id] = static_cast<unsigned char>(a.components.size());
+    a.components.push_back(id);
+    perEntity += componentInfo(id).size;
+  }
+  size_t padding = columnAlignment * a.components.size();
+  a.capacity = static_cast<uint32_t>(
+      chunkSize > padding + perEntity ? (chunkSize - padding) / perEntity : 1);
+  auto layout = [&a](uint32_t capacity) {
+    size_t offset = sizeof(Entity) * capacity;
+    a.offsets.clear();
+    for (ComponentId id : a.components) {
+      const ComponentInfo &info = componentInfo(id);
+      offset = alignUp(offset, std::max(info.alignment, columnAlignment));
+      a.offsets.push_back(offset);
+      offset += info.size * capacity;
+    }
+    return offset;
+  };
+  // Over-aligned components can pad past the estimate.
+  while (layout(a.capacity) > chunkSize && a.capacity > 1) a.capacity--;
+  a.chunkBytes = std::max(layout(a.capacity), chunkSize);
+
+  uint32_t index = static_cast<uint32_t>(archetypes.size());
+  archetypes.push_back(std::move(a));
+  archetypeIndex.emplace(mask, index);
+  return index;
+}
+
+uint32_t Registry::pushRow(uint32_t index, Entity entity) {
+  archetype &a = archetypes[index];
+  if (a.count == a.chunks.size() * a.capacity) {
+    size_t alignment = columnAlignment;
+    for (ComponentId id : a.components)
+      alignment = std::max(alignment, componentInfo(id).alignment);
+    a.chunks.push_back(static_cast<unsigned char *>(
+        Memory::allocate(a.chunkBytes, MEMTAG_GAME, alignment)));
+  }
+  uint32_t row = a.count++;
+  a.entities(row / a.capacity)[row % a.capacity] = entity;
+  return row;
+}
+
+// Fills the row with the archetype's last entity. A chunk is freed once
+// two are empty, so an entity going back and forth across a chunk boundary
+// doesn't allocate every time.
+void Registry::removeRow(uint32_t index, uint32_t row, bool destroyValues) {
+  archetype &a = archetypes[index];
+  uint32_t last = a.count - 1;
+  for (size_t c = 0; c < a.components.size(); c++) {
+    const ComponentInfo &info = componentInfo(a.components[c]);
+    if (destroyValues) info.destroy(a.at(c, row, info.size));
+    if (row != last)
+      info.relocate(a.at(c, row, info.size), a.at(c, last, info.size));
+  }
+  if (row != last) {
+    Entity moved = a.entities(last / a.capacity)[last % a.capacity];
+    a.entities(row / a.capacity)[row % a.capacity] = moved;
+    records[moved.index].row = row;
+  }
+  a.count--;
+  if (a.count + 2 * a.capacity <= a.chunks.size() * a.capacity) {
+    Memory::deallocate(a.chunks.back());
+    a.chunks.pop_back();
+  }
+}
+
+// Moves the values the archetypes share and destroys the rest; values the
+// new archetype adds are left for the caller to construct.
+void Registry::moveEntity(Entity entity, uint32_t to) {
+  record &r = records[entity.index];
+  uint32_t from = r.archetype, oldRow = r.row;
+  uint32_t row = pushRow(to, entity);
+  const archetype &source = archetypes[from];
+  const archetype &target = archetypes[to];
+  for (size_t c = 0; c < source.components.size(); c++) {
+    ComponentId id = source.components[c];
+    const ComponentInfo &info = componentInfo(id);
+    void *value = source.at(c, oldRow, info.size);
+    if (target.mask & ComponentMask{1} << id)
+      info.relocate(target.at(target.column[id], row, info.size), value);
+    else
+      info.destroy(value);
+  }
+  removeRow(from, oldRow, false);
+  r.archetype = to;
+  r.row = row;
+}
+
+void Registry::match(ComponentMask all, ComponentMask exclude,
+                     std::vector<uint32_t> *matching, size_t *seen) const {
+  for (; *seen < archetypes.size(); ++*seen) {
+    ComponentMask mask = archetypes[*seen].mask;
+    if ((mask & all) == all && !(mask & exclude))
+      matching->push_back(static_cast<uint32_t>(*seen));
+  }
+}
+
+}  // namespace Ecs
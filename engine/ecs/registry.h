@@ -0,0 +1,176 @@
+#ifndef ECS_REGISTRY_H
+#define ECS_REGISTRY_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "component.h"
+
+namespace Ecs {
+
+template <typename... Ts>
+class Query;
+class CommandBuffer;
+
+// Entities and their components, stored by archetype: every entity with
+// exactly the same set of component types shares one, and an archetype
+// keeps its entities in fixed-size chunks with one array per component.
+// Walking a component across a chunk is a walk down a plain array, which
+// is what Query hands out.
+//
+// Entities are generational handles, so a destroyed entity's handle goes
+// stale instead of naming whatever reuses its slot. Adding or removing a
+// component moves the entity to another archetype, and destroying one
+// fills its row with the archetype's last entity, so pointers from get()
+// and a Query's arrays only last until the next change of that kind. While
+// iterating, record such changes in a CommandBuffer and apply them after.
+// Not thread safe.
+class Registry {
+ public:
+  static constexpr size_t chunkSize = 16 * 1024;
+
+  Registry();
+  ~Registry();
+  Registry(const Registry &) = delete;
+  Registry &operator=(const Registry &) = delete;
+
+  Entity create();
+  // Creates the entity straight into its archetype with these components,
+  // which must be of different types.
+  template <typename... Ts>
+  Entity create(Ts &&...values);
+  bool destroy(Entity entity);  /// Returns 1 if the handle is stale.
+  bool valid(Entity entity) const {
+    return entity.index < records.size() && records[entity.index].live &&
+           records[entity.index].generation == entity.generation;
+  }
+
+  // Replaces the value if the entity already has a T.
+  template <typename T>
+  bool add(Entity entity, T value);  /// Returns 1 if the handle is stale.
+  template <typename T>
+  bool remove(Entity entity) {  /// Returns 1 if the handle is stale.
+    return removeComponent(entity, componentId<T>());
+  }
+  template <typename T>
+  bool has(Entity entity) const {
+    return valid(entity) &&
+           (archetypes[records[entity.index].archetype].mask &
+            ComponentMask{1} << componentId<T>());
+  }
+  // nullptr if the handle is stale or the entity has no T.
+  template <typename T>
+  T *get(Entity entity);
+
+  size_t size() const { return live; }
+  size_t archetypeCount() const { return archetypes.size(); }
+  void clear();  /// Destroys every entity; outstanding handles go stale.
+
+ private:
+  template <typename... Ts>
+  friend class Query;
+  friend class CommandBuffer;
+
+  static constexpr uint32_t none = ~0u;
+
+  struct record {
+    uint32_t archetype;
+    uint32_t row;  // or the next free record
+    uint32_t generation;
+    bool live;
+  };
+  struct archetype {
+    ComponentMask mask;
+    std::vector<ComponentId> components;  // ascending
+    unsigned char column[maxComponents];  // index into components
+    std::vector<size_t> offsets;  // of each component's array in a chunk
+    uint32_t capacity;            // entities per chunk
+    size_t chunkBytes;
+    std::vector<unsigned char *> chunks;  // entities first, then columns
+    uint32_t count = 0;
+    uint32_t addEdge[maxComponents];  // archetypes one component away
+    uint32_t removeEdge[maxComponents];
+
+    unsigned char *at(size_t column, uint32_t row, size_t size) const {
+      return chunks[row / capacity] + offsets[column] + row % capacity * size;
+    }
+    Entity *entities(size_t chunk) const {
+      return reinterpret_cast<Entity *>(chunks[chunk]);
+    }
+    uint32_t chunksUsed() const { return (count + capacity - 1) / capacity; }
+    uint32_t chunkCount(size_t chunk) const {
+      size_t first = chunk * capacity;
+      return count - first < capacity ? static_cast<uint32_t>(count - first)
+                                       : capacity;
+    }
+  };
+
+  uint32_t findArchetype(ComponentMask mask);
+  uint32_t pushRow(uint32_t archetype, Entity entity);
+  void removeRow(uint32_t archetype, uint32_t row, bool destroyValues);
+  void moveEntity(Entity entity, uint32_t to);
+  Entity allocateRecord();
+  // Storage for the entity's value of the component: uninitialized, since
+  // any old value is destroyed. nullptr if the handle is stale.
+  void *addComponent(Entity entity, ComponentId id);
+  bool removeComponent(Entity entity, ComponentId id);
+  // Appends archetypes created since the last call to those matching.
+  void match(ComponentMask all, ComponentMask exclude,
+             std::vector<uint32_t> *matching, size_t *seen) const;
+  template <typename T>
+  T *column(uint32_t index, size_t chunk) {
+    const archetype &a = archetypes[index];
+    return std::launder(reinterpret_cast<T *>(
+        a.chunks[chunk] + a.offsets[a.column[componentId<T>()]]));
+  }
+
+  std::vector<archetype> archetypes;  // the first has no components
+  std::unordered_map<ComponentMask, uint32_t> archetypeIndex;
+  std::vector<record> records;
+  uint32_t freeRecord = none;
+  size_t live = 0;
+};
+
+template <typename... Ts>
+Entity Registry::create(Ts &&...values) {
+  Entity entity = allocateRecord();
+  uint32_t index = findArchetype(maskOf<std::decay_t<Ts>...>());
+  uint32_t row = pushRow(index, entity);
+  records[entity.index].archetype = index;
+  records[entity.index].row = row;
+  const archetype &a = archetypes[index];
+  (new (a.at(a.column[componentId<std::decay_t<Ts>>()], row,
+             sizeof(std::decay_t<Ts>)))
+       std::decay_t<Ts>(std::forward<Ts>(values)),
+   ...);
+  return entity;
+}
+
+template <typename T>
+bool Registry::add(Entity entity, T value) {
+  void *storage = addComponent(entity, componentId<T>());
+  if (!storage) return 1;
+  new (storage) T(std::move(value));
+  return 0;
+}
+
+template <typename T>
+T *Registry::get(Entity entity) {
+  if (!valid(entity)) return nullptr;
+  const record &r = records[entity.index];
+  const archetype &a = archetypes[r.archetype];
+  ComponentId id = componentId<T>();
+  if (!(a.mask & ComponentMask{1} << id)) return nullptr;
+  return std::launder(
+      reinterpret_cast<T *>(a.at(a.column[id], r.row, sizeof(T))));
+}
+
+}  // namespace Ecs
+
+#endif  // ECS_REGISTRY_H
@@ -13,10 +13,6 @@
  * - resource creation tool (microtar and tinyxml; create tar from xml)
  * - incbin MSVC prereq tool
  * - implement above 2 into build system automation
- *
- * - extensive math implementation, libmvec/linalg
- *    - vector math/linear algebra
- *    - trig for common 2d ops
  */
 
 #endif // GAMEENGINE_H
@@ -0,0 +1,64 @@
+#include "jobsystem.h"
+
+#include <algorithm>
+
+void JobSystem::start(int workers) {
+  stop();
+  if (workers < 0) {
+    unsigned int cores = std::thread::hardware_concurrency();
+    workers = cores > 1 ? static_cast<int>(cores - 1) : 0;
+  }
+  stopping = false;
+  for (int i = 0; i < workers; i++)
+    threads.emplace_back(&JobSystem::work, this);
+}
+
+void JobSystem::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wake.notify_all();
+  for (std::thread &t : threads) t.join();
+  threads.clear();
+}
+
+void JobSystem::drain(batch &b) {
+  size_t begin;
+  while ((begin = b.next.fetch_add(b.grain, std::memory_order_relaxed)) <
+         b.count)
+    b.run(b.context, begin, std::min(begin + b.grain, b.count));
+}
+
+void JobSystem::submit(batch &b) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = &b;
+    generation++;
+  }
+  wake.notify_all();
+  drain(b);
+  // Every chunk has been claimed. Wait for workers still running theirs,
+  // and make sure none that wakes late can see the batch, which is about
+  // to go out of scope.
+  std::unique_lock<std::mutex> lock(mutex);
+  idle.wait(lock, [this] { return busy == 0; });
+  current = nullptr;
+}
+
+void JobSystem::work() {
+  unsigned long long seen = 0;
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [&] { return stopping || generation != seen; });
+    if (stopping) return;
+    seen = generation;
+    batch *b = current;
+    if (!b) continue;
+    busy++;
+    lock.unlock();
+    drain(*b);
+    lock.lock();
+    if (--busy == 0) idle.notify_one();
+  }
+}
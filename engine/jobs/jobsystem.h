@@ -0,0 +1,76 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of worker threads for splitting one loop at a time across
+// cores, fork-join style: parallelFor hands out chunks of the range to the
+// workers and the calling thread alike and returns once all are done.
+// Chunks are claimed from a shared counter, so uneven work balances itself.
+//
+// With no workers started, parallelFor runs the loop on the calling thread.
+// One thread submits at a time, and a body must not call parallelFor.
+class JobSystem {
+ public:
+  JobSystem() = default;
+  ~JobSystem() { stop(); }
+  JobSystem(const JobSystem &) = delete;
+  JobSystem &operator=(const JobSystem &) = delete;
+
+  // Threads besides the caller's; a negative count means one per core
+  // after the first.
+  void start(int workers);
+  void stop();
+  unsigned int workerCount() const {
+    return static_cast<unsigned int>(threads.size());
+  }
+
+  // body(begin, end) over [0, count) in chunks of `grain` indices.
+  template <typename F>
+  void parallelFor(size_t count, size_t grain, F &&body) {
+    if (!count) return;
+    if (threads.empty() || count <= grain) {
+      body(size_t{0}, count);
+      return;
+    }
+    using function = std::remove_reference_t<F>;
+    batch b;
+    b.run = [](void *context, size_t begin, size_t end) {
+      (*static_cast<function *>(context))(begin, end);
+    };
+    b.context = const_cast<void *>(static_cast<const void *>(&body));
+    b.count = count;
+    b.grain = grain ? grain : 1;
+    submit(b);
+  }
+
+ private:
+  struct batch {
+    void (*run)(void *context, size_t begin, size_t end);
+    void *context;
+    size_t count;
+    size_t grain;
+    std::atomic<size_t> next{0};
+  };
+
+  void submit(batch &b);
+  void work();
+  static void drain(batch &b);
+
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable wake;  // workers: a batch or stop
+  std::condition_variable idle;  // submitter: the last worker finished
+  batch *current = nullptr;
+  unsigned long long generation = 0;  // bumped for every batch
+  unsigned int busy = 0;              // workers inside a batch
+  bool stopping = false;
+};
+
+#endif  // JOBSYSTEM_H
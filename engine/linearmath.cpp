@@ -1,3 +1 @@
 #include "linearmath.h"
-
-// TODO: create simple linalg & trig libs
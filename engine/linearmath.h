@@ -2,8 +2,15 @@
 #define LINEARMATH_H
 
 #include <math.h>
-#include <random>
 
-namespace LinearMath {}; // namespace LinearMath
+#include "linearmath/batch.h"
+#include "linearmath/fixed.h"
+#include "linearmath/geometry.h"
+#include "linearmath/matrix.h"
+#include "linearmath/quaternion.h"
+#include "linearmath/random.h"
+#include "linearmath/real.h"
+#include "linearmath/trig.h"
+#include "linearmath/vector.h"
 
 #endif // LINEARMATH_H
@@ -0,0 +1,115 @@
+// No include guard: included once per lane width, by trig.h for one lane
+// and by batchkernels.h for the SIMD levels. The including namespace
+// provides F and Mask (see batch.cpp) and BATCH_INLINE.
+//
+// Cephes-style polynomials after Cody-Waite range reduction. Error bounds
+// are documented with the public functions in trig.h.
+
+BATCH_INLINE F flipSign(F v) { return v ^ F::setBits(0x80000000u); }
+
+// Adding 1.5 * 2^23 leaves no bits for a fraction, so the sum is rounded to
+// a whole number with k in its low mantissa bits. Needs |v| < 2^22, and
+// breaks under -ffast-math, which would cancel the constant out.
+BATCH_INLINE F roundingMagic() { return F::set(12582912); }
+BATCH_INLINE F roundSmall(F v) {
+  return (v + roundingMagic()) - roundingMagic();
+}
+
+// Sine and cosine together; they share the range reduction.
+BATCH_INLINE void sinCos(F x, F *sine, F *cosine) {
+  // k quarter turns to take off, kept with the rounding constant so its
+  // low bits give the quadrant. x is reduced to [-pi/4, pi/4] with pi/2
+  // split in three so k * part is exact for |k| below 2^12 or so.
+  F turns = x * F::set(0.636619772f) + roundingMagic();
+  F k = turns - roundingMagic();
+  F quadrant = bitsAsNumber(turns & F::setBits(3));  // k mod 4
+  F r = x - k * F::set(1.5703125f);
+  r = r - k * F::set(4.837512969970703125e-4f);
+  r = r - k * F::set(7.54978995489188216e-8f);
+  F z = r * r;
+
+  F s = F::set(-1.9515295891e-4f);
+  s = s * z + F::set(8.3321608736e-3f);
+  s = s * z + F::set(-1.6666654611e-1f);
+  s = s * z * r + r;
+  F c = F::set(2.443315711809948e-5f);
+  c = c * z + F::set(-1.388731625493765e-3f);
+  c = c * z + F::set(4.166664568298827e-2f);
+  c = c * z * z - F::set(0.5f) * z + F::set(1);
+
+  Mask odd = bitsAsNumber(turns & F::setBits(1)) > F::set(0.5f);
+  F sinValue = select(odd, c, s), cosValue = select(odd, s, c);
+  *sine = select(quadrant > F::set(1.5f), flipSign(sinValue), sinValue);
+  *cosine = select(abs(quadrant - F::set(1.5f)) < F::set(1),
+                   flipSign(cosValue), cosValue);
+}
+
+BATCH_INLINE F atan2(F y, F x) {
+  F ax = abs(x), ay = abs(y);
+  // The ratio is in [0, 1]; (0, 0) gives 0 rather than 0 / 0.
+  F a = min(ax, ay) / max(max(ax, ay), F::set(1.17549435e-38f));
+  Mask high = a > F::set(0.414213562f);  // tan(pi / 8)
+  F t = select(high, (a - F::set(1)) / (a + F::set(1)), a);
+  F z = t * t;
+
+  F r = F::set(8.05374449538e-2f);
+  r = r * z + F::set(-1.38776856032e-1f);
+  r = r * z + F::set(1.99777106478e-1f);
+  r = r * z + F::set(-3.33329491539e-1f);
+  r = r * z * t + t + select(high, F::set(0.785398163f), F::set(0));
+
+  r = select(ay > ax, F::set(1.570796327f) - r, r);
+  r = select(x < F::set(0), F::set(3.141592654f) - r, r);
+  return (r & F::setBits(0x7fffffffu)) | (y & F::setBits(0x80000000u));
+}
+
+BATCH_INLINE F exp(F x) {
+  F clamped = min(max(x, F::set(-87.3365448f)), F::set(88.7228391f));
+  // x = n ln2 + r. 2^n only goes to 127, so at the very top r reaches ln2,
+  // which the polynomial still covers to a few ulp.
+  F n = min(roundSmall(clamped * F::set(1.44269504089f)), F::set(127));
+  F r = clamped - n * F::set(0.693359375f);
+  r = r - n * F::set(-2.12194440e-4f);
+
+  F p = F::set(1.9875691500e-4f);
+  p = p * r + F::set(1.3981999507e-3f);
+  p = p * r + F::set(8.3334519073e-3f);
+  p = p * r + F::set(4.1665795894e-2f);
+  p = p * r + F::set(1.6666665459e-1f);
+  p = p * r + F::set(5.0000001201e-1f);
+  p = p * r * r + r + F::set(1);
+
+  F result = p * floatWithBits((n + F::set(127)) * F::set(8388608));
+  result = select(x > F::set(88.7228391f), F::setBits(0x7f800000u), result);
+  return select(x < F::set(-87.3365448f), F::set(0), result);
+}
+
+BATCH_INLINE F log(F x) {
+  // x = m 2^e with m in [sqrt(1/2), sqrt(2)), then log(m) near 1.
+  F e = bitsAsNumber(x & F::setBits(0x7f800000u)) * F::set(1.0f / 8388608) -
+        F::set(127);
+  F m = (x & F::setBits(0x007fffffu)) | F::setBits(0x3f800000u);
+  Mask high = m > F::set(1.414213562f);
+  m = select(high, m * F::set(0.5f), m);
+  e = select(high, e + F::set(1), e);
+  F f = m - F::set(1);
+  F z = f * f;
+
+  F y = F::set(7.0376836292e-2f);
+  y = y * f + F::set(-1.1514610310e-1f);
+  y = y * f + F::set(1.1676998740e-1f);
+  y = y * f + F::set(-1.2420140846e-1f);
+  y = y * f + F::set(1.4249322787e-1f);
+  y = y * f + F::set(-1.6668057665e-1f);
+  y = y * f + F::set(2.0000714765e-1f);
+  y = y * f + F::set(-2.4999993993e-1f);
+  y = y * f + F::set(3.3333331174e-1f);
+  y = y * f * z + e * F::set(-2.12194440e-4f) - F::set(0.5f) * z;
+  F result = f + y + e * F::set(0.693359375f);
+
+  // Subnormals are taken as 0, negatives give NaN and +inf stays +inf.
+  result = select(x < F::set(1.17549435e-38f), F::setBits(0xff800000u),
+                  result);
+  result = select(x < F::set(0), F::setBits(0x7fc00000u), result);
+  return select(x > F::set(3.40282347e38f), x, result);
+}
@@ -0,0 +1,615 @@
+#include "batch.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "random.h"
+#include "scalarlane.h"
+
+// SSE2 is the x86-64 baseline and needs no dispatch. AVX and AVX-512 are
+// compiled per function with target attributes and chosen at runtime, which
+// needs GCC or Clang; other compilers stop at SSE2.
+#if LINEARMATH_SSE2 && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define BATCH_DISPATCH 1
+#include <immintrin.h>
+#else
+#define BATCH_DISPATCH 0
+#endif
+
+// Keep the compiler from fusing multiply-adds in the FMA-capable AVX-512
+// builds, so that every level rounds exactly like the scalar one.
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+namespace LinearMath {
+namespace Batch {
+
+namespace {
+
+struct Kernels {
+  size_t (*transformPoints2)(const Mat3 &, Points2, Points2, size_t);
+  size_t (*transformPoints3)(const Mat4 &, Points3, Points3, size_t);
+  size_t (*integrate2)(Points2, Points2, float, size_t);
+  size_t (*integrate3)(Points3, Points3, float, size_t);
+  size_t (*normalize2)(Points2, size_t);
+  size_t (*normalize3)(Points3, size_t);
+  size_t (*transformBounds2)(const Mat3 &, Bounds2, Bounds2, size_t);
+  size_t (*transformBounds3)(const Mat4 &, Bounds3, Bounds3, size_t);
+  size_t (*sinCos)(const float *, float *, float *, size_t);
+  size_t (*atan2)(const float *, const float *, float *, size_t);
+  size_t (*exp)(const float *, float *, size_t);
+  size_t (*log)(const float *, float *, size_t);
+  size_t (*rotate)(Points2, const float *, Points2, size_t);
+  // Fills out with whole rounds of Random::lanes outputs; no tail.
+  void (*randomBits)(uint32_t (*)[Random::lanes], uint32_t *, size_t);
+  size_t (*uniform)(const uint32_t *, float, float, float *, size_t);
+  size_t (*normal)(const uint32_t *, const uint32_t *, float, float, float *,
+                   float *, size_t);
+  size_t (*inCircle)(const uint32_t *, const uint32_t *, Points2, size_t);
+  size_t (*onSphere)(const uint32_t *, const uint32_t *, Points3, size_t);
+  size_t (*raycastBoxes)(const Ray &, float, Bounds2, float *, size_t);
+  // These also take the index of the first element and add what they find
+  // to *found.
+  size_t (*overlapBoxes)(const Aabb &, Bounds2, uint32_t, uint32_t *,
+                         size_t *, size_t);
+  size_t (*overlapCircles)(const Circle &, Points2, const float *, uint32_t,
+                           uint32_t *, size_t *, size_t);
+};
+
+//--- Scalar
+
+namespace Scalar {
+#define BATCH_TARGET
+#define BATCH_INLINE inline
+using namespace ScalarLane;
+
+void randomBits(uint32_t (*state)[Random::lanes], uint32_t *out,
+                size_t rounds) {
+  for (int lane = 0; lane < Random::lanes; lane++) {
+    Xoshiro128Plus g;
+    for (int word = 0; word < 4; word++) g.s[word] = state[word][lane];
+    for (size_t round = 0; round < rounds; round++)
+      out[round * Random::lanes + lane] = g.next();
+    for (int word = 0; word < 4; word++) state[word][lane] = g.s[word];
+  }
+}
+
+#include "batchkernels.h"
+#undef BATCH_TARGET
+#undef BATCH_INLINE
+}  // namespace Scalar
+
+//--- SSE2
+
+#if LINEARMATH_SSE2
+namespace Sse2 {
+#define BATCH_TARGET
+#define BATCH_INLINE inline
+
+struct F {
+  static constexpr size_t width = 4;
+  static F load(const float *p) { return {_mm_loadu_ps(p)}; }
+  static F set(float s) { return {_mm_set1_ps(s)}; }
+  static F loadBits(const uint32_t *p) {
+    return {_mm_loadu_ps(reinterpret_cast<const float *>(p))};
+  }
+  static F setBits(uint32_t bits) {
+    return {_mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(bits)))};
+  }
+  void store(float *p) const { _mm_storeu_ps(p, v); }
+  __m128 v;
+};
+using Mask = F;
+
+inline F operator+(F a, F b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F operator-(F a, F b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F operator*(F a, F b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline F operator/(F a, F b) { return {_mm_div_ps(a.v, b.v)}; }
+inline F operator&(F a, F b) { return {_mm_and_ps(a.v, b.v)}; }
+inline F operator|(F a, F b) { return {_mm_or_ps(a.v, b.v)}; }
+inline F operator^(F a, F b) { return {_mm_xor_ps(a.v, b.v)}; }
+inline Mask operator<(F a, F b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline Mask operator>(F a, F b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline Mask operator<=(F a, F b) { return {_mm_cmple_ps(a.v, b.v)}; }
+inline Mask operator>=(F a, F b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+inline unsigned maskBits(Mask m) { return _mm_movemask_ps(m.v); }
+inline F select(Mask m, F ifTrue, F ifFalse) {
+  return {_mm_or_ps(_mm_and_ps(m.v, ifTrue.v), _mm_andnot_ps(m.v, ifFalse.v))};
+}
+inline F abs(F a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline F min(F a, F b) { return {_mm_min_ps(a.v, b.v)}; }
+inline F max(F a, F b) { return {_mm_max_ps(a.v, b.v)}; }
+inline F sqrt(F a) { return {_mm_sqrt_ps(a.v)}; }
+inline F safeInverseSqrt(F s) {
+  F one = F::set(1);
+  return select(s > F::set(0), one / F{_mm_sqrt_ps(s.v)}, one);
+}
+inline F floatWithBits(F a) { return {_mm_castsi128_ps(_mm_cvtps_epi32(a.v))}; }
+inline F bitsAsNumber(F a) { return {_mm_cvtepi32_ps(_mm_castps_si128(a.v))}; }
+
+// Four generators at a time; also used by the AVX level, since AVX1 has no
+// 256-bit integer operations.
+void randomBits(uint32_t (*state)[Random::lanes], uint32_t *out,
+                size_t rounds) {
+  for (int lane = 0; lane < Random::lanes; lane += 4) {
+    __m128i s[4];
+    for (int word = 0; word < 4; word++)
+      s[word] = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(state[word] + lane));
+    for (size_t round = 0; round < rounds; round++) {
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i *>(out + round * Random::lanes + lane),
+          _mm_add_epi32(s[0], s[3]));
+      __m128i t = _mm_slli_epi32(s[1], 9);
+      s[2] = _mm_xor_si128(s[2], s[0]);
+      s[3] = _mm_xor_si128(s[3], s[1]);
+      s[1] = _mm_xor_si128(s[1], s[2]);
+      s[0] = _mm_xor_si128(s[0], s[3]);
+      s[2] = _mm_xor_si128(s[2], t);
+      s[3] = _mm_or_si128(_mm_slli_epi32(s[3], 11), _mm_srli_epi32(s[3], 21));
+    }
+    for (int word = 0; word < 4; word++)
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(state[word] + lane),
+                       s[word]);
+  }
+}
+
+#include "approx.h"
+#include "batchkernels.h"
+#undef BATCH_TARGET
+#undef BATCH_INLINE
+}  // namespace Sse2
+#endif
+
+//--- AVX
+
+#if BATCH_DISPATCH
+namespace Avx {
+// A helper GCC leaves out of line returns its F in ymm0 and then clears
+// the upper half with vzeroupper on the way out, so they are all forced
+// inline; the same goes for AVX-512 below.
+#define BATCH_TARGET __attribute__((target("avx")))
+#define BATCH_INLINE BATCH_TARGET inline __attribute__((always_inline))
+
+struct F {
+  static constexpr size_t width = 8;
+  BATCH_INLINE static F load(const float *p) { return {_mm256_loadu_ps(p)}; }
+  BATCH_INLINE static F set(float s) { return {_mm256_set1_ps(s)}; }
+  BATCH_INLINE static F loadBits(const uint32_t *p) {
+    return {_mm256_loadu_ps(reinterpret_cast<const float *>(p))};
+  }
+  BATCH_INLINE static F setBits(uint32_t bits) {
+    return {_mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(bits)))};
+  }
+  BATCH_INLINE void store(float *p) const { _mm256_storeu_ps(p, v); }
+  __m256 v;
+};
+using Mask = F;
+
+BATCH_INLINE F operator+(F a, F b) { return {_mm256_add_ps(a.v, b.v)}; }
+BATCH_INLINE F operator-(F a, F b) { return {_mm256_sub_ps(a.v, b.v)}; }
+BATCH_INLINE F operator*(F a, F b) { return {_mm256_mul_ps(a.v, b.v)}; }
+BATCH_INLINE F operator/(F a, F b) { return {_mm256_div_ps(a.v, b.v)}; }
+BATCH_INLINE F operator&(F a, F b) { return {_mm256_and_ps(a.v, b.v)}; }
+BATCH_INLINE F operator|(F a, F b) { return {_mm256_or_ps(a.v, b.v)}; }
+BATCH_INLINE F operator^(F a, F b) { return {_mm256_xor_ps(a.v, b.v)}; }
+BATCH_INLINE Mask operator<(F a, F b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)};
+}
+BATCH_INLINE Mask operator>(F a, F b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)};
+}
+BATCH_INLINE Mask operator<=(F a, F b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)};
+}
+BATCH_INLINE Mask operator>=(F a, F b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};
+}
+BATCH_INLINE unsigned maskBits(Mask m) {
+  return _mm256_movemask_ps(m.v);
+}
+// Not blendv: GCC 12 turns that into per-lane branches without AVX2.
+BATCH_INLINE F select(Mask m, F ifTrue, F ifFalse) {
+  return {_mm256_or_ps(_mm256_and_ps(m.v, ifTrue.v),
+                       _mm256_andnot_ps(m.v, ifFalse.v))};
+}
+BATCH_INLINE F abs(F a) {
+  return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)};
+}
+BATCH_INLINE F min(F a, F b) { return {_mm256_min_ps(a.v, b.v)}; }
+BATCH_INLINE F max(F a, F b) { return {_mm256_max_ps(a.v, b.v)}; }
+BATCH_INLINE F sqrt(F a) { return {_mm256_sqrt_ps(a.v)}; }
+BATCH_INLINE F safeInverseSqrt(F s) {
+  F one = F::set(1);
+  return select(s > F::set(0), one / F{_mm256_sqrt_ps(s.v)}, one);
+}
+BATCH_INLINE F floatWithBits(F a) {
+  return {_mm256_castsi256_ps(_mm256_cvtps_epi32(a.v))};
+}
+BATCH_INLINE F bitsAsNumber(F a) {
+  return {_mm256_cvtepi32_ps(_mm256_castps_si256(a.v))};
+}
+
+using Sse2::randomBits;
+
+#include "approx.h"
+#include "batchkernels.h"
+#undef BATCH_TARGET
+#undef BATCH_INLINE
+}  // namespace Avx
+
+//--- AVX-512
+
+// GCC 12's own AVX-512 headers trip -Wmaybe-uninitialized when inlined.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+namespace Avx512 {
+#define BATCH_TARGET __attribute__((target("avx512f")))
+#define BATCH_INLINE BATCH_TARGET inline __attribute__((always_inline))
+
+struct F {
+  static constexpr size_t width = 16;
+  BATCH_INLINE static F load(const float *p) { return {_mm512_loadu_ps(p)}; }
+  BATCH_INLINE static F set(float s) { return {_mm512_set1_ps(s)}; }
+  BATCH_INLINE static F loadBits(const uint32_t *p) {
+    return {_mm512_loadu_ps(p)};
+  }
+  BATCH_INLINE static F setBits(uint32_t bits) {
+    return {_mm512_castsi512_ps(_mm512_set1_epi32(static_cast<int>(bits)))};
+  }
+  BATCH_INLINE void store(float *p) const { _mm512_storeu_ps(p, v); }
+  BATCH_INLINE __m512i bits() const { return _mm512_castps_si512(v); }
+  __m512 v;
+};
+using Mask = __mmask16;
+
+BATCH_INLINE F operator+(F a, F b) { return {_mm512_add_ps(a.v, b.v)}; }
+BATCH_INLINE F operator-(F a, F b) { return {_mm512_sub_ps(a.v, b.v)}; }
+BATCH_INLINE F operator*(F a, F b) { return {_mm512_mul_ps(a.v, b.v)}; }
+BATCH_INLINE F operator/(F a, F b) { return {_mm512_div_ps(a.v, b.v)}; }
+// Float bitwise operations are AVX-512DQ, so these go through integers.
+BATCH_INLINE F operator&(F a, F b) {
+  return {_mm512_castsi512_ps(_mm512_and_epi32(a.bits(), b.bits()))};
+}
+BATCH_INLINE F operator|(F a, F b) {
+  return {_mm512_castsi512_ps(_mm512_or_epi32(a.bits(), b.bits()))};
+}
+BATCH_INLINE F operator^(F a, F b) {
+  return {_mm512_castsi512_ps(_mm512_xor_epi32(a.bits(), b.bits()))};
+}
+BATCH_INLINE Mask operator<(F a, F b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LT_OQ);
+}
+BATCH_INLINE Mask operator>(F a, F b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GT_OQ);
+}
+BATCH_INLINE Mask operator<=(F a, F b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_LE_OQ);
+}
+BATCH_INLINE Mask operator>=(F a, F b) {
+  return _mm512_cmp_ps_mask(a.v, b.v, _CMP_GE_OQ);
+}
+BATCH_INLINE unsigned maskBits(Mask m) { return m; }
+BATCH_INLINE F select(Mask m, F ifTrue, F ifFalse) {
+  return {_mm512_mask_blend_ps(m, ifFalse.v, ifTrue.v)};
+}
+BATCH_INLINE F abs(F a) { return {_mm512_abs_ps(a.v)}; }
+BATCH_INLINE F min(F a, F b) { return {_mm512_min_ps(a.v, b.v)}; }
+BATCH_INLINE F max(F a, F b) { return {_mm512_max_ps(a.v, b.v)}; }
+BATCH_INLINE F sqrt(F a) { return {_mm512_sqrt_ps(a.v)}; }
+BATCH_INLINE F safeInverseSqrt(F s) {
+  __m512 one = _mm512_set1_ps(1);
+  Mask positive = s > F::set(0);
+  return {_mm512_div_ps(one, _mm512_mask_sqrt_ps(one, positive, s.v))};
+}
+BATCH_INLINE F floatWithBits(F a) {
+  return {_mm512_castsi512_ps(_mm512_cvtps_epi32(a.v))};
+}
+BATCH_INLINE F bitsAsNumber(F a) {
+  return {_mm512_cvtepi32_ps(a.bits())};
+}
+
+BATCH_TARGET void randomBits(uint32_t (*state)[Random::lanes], uint32_t *out,
+                             size_t rounds) {
+  __m512i s[4];
+  for (int word = 0; word < 4; word++)
+    s[word] = _mm512_loadu_si512(state[word]);
+  for (size_t round = 0; round < rounds; round++) {
+    _mm512_storeu_si512(out + round * Random::lanes,
+                        _mm512_add_epi32(s[0], s[3]));
+    __m512i t = _mm512_slli_epi32(s[1], 9);
+    s[2] = _mm512_xor_si512(s[2], s[0]);
+    s[3] = _mm512_xor_si512(s[3], s[1]);
+    s[1] = _mm512_xor_si512(s[1], s[2]);
+    s[0] = _mm512_xor_si512(s[0], s[3]);
+    s[2] = _mm512_xor_si512(s[2], t);
+    s[3] = _mm512_rol_epi32(s[3], 11);
+  }
+  for (int word = 0; word < 4; word++)
+    _mm512_storeu_si512(state[word], s[word]);
+}
+
+#include "approx.h"
+#include "batchkernels.h"
+#undef BATCH_TARGET
+#undef BATCH_INLINE
+}  // namespace Avx512
+#pragma GCC diagnostic pop
+#endif
+
+//--- Dispatch
+
+const Kernels *const tables[LEVEL_COUNT] = {
+    &Scalar::table,
+#if LINEARMATH_SSE2
+    &Sse2::table,
+#else
+    nullptr,
+#endif
+#if BATCH_DISPATCH
+    &Avx::table,
+    &Avx512::table,
+#else
+    nullptr,
+    nullptr,
+#endif
+};
+
+level detect() {
+#if BATCH_DISPATCH
+  // Both checks include the OS saving the wider registers (XGETBV).
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return LEVEL_AVX512;
+  if (__builtin_cpu_supports("avx")) return LEVEL_AVX;
+  return LEVEL_SSE2;
+#elif LINEARMATH_SSE2
+  return LEVEL_SSE2;
+#else
+  return LEVEL_SCALAR;
+#endif
+}
+
+std::atomic<level> current{LEVEL_COUNT};  // LEVEL_COUNT until first use
+
+const Kernels &kernels() { return *tables[currentLevel()]; }
+
+Points2 advance(Points2 p, size_t n) { return {p.x + n, p.y + n}; }
+Points3 advance(Points3 p, size_t n) { return {p.x + n, p.y + n, p.z + n}; }
+Bounds2 advance(Bounds2 b, size_t n) {
+  return {advance(b.min, n), advance(b.max, n)};
+}
+Bounds3 advance(Bounds3 b, size_t n) {
+  return {advance(b.min, n), advance(b.max, n)};
+}
+
+// Random's distributions work through the generators' output this many
+// results at a time.
+constexpr size_t randomBlock = 64;
+
+size_t roundsFor(size_t values) {
+  return (values + Random::lanes - 1) / Random::lanes;
+}
+
+}  // namespace
+
+level supportedLevel() {
+  static const level supported = detect();
+  return supported;
+}
+
+level currentLevel() {
+  level l = current.load(std::memory_order_relaxed);
+  if (l == LEVEL_COUNT) {
+    l = supportedLevel();
+    current.store(l, std::memory_order_relaxed);
+  }
+  return l;
+}
+
+level setLevel(level requested) {
+  level l = requested < supportedLevel() ? requested : supportedLevel();
+  current.store(l, std::memory_order_relaxed);
+  return l;
+}
+
+int lanes(level l) {
+  static const int widths[LEVEL_COUNT] = {1, 4, 8, 16};
+  return l < LEVEL_COUNT ? widths[l] : 0;
+}
+
+const char *levelName(level l) {
+  static const char *const names[LEVEL_COUNT] = {"scalar", "sse2", "avx",
+                                                 "avx512"};
+  return l < LEVEL_COUNT ? names[l] : "unknown";
+}
+
+//--- Kernels
+// The widest level does whole registers; the scalar build does the tail.
+
+void transformPoints(const Mat3 &m, Points2 in, Points2 out, size_t count) {
+  size_t done = kernels().transformPoints2(m, in, out, count);
+  Scalar::transformPoints2(m, advance(in, done), advance(out, done),
+                           count - done);
+}
+
+void transformPoints(const Mat4 &m, Points3 in, Points3 out, size_t count) {
+  size_t done = kernels().transformPoints3(m, in, out, count);
+  Scalar::transformPoints3(m, advance(in, done), advance(out, done),
+                           count - done);
+}
+
+void integrate(Points2 values, Points2 rates, float dt, size_t count) {
+  size_t done = kernels().integrate2(values, rates, dt, count);
+  Scalar::integrate2(advance(values, done), advance(rates, done), dt,
+                     count - done);
+}
+
+void integrate(Points3 values, Points3 rates, float dt, size_t count) {
+  size_t done = kernels().integrate3(values, rates, dt, count);
+  Scalar::integrate3(advance(values, done), advance(rates, done), dt,
+                     count - done);
+}
+
+void normalize(Points2 vectors, size_t count) {
+  size_t done = kernels().normalize2(vectors, count);
+  Scalar::normalize2(advance(vectors, done), count - done);
+}
+
+void normalize(Points3 vectors, size_t count) {
+  size_t done = kernels().normalize3(vectors, count);
+  Scalar::normalize3(advance(vectors, done), count - done);
+}
+
+void transformBounds(const Mat3 &m, Bounds2 in, Bounds2 out, size_t count) {
+  size_t done = kernels().transformBounds2(m, in, out, count);
+  Scalar::transformBounds2(m, advance(in, done), advance(out, done),
+                           count - done);
+}
+
+void transformBounds(const Mat4 &m, Bounds3 in, Bounds3 out, size_t count) {
+  size_t done = kernels().transformBounds3(m, in, out, count);
+  Scalar::transformBounds3(m, advance(in, done), advance(out, done),
+                           count - done);
+}
+
+void sinCos(const float *radians, float *sines, float *cosines,
+            size_t count) {
+  size_t done = kernels().sinCos(radians, sines, cosines, count);
+  Scalar::sinCosArray(radians + done, sines + done, cosines + done,
+                      count - done);
+}
+
+void atan2(const float *y, const float *x, float *out, size_t count) {
+  size_t done = kernels().atan2(y, x, out, count);
+  Scalar::atan2Array(y + done, x + done, out + done, count - done);
+}
+
+void exp(const float *in, float *out, size_t count) {
+  size_t done = kernels().exp(in, out, count);
+  Scalar::expArray(in + done, out + done, count - done);
+}
+
+void log(const float *in, float *out, size_t count) {
+  size_t done = kernels().log(in, out, count);
+  Scalar::logArray(in + done, out + done, count - done);
+}
+
+void rotate(Points2 vectors, const float *radians, Points2 out,
+            size_t count) {
+  size_t done = kernels().rotate(vectors, radians, out, count);
+  Scalar::rotate2(advance(vectors, done), radians + done, advance(out, done),
+                  count - done);
+}
+
+void raycast(const Ray &ray, float maxT, Bounds2 boxes, float *t,
+             size_t count) {
+  size_t done = kernels().raycastBoxes(ray, maxT, boxes, t, count);
+  Scalar::raycastBoxes(ray, maxT, advance(boxes, done), t + done,
+                       count - done);
+}
+
+size_t overlapping(const Aabb &box, Bounds2 boxes, uint32_t *indices,
+                   size_t count) {
+  size_t found = 0;
+  size_t done = kernels().overlapBoxes(box, boxes, 0, indices, &found, count);
+  Scalar::overlapBoxes(box, advance(boxes, done),
+                       static_cast<uint32_t>(done), indices, &found,
+                       count - done);
+  return found;
+}
+
+size_t overlapping(const Circle &circle, Points2 centers, const float *radii,
+                   uint32_t *indices, size_t count) {
+  size_t found = 0;
+  size_t done = kernels().overlapCircles(circle, centers, radii, 0, indices,
+                                         &found, count);
+  Scalar::overlapCircles(circle, advance(centers, done), radii + done,
+                         static_cast<uint32_t>(done), indices, &found,
+                         count - done);
+  return found;
+}
+
+//--- Random
+
+Random::Random(uint64_t seed) : state() {
+  Xoshiro128Plus g(seed);
+  for (int lane = 0; lane < lanes; lane++) {
+    for (int word = 0; word < 4; word++) state[word][lane] = g.s[word];
+    g.jump();
+  }
+}
+
+void Random::bits(uint32_t *out, size_t count) {
+  size_t rounds = count / lanes, rest = count % lanes;
+  kernels().randomBits(state, out, rounds);
+  if (rest) {
+    uint32_t last[lanes];
+    kernels().randomBits(state, last, 1);
+    memcpy(out + rounds * lanes, last, rest * sizeof(*last));
+  }
+}
+
+void Random::uniform(float *out, size_t count, float lo, float hi) {
+  const Kernels &k = kernels();
+  uint32_t bits[randomBlock];
+  for (size_t i = 0; i < count; i += randomBlock) {
+    size_t n = std::min(randomBlock, count - i);
+    k.randomBits(state, bits, roundsFor(n));
+    size_t done = k.uniform(bits, lo, hi - lo, out + i, n);
+    Scalar::uniformArray(bits + done, lo, hi - lo, out + i + done, n - done);
+  }
+}
+
+// Results come in pairs, cosine halves first; an odd or partial block is
+// made in full and copied.
+void Random::normal(float *out, size_t count, float mean, float deviation) {
+  const Kernels &k = kernels();
+  uint32_t bits[randomBlock];
+  float spare[randomBlock];
+  for (size_t i = 0; i < count; i += randomBlock) {
+    size_t n = std::min(randomBlock, count - i), pairs = (n + 1) / 2;
+    k.randomBits(state, bits, roundsFor(2 * pairs));
+    float *results = n == randomBlock ? out + i : spare;
+    const uint32_t *angles = bits + pairs;
+    size_t done = k.normal(bits, angles, mean, deviation, results,
+                           results + pairs, pairs);
+    Scalar::normalArray(bits + done, angles + done, mean, deviation,
+                        results + done, results + pairs + done, pairs - done);
+    if (results == spare) memcpy(out + i, spare, n * sizeof(*spare));
+  }
+}
+
+void Random::inCircle(Points2 out, size_t count) {
+  const Kernels &k = kernels();
+  uint32_t bits[2 * randomBlock];
+  for (size_t i = 0; i < count; i += randomBlock) {
+    size_t n = std::min(randomBlock, count - i);
+    k.randomBits(state, bits, roundsFor(2 * n));
+    Points2 points = advance(out, i);
+    size_t done = k.inCircle(bits, bits + n, points, n);
+    Scalar::inCircleArray(bits + done, bits + n + done, advance(points, done),
+                          n - done);
+  }
+}
+
+void Random::onSphere(Points3 out, size_t count) {
+  const Kernels &k = kernels();
+  uint32_t bits[2 * randomBlock];
+  for (size_t i = 0; i < count; i += randomBlock) {
+    size_t n = std::min(randomBlock, count - i);
+    k.randomBits(state, bits, roundsFor(2 * n));
+    Points3 points = advance(out, i);
+    size_t done = k.onSphere(bits, bits + n, points, n);
+    Scalar::onSphereArray(bits + done, bits + n + done, advance(points, done),
+                          n - done);
+  }
+}
+
+}  // namespace Batch
+}  // namespace LinearMath
@@ -0,0 +1,118 @@
+#ifndef LINEARMATH_BATCH_H
+#define LINEARMATH_BATCH_H
+
+#include <stdint.h>
+
+#include <cstddef>
+
+#include "geometry.h"
+#include "matrix.h"
+
+// Kernels over structure-of-arrays data, for systems that update thousands
+// of entities the same way (particles, crowds, culling). Each component
+// lives in its own array so a register holds 4, 8 or 16 x's at once; the
+// widest instruction set the CPU supports is picked on first use.
+//
+// Outputs may be the same arrays as inputs but must not otherwise overlap
+// them. Every level gives bit-identical results.
+
+namespace LinearMath {
+namespace Batch {
+
+enum level : unsigned char {
+  LEVEL_SCALAR = 0,
+  LEVEL_SSE2,    // 4 lanes
+  LEVEL_AVX,     // 8 lanes
+  LEVEL_AVX512,  // 16 lanes
+  LEVEL_COUNT
+};
+
+struct Points2 {
+  float *x;
+  float *y;
+};
+struct Points3 {
+  float *x;
+  float *y;
+  float *z;
+};
+// Axis-aligned boxes as separate corner arrays.
+struct Bounds2 {
+  Points2 min;
+  Points2 max;
+};
+struct Bounds3 {
+  Points3 min;
+  Points3 max;
+};
+
+level currentLevel();
+level supportedLevel();  // the widest this CPU and build can run
+// For comparing results or timing; clamped to supportedLevel(). Returns the
+// level now in use.
+level setLevel(level requested);
+int lanes(level l);
+const char *levelName(level l);
+
+// out = m * (in, 1). The Mat4 version does no perspective divide.
+void transformPoints(const Mat3 &m, Points2 in, Points2 out, size_t count);
+void transformPoints(const Mat4 &m, Points3 in, Points3 out, size_t count);
+// values += rates * dt; positions by velocities, or velocities by
+// accelerations.
+void integrate(Points2 values, Points2 rates, float dt, size_t count);
+void integrate(Points3 values, Points3 rates, float dt, size_t count);
+// In place. Zero vectors are left unchanged, as with LinearMath::normalize.
+void normalize(Points2 vectors, size_t count);
+void normalize(Points3 vectors, size_t count);
+// The smallest axis-aligned boxes containing each transformed box.
+void transformBounds(const Mat3 &m, Bounds2 in, Bounds2 out, size_t count);
+void transformBounds(const Mat4 &m, Bounds3 in, Bounds3 out, size_t count);
+
+// The approximations from trig.h, with the same error bounds.
+void sinCos(const float *radians, float *sines, float *cosines, size_t count);
+void atan2(const float *y, const float *x, float *out, size_t count);
+void exp(const float *in, float *out, size_t count);
+void log(const float *in, float *out, size_t count);
+// Each vector by its own angle, e.g. sprite offsets by their headings.
+void rotate(Points2 vectors, const float *radians, Points2 out, size_t count);
+
+// One ray against many boxes, for picking: the t at which it enters each
+// box, 0 if it starts inside, or infinity if it misses within maxT.
+void raycast(const Ray &ray, float maxT, Bounds2 boxes, float *t,
+             size_t count);
+// Writes the indices of the boxes or circles that overlap the first
+// argument, in increasing order, and returns how many there are. `indices`
+// needs room for count; culling passes the view's bounds.
+size_t overlapping(const Aabb &box, Bounds2 boxes, uint32_t *indices,
+                   size_t count);
+size_t overlapping(const Circle &circle, Points2 centers, const float *radii,
+                   uint32_t *indices, size_t count);
+
+// Sixteen xoshiro128+ generators (see random.h) stepped side by side, for
+// filling particle and effect arrays. Each call draws a number of rounds
+// fixed by its count, so the output depends only on the seed and the calls
+// made, never on the level. The distributions use the same arithmetic as
+// random.h's.
+class Random {
+ public:
+  static constexpr int lanes = 16;
+
+  // The generators are 2^64 steps apart in one xoshiro128+ sequence.
+  explicit Random(uint64_t seed = 0);
+
+  void bits(uint32_t *out, size_t count);
+  // [lo, hi); hi itself only through rounding.
+  void uniform(float *out, size_t count, float lo = 0, float hi = 1);
+  void normal(float *out, size_t count, float mean = 0, float deviation = 1);
+  // Uniform over the unit disc and over the unit sphere's surface.
+  void inCircle(Points2 out, size_t count);
+  void onSphere(Points3 out, size_t count);
+
+  // state[word][generator]; copy it to save or replay a sequence.
+  uint32_t state[4][lanes];
+};
+
+}  // namespace Batch
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_BATCH_H
@@ -0,0 +1,332 @@
+// No include guard: batch.cpp includes this once per instruction set, in a
+// namespace that defines F (a register of F::width floats, see
+// scalarlane.h), the approximations from approx.h, randomBits (the
+// Random generators, which are integer code and written per level),
+// BATCH_TARGET (the function attribute that enables that instruction set)
+// and BATCH_INLINE (the same for helpers, which must always be inlined).
+//
+// Each kernel handles whole registers only and returns how many elements it
+// did; the caller finishes the rest with the scalar build of the same code.
+
+BATCH_TARGET size_t transformPoints2(const Mat3 &m, Points2 in, Points2 out,
+                                     size_t count) {
+  F m00 = F::set(m[0].x), m01 = F::set(m[0].y);
+  F m10 = F::set(m[1].x), m11 = F::set(m[1].y);
+  F m20 = F::set(m[2].x), m21 = F::set(m[2].y);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F x = F::load(in.x + i), y = F::load(in.y + i);
+    (m00 * x + m10 * y + m20).store(out.x + i);
+    (m01 * x + m11 * y + m21).store(out.y + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t transformPoints3(const Mat4 &m, Points3 in, Points3 out,
+                                     size_t count) {
+  F c[4][3];
+  for (int column = 0; column < 4; column++)
+    for (int row = 0; row < 3; row++) c[column][row] = F::set(m[column][row]);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F x = F::load(in.x + i), y = F::load(in.y + i), z = F::load(in.z + i);
+    (c[0][0] * x + c[1][0] * y + c[2][0] * z + c[3][0]).store(out.x + i);
+    (c[0][1] * x + c[1][1] * y + c[2][1] * z + c[3][1]).store(out.y + i);
+    (c[0][2] * x + c[1][2] * y + c[2][2] * z + c[3][2]).store(out.z + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t integrate2(Points2 values, Points2 rates, float dt,
+                               size_t count) {
+  F step = F::set(dt);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    (F::load(values.x + i) + F::load(rates.x + i) * step).store(values.x + i);
+    (F::load(values.y + i) + F::load(rates.y + i) * step).store(values.y + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t integrate3(Points3 values, Points3 rates, float dt,
+                               size_t count) {
+  F step = F::set(dt);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    (F::load(values.x + i) + F::load(rates.x + i) * step).store(values.x + i);
+    (F::load(values.y + i) + F::load(rates.y + i) * step).store(values.y + i);
+    (F::load(values.z + i) + F::load(rates.z + i) * step).store(values.z + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t normalize2(Points2 vectors, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F x = F::load(vectors.x + i), y = F::load(vectors.y + i);
+    F scale = safeInverseSqrt(x * x + y * y);
+    (x * scale).store(vectors.x + i);
+    (y * scale).store(vectors.y + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t normalize3(Points3 vectors, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F x = F::load(vectors.x + i), y = F::load(vectors.y + i),
+      z = F::load(vectors.z + i);
+    F scale = safeInverseSqrt(x * x + y * y + z * z);
+    (x * scale).store(vectors.x + i);
+    (y * scale).store(vectors.y + i);
+    (z * scale).store(vectors.z + i);
+  }
+  return i;
+}
+
+// Arvo's method: transform the center, and grow the half-extents by the
+// absolute values of the linear part.
+BATCH_TARGET size_t transformBounds2(const Mat3 &m, Bounds2 in, Bounds2 out,
+                                     size_t count) {
+  F m00 = F::set(m[0].x), m01 = F::set(m[0].y);
+  F m10 = F::set(m[1].x), m11 = F::set(m[1].y);
+  F m20 = F::set(m[2].x), m21 = F::set(m[2].y);
+  F a00 = abs(m00), a01 = abs(m01), a10 = abs(m10), a11 = abs(m11);
+  F half = F::set(0.5f);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F minX = F::load(in.min.x + i), minY = F::load(in.min.y + i);
+    F maxX = F::load(in.max.x + i), maxY = F::load(in.max.y + i);
+    F cx = (minX + maxX) * half, cy = (minY + maxY) * half;
+    F ex = (maxX - minX) * half, ey = (maxY - minY) * half;
+    F x = m00 * cx + m10 * cy + m20, y = m01 * cx + m11 * cy + m21;
+    F extentX = a00 * ex + a10 * ey, extentY = a01 * ex + a11 * ey;
+    (x - extentX).store(out.min.x + i);
+    (y - extentY).store(out.min.y + i);
+    (x + extentX).store(out.max.x + i);
+    (y + extentY).store(out.max.y + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t transformBounds3(const Mat4 &m, Bounds3 in, Bounds3 out,
+                                     size_t count) {
+  F c[4][3], a[3][3];
+  for (int column = 0; column < 4; column++) {
+    for (int row = 0; row < 3; row++) {
+      c[column][row] = F::set(m[column][row]);
+      if (column < 3) a[column][row] = abs(c[column][row]);
+    }
+  }
+  F half = F::set(0.5f);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F minX = F::load(in.min.x + i), minY = F::load(in.min.y + i),
+      minZ = F::load(in.min.z + i);
+    F maxX = F::load(in.max.x + i), maxY = F::load(in.max.y + i),
+      maxZ = F::load(in.max.z + i);
+    F cx = (minX + maxX) * half, cy = (minY + maxY) * half,
+      cz = (minZ + maxZ) * half;
+    F ex = (maxX - minX) * half, ey = (maxY - minY) * half,
+      ez = (maxZ - minZ) * half;
+    F center[3], extent[3];
+    for (int row = 0; row < 3; row++) {
+      center[row] =
+          c[0][row] * cx + c[1][row] * cy + c[2][row] * cz + c[3][row];
+      extent[row] = a[0][row] * ex + a[1][row] * ey + a[2][row] * ez;
+    }
+    (center[0] - extent[0]).store(out.min.x + i);
+    (center[1] - extent[1]).store(out.min.y + i);
+    (center[2] - extent[2]).store(out.min.z + i);
+    (center[0] + extent[0]).store(out.max.x + i);
+    (center[1] + extent[1]).store(out.max.y + i);
+    (center[2] + extent[2]).store(out.max.z + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t sinCosArray(const float *radians, float *sines,
+                                float *cosines, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F s, c;
+    sinCos(F::load(radians + i), &s, &c);
+    s.store(sines + i);
+    c.store(cosines + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t atan2Array(const float *y, const float *x, float *out,
+                               size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width)
+    atan2(F::load(y + i), F::load(x + i)).store(out + i);
+  return i;
+}
+
+BATCH_TARGET size_t expArray(const float *in, float *out, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width)
+    exp(F::load(in + i)).store(out + i);
+  return i;
+}
+
+BATCH_TARGET size_t logArray(const float *in, float *out, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width)
+    log(F::load(in + i)).store(out + i);
+  return i;
+}
+
+BATCH_TARGET size_t rotate2(Points2 vectors, const float *radians,
+                            Points2 out, size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F s, c;
+    sinCos(F::load(radians + i), &s, &c);
+    F x = F::load(vectors.x + i), y = F::load(vectors.y + i);
+    (c * x - s * y).store(out.x + i);
+    (s * x + c * y).store(out.y + i);
+  }
+  return i;
+}
+
+//--- Random
+// Random's raw bits to distributions, with the same arithmetic as the
+// one-at-a-time functions in random.h so the results match them exactly.
+
+// unitFloat: the top 24 bits over 2^24. The only conversion is a signed
+// one, which gives the value offset by a half; the select moves it back.
+BATCH_INLINE F unitFloats(const uint32_t *bits) {
+  F offset = bitsAsNumber(F::loadBits(bits) & F::setBits(0xffffff00u)) *
+                 F::set(2.3283064365386963e-10f) +  // 2^-32
+             F::set(0.5f);
+  return select(offset < F::set(0.5f), offset + F::set(0.5f),
+                offset - F::set(0.5f));
+}
+
+BATCH_TARGET size_t uniformArray(const uint32_t *bits, float lo, float range,
+                                 float *out, size_t count) {
+  F low = F::set(lo), scale = F::set(range);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width)
+    (low + scale * unitFloats(bits + i)).store(out + i);
+  return i;
+}
+
+// Box-Muller, keeping both halves of each pair.
+BATCH_TARGET size_t normalArray(const uint32_t *radii, const uint32_t *angles,
+                                float mean, float deviation, float *cosines,
+                                float *sines, size_t count) {
+  F center = F::set(mean), spread = F::set(deviation);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F u = F::set(1) - unitFloats(radii + i);
+    F r = spread * sqrt(F::set(-2) * log(u));
+    F s, c;
+    sinCos(F::set(tau) * unitFloats(angles + i), &s, &c);
+    (center + r * c).store(cosines + i);
+    (center + r * s).store(sines + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t inCircleArray(const uint32_t *radii,
+                                  const uint32_t *angles, Points2 out,
+                                  size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F r = sqrt(unitFloats(radii + i));
+    F s, c;
+    sinCos(F::set(tau) * unitFloats(angles + i), &s, &c);
+    (c * r).store(out.x + i);
+    (s * r).store(out.y + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t onSphereArray(const uint32_t *heights,
+                                  const uint32_t *angles, Points3 out,
+                                  size_t count) {
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F z = F::set(2) * unitFloats(heights + i) - F::set(1);
+    F r = sqrt(F::set(1) - z * z);
+    F s, c;
+    sinCos(F::set(tau) * unitFloats(angles + i), &s, &c);
+    (c * r).store(out.x + i);
+    (s * r).store(out.y + i);
+    z.store(out.z + i);
+  }
+  return i;
+}
+
+//--- Geometry
+
+// Slab test. Directions with a zero component divide to infinities, which
+// the min and max sort out, except for a ray exactly along a box edge,
+// where 0 * inf gives NaN and whether it hits is unspecified.
+BATCH_TARGET size_t raycastBoxes(const Ray &ray, float maxT, Bounds2 boxes,
+                                 float *t, size_t count) {
+  F ox = F::set(ray.origin.x), oy = F::set(ray.origin.y);
+  F ix = F::set(1 / ray.direction.x), iy = F::set(1 / ray.direction.y);
+  F limit = F::set(maxT), zero = F::set(0), miss = F::setBits(0x7f800000u);
+  size_t i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F x1 = (F::load(boxes.min.x + i) - ox) * ix;
+    F x2 = (F::load(boxes.max.x + i) - ox) * ix;
+    F y1 = (F::load(boxes.min.y + i) - oy) * iy;
+    F y2 = (F::load(boxes.max.y + i) - oy) * iy;
+    F near = max(max(min(x1, x2), min(y1, y2)), zero);
+    F far = min(min(max(x1, x2), max(y1, y2)), limit);
+    select(near <= far, near, miss).store(t + i);
+  }
+  return i;
+}
+
+BATCH_TARGET size_t overlapBoxes(const Aabb &box, Bounds2 boxes,
+                                 uint32_t first, uint32_t *indices,
+                                 size_t *found, size_t count) {
+  F minX = F::set(box.min.x), minY = F::set(box.min.y);
+  F maxX = F::set(box.max.x), maxY = F::set(box.max.y);
+  size_t n = *found, i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    Mask hit = (F::load(boxes.min.x + i) <= maxX) &
+               (F::load(boxes.max.x + i) >= minX) &
+               (F::load(boxes.min.y + i) <= maxY) &
+               (F::load(boxes.max.y + i) >= minY);
+    uint32_t index = first + static_cast<uint32_t>(i);
+    for (unsigned bits = maskBits(hit); bits; bits >>= 1, index++)
+      if (bits & 1) indices[n++] = index;
+  }
+  *found = n;
+  return i;
+}
+
+BATCH_TARGET size_t overlapCircles(const Circle &circle, Points2 centers,
+                                   const float *radii, uint32_t first,
+                                   uint32_t *indices, size_t *found,
+                                   size_t count) {
+  F cx = F::set(circle.center.x), cy = F::set(circle.center.y);
+  F r = F::set(circle.radius);
+  size_t n = *found, i = 0;
+  for (; i + F::width <= count; i += F::width) {
+    F dx = F::load(centers.x + i) - cx, dy = F::load(centers.y + i) - cy;
+    F reach = F::load(radii + i) + r;
+    Mask hit = dx * dx + dy * dy <= reach * reach;
+    uint32_t index = first + static_cast<uint32_t>(i);
+    for (unsigned bits = maskBits(hit); bits; bits >>= 1, index++)
+      if (bits & 1) indices[n++] = index;
+  }
+  *found = n;
+  return i;
+}
+
+const Kernels table = {
+    transformPoints2, transformPoints3, integrate2,       integrate3,
+    normalize2,       normalize3,       transformBounds2, transformBounds3,
+    sinCosArray,      atan2Array,       expArray,         logArray,
+    rotate2,          randomBits,       uniformArray,     normalArray,
+    inCircleArray,    onSphereArray,    raycastBoxes,     overlapBoxes,
+    overlapCircles};
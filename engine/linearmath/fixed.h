@@ -0,0 +1,439 @@
+#ifndef LINEARMATH_FIXED_H
+#define LINEARMATH_FIXED_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "simd.h"
+#include "vector.h"
+
+namespace LinearMath {
+
+// Fixed-point numbers for simulation that must replay bit for bit on every
+// machine, compiler and set of flags (lockstep multiplayer, replays). All
+// arithmetic here is on integers, so nothing depends on how floats round;
+// overflow wraps like unsigned integers. Write code that may run either way
+// against Real (see real.h) rather than against Fixed directly.
+//
+// Q16.16: the range is [-32768, 32768) in steps of 1/65536, so simulation
+// units should be around a meter, not a pixel. Products are rounded to the
+// nearest step, as are quotients.
+struct Fixed {
+  static constexpr int fractionBits = 16;
+  static constexpr int32_t oneRaw = 1 << fractionBits;
+
+  constexpr Fixed() = default;
+  constexpr explicit Fixed(int i)
+      : raw(static_cast<int32_t>(static_cast<uint32_t>(i) << fractionBits)) {}
+  // Rounded to the nearest step, halves away from zero. The result depends
+  // only on the value, so constants such as Fixed(0.1f) agree everywhere;
+  // converting computed floats brings their differences with them.
+  constexpr explicit Fixed(double d)
+      : raw(static_cast<int32_t>(d * oneRaw + (d < 0 ? -0.5 : 0.5))) {}
+  constexpr explicit Fixed(float f) : Fixed(static_cast<double>(f)) {}
+
+  static constexpr Fixed fromRaw(int32_t raw) {
+    Fixed f;
+    f.raw = raw;
+    return f;
+  }
+  // For rendering and debugging; nothing converted back should feed the
+  // simulation.
+  constexpr explicit operator float() const {
+    return static_cast<float>(raw) * (1.0f / oneRaw);
+  }
+  constexpr int floorToInt() const { return raw >> fractionBits; }
+
+  constexpr Fixed &operator+=(Fixed o);
+  constexpr Fixed &operator-=(Fixed o);
+  constexpr Fixed &operator*=(Fixed o);
+  constexpr Fixed &operator/=(Fixed o);
+
+  int32_t raw = 0;
+};
+
+namespace FixedDetail {
+
+// Keeps the low 32 bits, as unsigned arithmetic would.
+constexpr int32_t wrap(int64_t v) {
+  return static_cast<int32_t>(static_cast<uint32_t>(v));
+}
+// From 2^-30 steps to 2^-16, to nearest.
+constexpr int64_t roundFrom30(int64_t v) { return (v + (1 << 13)) >> 14; }
+constexpr int64_t multiply30(int64_t a, int64_t b) { return a * b >> 30; }
+
+// floor(sqrt(n)). At runtime a double estimate is corrected to the exact
+// answer, so the result does not depend on how sqrt rounds.
+constexpr uint32_t squareRoot(uint64_t n) {
+  if (LINEARMATH_RUNTIME()) {
+    uint64_t root = static_cast<uint64_t>(::sqrt(static_cast<double>(n)));
+    if (root > 0xffffffffu) root = 0xffffffffu;
+    while (root * root > n) root--;
+    while (root < 0xffffffffu && (root + 1) * (root + 1) <= n) root++;
+    return static_cast<uint32_t>(root);
+  }
+  uint64_t root = 0, bit = uint64_t(1) << 62;
+  while (bit > n) bit >>= 2;
+  for (; bit; bit >>= 2) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return static_cast<uint32_t>(root);
+}
+
+// sin(pi/2 * q) for q in quarter turns with 32 fraction bits. A degree 7
+// minimax polynomial over one quadrant, in 2^-30 steps; 6e-7 from exact.
+constexpr Fixed sineOfQuarterTurns(int64_t q) {
+  int quadrant = static_cast<int>(q >> 32) & 3;
+  int64_t t = q & 0xffffffff;
+  if (quadrant & 1) t = (int64_t(1) << 32) - t;
+  t >>= 2;
+  int64_t z = multiply30(t, t);
+  int64_t p = -4652626;
+  p = multiply30(p, z) + 85291978;
+  p = multiply30(p, z) - 693522166;
+  p = multiply30(p, z) + 1686624005;
+  int32_t s = static_cast<int32_t>(roundFrom30(multiply30(p, t)));
+  return Fixed::fromRaw(quadrant & 2 ? -s : s);
+}
+
+// Quarter turns in a radian, to 2^-32.
+constexpr int64_t quarterTurnsPerRadian = 2734261102;
+constexpr int64_t quarterTurns(Fixed radians) {
+  return radians.raw * quarterTurnsPerRadian >> Fixed::fractionBits;
+}
+
+}  // namespace FixedDetail
+
+//--- Arithmetic
+
+constexpr Fixed operator-(Fixed a) {
+  return Fixed::fromRaw(FixedDetail::wrap(-int64_t(a.raw)));
+}
+constexpr Fixed operator+(Fixed a, Fixed b) {
+  return Fixed::fromRaw(FixedDetail::wrap(int64_t(a.raw) + b.raw));
+}
+constexpr Fixed operator-(Fixed a, Fixed b) {
+  return Fixed::fromRaw(FixedDetail::wrap(int64_t(a.raw) - b.raw));
+}
+constexpr Fixed operator*(Fixed a, Fixed b) {
+  int64_t product = int64_t(a.raw) * b.raw;
+  return Fixed::fromRaw(FixedDetail::wrap(
+      (product + (1 << (Fixed::fractionBits - 1))) >> Fixed::fractionBits));
+}
+// Dividing by zero gives the largest value of the numerator's sign.
+constexpr Fixed operator/(Fixed a, Fixed b) {
+  if (b.raw == 0) return Fixed::fromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+  int64_t n = int64_t(a.raw) * Fixed::oneRaw;
+  int64_t half = (b.raw < 0 ? -int64_t(b.raw) : b.raw) / 2;
+  n += (n < 0) == (b.raw < 0) ? half : -half;  // halves away from zero
+  return Fixed::fromRaw(FixedDetail::wrap(n / b.raw));
+}
+// Scaling by whole numbers is exact.
+constexpr Fixed operator*(Fixed a, int s) {
+  return Fixed::fromRaw(FixedDetail::wrap(int64_t(a.raw) * s));
+}
+constexpr Fixed operator*(int s, Fixed a) { return a * s; }
+constexpr Fixed operator/(Fixed a, int s) {
+  if (s == 0) return Fixed::fromRaw(a.raw < 0 ? INT32_MIN : INT32_MAX);
+  return Fixed::fromRaw(FixedDetail::wrap(int64_t(a.raw) / s));
+}
+
+constexpr Fixed &Fixed::operator+=(Fixed o) { return *this = *this + o; }
+constexpr Fixed &Fixed::operator-=(Fixed o) { return *this = *this - o; }
+constexpr Fixed &Fixed::operator*=(Fixed o) { return *this = *this * o; }
+constexpr Fixed &Fixed::operator/=(Fixed o) { return *this = *this / o; }
+
+constexpr bool operator==(Fixed a, Fixed b) { return a.raw == b.raw; }
+constexpr bool operator!=(Fixed a, Fixed b) { return a.raw != b.raw; }
+constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+constexpr bool operator<=(Fixed a, Fixed b) { return a.raw <= b.raw; }
+constexpr bool operator>=(Fixed a, Fixed b) { return a.raw >= b.raw; }
+
+//--- Functions
+// Same names as <math.h>, which stays visible alongside them, so code
+// written against Real compiles either way.
+
+using ::abs;
+using ::atan2;
+using ::cos;
+using ::floor;
+using ::sin;
+using ::sqrt;
+
+constexpr Fixed abs(Fixed a) { return a.raw < 0 ? -a : a; }
+constexpr Fixed floor(Fixed a) {
+  return Fixed::fromRaw(a.raw & ~(Fixed::oneRaw - 1));
+}
+// Rounded down to a step; negative inputs give 0.
+constexpr Fixed sqrt(Fixed a) {
+  if (a.raw <= 0) return Fixed();
+  return Fixed::fromRaw(static_cast<int32_t>(FixedDetail::squareRoot(
+      static_cast<uint64_t>(a.raw) << Fixed::fractionBits)));
+}
+// Within a step (1.5e-5) of exact, plus the input's own rounding.
+constexpr Fixed sin(Fixed radians) {
+  return FixedDetail::sineOfQuarterTurns(FixedDetail::quarterTurns(radians));
+}
+constexpr Fixed cos(Fixed radians) {
+  return FixedDetail::sineOfQuarterTurns(FixedDetail::quarterTurns(radians) +
+                                         (int64_t(1) << 32));
+}
+// Within a step of exact; (0, 0) gives 0.
+constexpr Fixed atan2(Fixed y, Fixed x) {
+  using FixedDetail::multiply30;
+  int64_t ax = x.raw < 0 ? -int64_t(x.raw) : x.raw;
+  int64_t ay = y.raw < 0 ? -int64_t(y.raw) : y.raw;
+  int64_t high = ax > ay ? ax : ay, low = ax > ay ? ay : ax;
+  if (high == 0) return Fixed();
+  // A degree 13 minimax polynomial for atan over [0, 1], in 2^-30 steps.
+  int64_t t = (low << 30) / high;
+  int64_t z = multiply30(t, t);
+  int64_t a = 10591173;
+  a = multiply30(a, z) - 46269019;
+  a = multiply30(a, z) + 97393775;
+  a = multiply30(a, z) - 148535018;
+  a = multiply30(a, z) + 214294475;
+  a = multiply30(a, z) - 357902329;
+  a = multiply30(a, z) + 1073741798;
+  a = multiply30(a, t);
+  if (ay > ax) a = 1686629713 - a;  // pi/2
+  if (x.raw < 0) a = 3373259426 - a;  // pi
+  int32_t angle = static_cast<int32_t>(FixedDetail::roundFrom30(a));
+  return Fixed::fromRaw(y.raw < 0 ? -angle : angle);
+}
+constexpr Fixed lerp(Fixed a, Fixed b, Fixed t) { return a + (b - a) * t; }
+
+//--- Vectors
+// The Vec2 and Vec3 operations, over Fixed.
+
+struct FixedVec2 {
+  Fixed x;
+  Fixed y;
+
+  constexpr FixedVec2() = default;
+  constexpr FixedVec2(Fixed x, Fixed y) : x(x), y(y) {}
+  constexpr explicit FixedVec2(Fixed scalar) : x(scalar), y(scalar) {}
+  constexpr explicit FixedVec2(Vec2 v) : x(v.x), y(v.y) {}
+  constexpr explicit operator Vec2() const {
+    return {static_cast<float>(x), static_cast<float>(y)};
+  }
+
+  constexpr Fixed &operator[](int i) { return i ? y : x; }
+  constexpr Fixed operator[](int i) const { return i ? y : x; }
+
+  constexpr FixedVec2 &operator+=(FixedVec2 o);
+  constexpr FixedVec2 &operator-=(FixedVec2 o);
+  constexpr FixedVec2 &operator*=(FixedVec2 o);
+  constexpr FixedVec2 &operator*=(Fixed s);
+  constexpr FixedVec2 &operator/=(Fixed s);
+};
+
+struct FixedVec3 {
+  Fixed x;
+  Fixed y;
+  Fixed z;
+
+  constexpr FixedVec3() = default;
+  constexpr FixedVec3(Fixed x, Fixed y, Fixed z) : x(x), y(y), z(z) {}
+  constexpr FixedVec3(FixedVec2 xy, Fixed z) : x(xy.x), y(xy.y), z(z) {}
+  constexpr explicit FixedVec3(Fixed scalar)
+      : x(scalar), y(scalar), z(scalar) {}
+  constexpr explicit FixedVec3(Vec3 v) : x(v.x), y(v.y), z(v.z) {}
+  constexpr explicit operator Vec3() const {
+    return {static_cast<float>(x), static_cast<float>(y),
+            static_cast<float>(z)};
+  }
+
+  constexpr FixedVec2 xy() const { return {x, y}; }
+  constexpr Fixed &operator[](int i) { return i == 0 ? x : i == 1 ? y : z; }
+  constexpr Fixed operator[](int i) const {
+    return i == 0 ? x : i == 1 ? y : z;
+  }
+
+  constexpr FixedVec3 &operator+=(FixedVec3 o);
+  constexpr FixedVec3 &operator-=(FixedVec3 o);
+  constexpr FixedVec3 &operator*=(FixedVec3 o);
+  constexpr FixedVec3 &operator*=(Fixed s);
+  constexpr FixedVec3 &operator/=(Fixed s);
+};
+
+constexpr FixedVec2 operator-(FixedVec2 a) { return {-a.x, -a.y}; }
+constexpr FixedVec2 operator+(FixedVec2 a, FixedVec2 b) {
+  return {a.x + b.x, a.y + b.y};
+}
+constexpr FixedVec2 operator-(FixedVec2 a, FixedVec2 b) {
+  return {a.x - b.x, a.y - b.y};
+}
+constexpr FixedVec2 operator*(FixedVec2 a, FixedVec2 b) {
+  return {a.x * b.x, a.y * b.y};
+}
+constexpr FixedVec2 operator*(FixedVec2 a, Fixed s) {
+  return {a.x * s, a.y * s};
+}
+constexpr FixedVec2 operator*(Fixed s, FixedVec2 a) { return a * s; }
+constexpr FixedVec2 operator/(FixedVec2 a, Fixed s) {
+  return {a.x / s, a.y / s};
+}
+constexpr bool operator==(FixedVec2 a, FixedVec2 b) {
+  return a.x == b.x && a.y == b.y;
+}
+constexpr bool operator!=(FixedVec2 a, FixedVec2 b) { return !(a == b); }
+
+constexpr FixedVec2 &FixedVec2::operator+=(FixedVec2 o) {
+  return *this = *this + o;
+}
+constexpr FixedVec2 &FixedVec2::operator-=(FixedVec2 o) {
+  return *this = *this - o;
+}
+constexpr FixedVec2 &FixedVec2::operator*=(FixedVec2 o) {
+  return *this = *this * o;
+}
+constexpr FixedVec2 &FixedVec2::operator*=(Fixed s) {
+  return *this = *this * s;
+}
+constexpr FixedVec2 &FixedVec2::operator/=(Fixed s) {
+  return *this = *this / s;
+}
+
+constexpr FixedVec3 operator-(FixedVec3 a) { return {-a.x, -a.y, -a.z}; }
+constexpr FixedVec3 operator+(FixedVec3 a, FixedVec3 b) {
+  return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+constexpr FixedVec3 operator-(FixedVec3 a, FixedVec3 b) {
+  return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+constexpr FixedVec3 operator*(FixedVec3 a, FixedVec3 b) {
+  return {a.x * b.x, a.y * b.y, a.z * b.z};
+}
+constexpr FixedVec3 operator*(FixedVec3 a, Fixed s) {
+  return {a.x * s, a.y * s, a.z * s};
+}
+constexpr FixedVec3 operator*(Fixed s, FixedVec3 a) { return a * s; }
+constexpr FixedVec3 operator/(FixedVec3 a, Fixed s) {
+  return {a.x / s, a.y / s, a.z / s};
+}
+constexpr bool operator==(FixedVec3 a, FixedVec3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+constexpr bool operator!=(FixedVec3 a, FixedVec3 b) { return !(a == b); }
+
+constexpr FixedVec3 &FixedVec3::operator+=(FixedVec3 o) {
+  return *this = *this + o;
+}
+constexpr FixedVec3 &FixedVec3::operator-=(FixedVec3 o) {
+  return *this = *this - o;
+}
+constexpr FixedVec3 &FixedVec3::operator*=(FixedVec3 o) {
+  return *this = *this * o;
+}
+constexpr FixedVec3 &FixedVec3::operator*=(Fixed s) {
+  return *this = *this * s;
+}
+constexpr FixedVec3 &FixedVec3::operator/=(Fixed s) {
+  return *this = *this / s;
+}
+
+namespace FixedDetail {
+
+// Products are summed at full precision and rounded once.
+constexpr int64_t product(Fixed a, Fixed b) { return int64_t(a.raw) * b.raw; }
+constexpr Fixed fromProducts(int64_t sum) {
+  return Fixed::fromRaw(
+      wrap((sum + (1 << (Fixed::fractionBits - 1))) >> Fixed::fractionBits));
+}
+// The sum of squares is below 2^64 whatever the components, so lengths
+// cannot overflow unless the length itself is out of range.
+constexpr uint64_t squares(FixedVec2 v) {
+  return static_cast<uint64_t>(product(v.x, v.x)) +
+         static_cast<uint64_t>(product(v.y, v.y));
+}
+constexpr uint64_t squares(FixedVec3 v) {
+  return squares(FixedVec2(v.x, v.y)) +
+         static_cast<uint64_t>(product(v.z, v.z));
+}
+
+}  // namespace FixedDetail
+
+constexpr Fixed dot(FixedVec2 a, FixedVec2 b) {
+  using namespace FixedDetail;
+  return fromProducts(product(a.x, b.x) + product(a.y, b.y));
+}
+constexpr Fixed cross(FixedVec2 a, FixedVec2 b) {
+  using namespace FixedDetail;
+  return fromProducts(product(a.x, b.y) - product(a.y, b.x));
+}
+constexpr FixedVec2 perpendicular(FixedVec2 a) { return {-a.y, a.x}; }
+constexpr FixedVec2 min(FixedVec2 a, FixedVec2 b) {
+  return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y};
+}
+constexpr FixedVec2 max(FixedVec2 a, FixedVec2 b) {
+  return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y};
+}
+
+constexpr Fixed dot(FixedVec3 a, FixedVec3 b) {
+  using namespace FixedDetail;
+  return fromProducts(product(a.x, b.x) + product(a.y, b.y) +
+                      product(a.z, b.z));
+}
+constexpr FixedVec3 cross(FixedVec3 a, FixedVec3 b) {
+  using namespace FixedDetail;
+  return {fromProducts(product(a.y, b.z) - product(a.z, b.y)),
+          fromProducts(product(a.z, b.x) - product(a.x, b.z)),
+          fromProducts(product(a.x, b.y) - product(a.y, b.x))};
+}
+constexpr FixedVec3 min(FixedVec3 a, FixedVec3 b) {
+  return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y,
+          a.z < b.z ? a.z : b.z};
+}
+constexpr FixedVec3 max(FixedVec3 a, FixedVec3 b) {
+  return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y,
+          a.z > b.z ? a.z : b.z};
+}
+
+// Overloads rather than vector.h's templates, which work in float.
+
+constexpr Fixed lengthSquared(FixedVec2 v) { return dot(v, v); }
+constexpr Fixed lengthSquared(FixedVec3 v) { return dot(v, v); }
+// Rounded down to a step.
+constexpr Fixed length(FixedVec2 v) {
+  return Fixed::fromRaw(static_cast<int32_t>(
+      FixedDetail::squareRoot(FixedDetail::squares(v))));
+}
+constexpr Fixed length(FixedVec3 v) {
+  return Fixed::fromRaw(static_cast<int32_t>(
+      FixedDetail::squareRoot(FixedDetail::squares(v))));
+}
+constexpr Fixed distance(FixedVec2 a, FixedVec2 b) { return length(a - b); }
+constexpr Fixed distance(FixedVec3 a, FixedVec3 b) { return length(a - b); }
+// A zero vector comes back unchanged.
+constexpr FixedVec2 normalize(FixedVec2 v) {
+  Fixed l = length(v);
+  return l.raw ? v / l : v;
+}
+constexpr FixedVec3 normalize(FixedVec3 v) {
+  Fixed l = length(v);
+  return l.raw ? v / l : v;
+}
+constexpr FixedVec2 lerp(FixedVec2 a, FixedVec2 b, Fixed t) {
+  return a + (b - a) * t;
+}
+constexpr FixedVec3 lerp(FixedVec3 a, FixedVec3 b, Fixed t) {
+  return a + (b - a) * t;
+}
+
+// The unit vector at `radians` counter-clockwise from +x.
+constexpr FixedVec2 direction(Fixed radians) {
+  return {cos(radians), sin(radians)};
+}
+constexpr Fixed angleOf(FixedVec2 v) { return atan2(v.y, v.x); }
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_FIXED_H
@@ -0,0 +1,298 @@
+#include "geometry.h"
+
+namespace LinearMath {
+
+namespace {
+
+// `corners` are counter-clockwise and convex.
+void setCorners(ConvexPolygon *polygon, const Vec2 *corners, int count) {
+  polygon->count = count;
+  for (int i = 0; i < ConvexPolygon::maxVertices; i++) {
+    int from = i < count ? i : 0, to = from + 1 < count ? from + 1 : 0;
+    Vec2 edge = corners[to] - corners[from];
+    Vec2 outward = normalize(Vec2(edge.y, -edge.x));
+    polygon->x[i] = corners[from].x;
+    polygon->y[i] = corners[from].y;
+    polygon->normalX[i] = outward.x;
+    polygon->normalY[i] = outward.y;
+  }
+}
+
+// The clipped interval of a ray against a box, for both box raycasts.
+bool clipToBox(Vec2 origin, Vec2 direction, Vec2 lo, Vec2 hi, float maxT,
+               RayHit *hit) {
+  float lower = 0, upper = maxT;
+  Vec2 normal;
+  for (int axis = 0; axis < 2; axis++) {
+    float o = origin[axis], d = direction[axis];
+    if (d == 0) {
+      if (o < lo[axis] || o > hi[axis]) return false;
+      continue;
+    }
+    float near = (lo[axis] - o) / d, far = (hi[axis] - o) / d, side = -1;
+    if (near > far) {
+      float swap = near;
+      near = far;
+      far = swap;
+      side = 1;
+    }
+    if (near > lower) {
+      lower = near;
+      normal = Vec2();
+      normal[axis] = side;
+    }
+    if (far < upper) upper = far;
+    if (lower > upper) return false;
+  }
+  hit->t = lower;
+  hit->normal = normal;
+  return true;
+}
+
+}  // namespace
+
+//--- ConvexPolygon
+
+// Gift wrapping, which stops as soon as the hull has too many corners.
+bool ConvexPolygon::setPoints(const Vec2 *points, int pointCount) {
+  count = 0;
+  if (pointCount < 3) return 1;
+  int start = 0;
+  for (int i = 1; i < pointCount; i++) {
+    if (points[i].x < points[start].x ||
+        (points[i].x == points[start].x && points[i].y < points[start].y))
+      start = i;
+  }
+  Vec2 hull[maxVertices];
+  int corners = 0, current = start;
+  do {
+    if (corners == maxVertices) return 1;
+    hull[corners++] = points[current];
+    // The next corner has every point on its left; of points in line with
+    // it, the farthest, so that edges skip over them.
+    int next = current;
+    for (int i = 0; i < pointCount; i++) {
+      Vec2 candidate = points[next] - points[current];
+      Vec2 other = points[i] - points[current];
+      float side = cross(candidate, other);
+      if (next == current || side < 0 ||
+          (side == 0 && dot(other, other) > dot(candidate, candidate)))
+        next = i;
+    }
+    current = next;
+  } while (points[current] != points[start]);
+  if (corners < 3) return 1;
+  setCorners(this, hull, corners);
+  return 0;
+}
+
+ConvexPolygon ConvexPolygon::fromAabb(const Aabb &box) {
+  Vec2 corners[4] = {box.min,
+                     {box.max.x, box.min.y},
+                     box.max,
+                     {box.min.x, box.max.y}};
+  ConvexPolygon polygon;
+  setCorners(&polygon, corners, 4);
+  return polygon;
+}
+
+ConvexPolygon ConvexPolygon::fromObb(const Obb &box) {
+  Vec2 x = box.axis * box.halfExtents.x;
+  Vec2 y = perpendicular(box.axis) * box.halfExtents.y;
+  Vec2 corners[4] = {box.center - x - y, box.center + x - y,
+                     box.center + x + y, box.center - x + y};
+  ConvexPolygon polygon;
+  setCorners(&polygon, corners, 4);
+  return polygon;
+}
+
+bool contains(const ConvexPolygon &polygon, Vec2 p) {
+  for (int i = 0; i < polygon.count; i++) {
+    if (dot(polygon.normal(i), p - polygon.vertex(i)) > 0) return false;
+  }
+  return polygon.count > 0;
+}
+
+Aabb bounds(const ConvexPolygon &polygon) {
+  Aabb box = {polygon.vertex(0), polygon.vertex(0)};
+  for (int i = 1; i < polygon.count; i++) {
+    box.min = min(box.min, polygon.vertex(i));
+    box.max = max(box.max, polygon.vertex(i));
+  }
+  return box;
+}
+
+//--- Overlap
+
+bool overlaps(const Obb &a, const Obb &b) {
+  Vec2 ay = perpendicular(a.axis), by = perpendicular(b.axis);
+  Vec2 offset = b.center - a.center;
+  Vec2 axes[4] = {a.axis, ay, b.axis, by};
+  for (Vec2 axis : axes) {
+    float reachA = a.halfExtents.x * fabsf(dot(a.axis, axis)) +
+                   a.halfExtents.y * fabsf(dot(ay, axis));
+    float reachB = b.halfExtents.x * fabsf(dot(b.axis, axis)) +
+                   b.halfExtents.y * fabsf(dot(by, axis));
+    if (fabsf(dot(offset, axis)) > reachA + reachB) return false;
+  }
+  return true;
+}
+
+bool overlaps(const Obb &box, const Circle &c) {
+  Vec2 d = c.center - box.center;
+  Vec2 local = {dot(d, box.axis), dot(d, perpendicular(box.axis))};
+  Aabb extent = {-box.halfExtents, box.halfExtents};
+  return lengthSquared(local - closestPoint(extent, local)) <=
+         c.radius * c.radius;
+}
+
+bool overlaps(const Segment &a, const Segment &b) {
+  Vec2 edgeA = a.b - a.a, edgeB = b.b - b.a;
+  float a1 = cross(edgeB, a.a - b.a), a2 = cross(edgeB, a.b - b.a);
+  float b1 = cross(edgeA, b.a - a.a), b2 = cross(edgeA, b.b - a.a);
+  if (((a1 > 0 && a2 < 0) || (a1 < 0 && a2 > 0)) &&
+      ((b1 > 0 && b2 < 0) || (b1 < 0 && b2 > 0)))
+    return true;
+  // Touching or in line: an end of one lies on the other.
+  return (a1 == 0 && contains(bounds(b), a.a)) ||
+         (a2 == 0 && contains(bounds(b), a.b)) ||
+         (b1 == 0 && contains(bounds(a), b.a)) ||
+         (b2 == 0 && contains(bounds(a), b.b));
+}
+
+// Every lane is one of a's edges, and b's corners are taken one at a time;
+// the lanes past a.count repeat edge 0, which cannot change the result.
+float maxSeparation(const ConvexPolygon &a, const ConvexPolygon &b,
+                    int *edge) {
+#if LINEARMATH_SSE2
+  __m128 nx[2], ny[2], closest[2];
+  for (int half = 0; half < 2; half++) {
+    nx[half] = _mm_load_ps(a.normalX + 4 * half);
+    ny[half] = _mm_load_ps(a.normalY + 4 * half);
+    closest[half] = _mm_set1_ps(INFINITY);
+  }
+  for (int j = 0; j < b.count; j++) {
+    __m128 x = _mm_set1_ps(b.x[j]), y = _mm_set1_ps(b.y[j]);
+    for (int half = 0; half < 2; half++) {
+      __m128 d = _mm_add_ps(_mm_mul_ps(nx[half], x), _mm_mul_ps(ny[half], y));
+      closest[half] = _mm_min_ps(closest[half], d);
+    }
+  }
+  __m128 separation[2];
+  for (int half = 0; half < 2; half++) {
+    __m128 offset =
+        _mm_add_ps(_mm_mul_ps(nx[half], _mm_load_ps(a.x + 4 * half)),
+                   _mm_mul_ps(ny[half], _mm_load_ps(a.y + 4 * half)));
+    separation[half] = _mm_sub_ps(closest[half], offset);
+  }
+  __m128 best = _mm_max_ps(separation[0], separation[1]);
+  best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(2, 3, 0, 1)));
+  best = _mm_max_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+  int lanes = _mm_movemask_ps(_mm_cmpeq_ps(separation[0], best)) |
+              _mm_movemask_ps(_mm_cmpeq_ps(separation[1], best)) << 4;
+  int first = 0;
+  while (lanes && !(lanes & (1 << first))) first++;
+  *edge = first;
+  return _mm_cvtss_f32(best);
+#else
+  float best = -INFINITY;
+  *edge = 0;
+  for (int i = 0; i < a.count; i++) {
+    float closest = INFINITY;
+    for (int j = 0; j < b.count; j++) {
+      float d = a.normalX[i] * b.x[j] + a.normalY[i] * b.y[j];
+      closest = d < closest ? d : closest;
+    }
+    float separation =
+        closest - (a.normalX[i] * a.x[i] + a.normalY[i] * a.y[i]);
+    if (separation > best) {
+      best = separation;
+      *edge = i;
+    }
+  }
+  return best;
+#endif
+}
+
+bool overlaps(const ConvexPolygon &a, const ConvexPolygon &b) {
+  int edge;
+  return maxSeparation(a, b, &edge) <= 0 && maxSeparation(b, a, &edge) <= 0;
+}
+
+//--- Rays
+
+bool raycast(const Ray &ray, const Aabb &box, float maxT, RayHit *hit) {
+  return clipToBox(ray.origin, ray.direction, box.min, box.max, maxT, hit);
+}
+
+bool raycast(const Ray &ray, const Circle &c, float maxT, RayHit *hit) {
+  // |m + d t|^2 = r^2, as a t^2 + 2 b t + k = 0.
+  Vec2 m = ray.origin - c.center;
+  float k = dot(m, m) - c.radius * c.radius;
+  if (k <= 0) {
+    *hit = RayHit();
+    return true;
+  }
+  float a = dot(ray.direction, ray.direction), b = dot(m, ray.direction);
+  float discriminant = b * b - a * k;
+  if (b >= 0 || discriminant < 0) return false;
+  float t = (-b - sqrtf(discriminant)) / a;
+  if (t > maxT) return false;
+  hit->t = t;
+  hit->normal = normalize(m + ray.direction * t);
+  return true;
+}
+
+bool raycast(const Ray &ray, const Obb &box, float maxT, RayHit *hit) {
+  Vec2 y = perpendicular(box.axis), d = ray.origin - box.center;
+  Vec2 origin = {dot(d, box.axis), dot(d, y)};
+  Vec2 direction = {dot(ray.direction, box.axis), dot(ray.direction, y)};
+  if (!clipToBox(origin, direction, -box.halfExtents, box.halfExtents, maxT,
+                 hit))
+    return false;
+  hit->normal = box.axis * hit->normal.x + y * hit->normal.y;
+  return true;
+}
+
+bool raycast(const Ray &ray, const Segment &s, float maxT, RayHit *hit) {
+  // origin + direction t = a + edge u, solved with cross products.
+  Vec2 edge = s.b - s.a, offset = s.a - ray.origin;
+  float denominator = cross(ray.direction, edge);
+  if (denominator == 0) return false;  // parallel
+  float t = cross(offset, edge) / denominator;
+  float u = cross(offset, ray.direction) / denominator;
+  if (t < 0 || t > maxT || u < 0 || u > 1) return false;
+  Vec2 normal = normalize(perpendicular(edge));
+  hit->t = t;
+  hit->normal = dot(normal, ray.direction) > 0 ? -normal : normal;
+  return true;
+}
+
+// Cyrus-Beck: clip the ray against each edge's half-plane.
+bool raycast(const Ray &ray, const ConvexPolygon &polygon, float maxT,
+             RayHit *hit) {
+  if (polygon.count == 0) return false;
+  float lower = 0, upper = maxT;
+  int entered = -1;
+  for (int i = 0; i < polygon.count; i++) {
+    Vec2 normal = polygon.normal(i);
+    float numerator = dot(normal, polygon.vertex(i) - ray.origin);
+    float denominator = dot(normal, ray.direction);
+    if (denominator == 0) {
+      if (numerator < 0) return false;  // parallel and outside
+    } else if (denominator < 0) {
+      if (numerator < lower * denominator) {
+        lower = numerator / denominator;
+        entered = i;
+      }
+    } else if (numerator < upper * denominator) {
+      upper = numerator / denominator;
+    }
+    if (upper < lower) return false;
+  }
+  hit->t = lower;
+  hit->normal = entered < 0 ? Vec2() : polygon.normal(entered);
+  return true;
+}
+
+}  // namespace LinearMath
@@ -0,0 +1,175 @@
+#ifndef LINEARMATH_GEOMETRY_H
+#define LINEARMATH_GEOMETRY_H
+
+#include <math.h>
+
+#include "vector.h"
+
+namespace LinearMath {
+
+// 2D shapes and the tests between them, for collision, picking and culling.
+// Touching counts as overlapping. Tests over many shapes at once are in
+// batch.h.
+
+struct Aabb {
+  Vec2 min;
+  Vec2 max;
+
+  constexpr Vec2 center() const { return (min + max) * 0.5f; }
+  constexpr Vec2 halfExtents() const { return (max - min) * 0.5f; }
+  constexpr float perimeter() const {
+    return 2 * ((max.x - min.x) + (max.y - min.y));
+  }
+  constexpr Aabb expanded(float margin) const {
+    return {min - Vec2(margin), max + Vec2(margin)};
+  }
+};
+
+struct Circle {
+  Vec2 center;
+  float radius = 0;
+};
+
+// A box rotated about its center. `axis` is the box's unit x axis,
+// (cos, sin) of its rotation, as direction() gives.
+struct Obb {
+  Vec2 center;
+  Vec2 halfExtents;
+  Vec2 axis = {1, 0};
+};
+
+// Points at origin + direction * t for t >= 0. The direction need not be
+// unit length; t is measured in multiples of it, so a segment from a to b
+// is the ray (a, b - a) up to t = 1.
+struct Ray {
+  Vec2 origin;
+  Vec2 direction;
+
+  constexpr Vec2 at(float t) const { return origin + direction * t; }
+};
+
+struct Segment {
+  Vec2 a;
+  Vec2 b;
+};
+
+// Up to maxVertices corners, counter-clockwise, with the outward unit
+// normal of the edge from each to the next. The corners are stored as
+// separate x and y arrays with the unused slots repeating corner 0 and its
+// normal, so the SIMD tests can always read all of them.
+struct ConvexPolygon {
+  static constexpr int maxVertices = 8;
+
+  alignas(16) float x[maxVertices] = {};
+  alignas(16) float y[maxVertices] = {};
+  alignas(16) float normalX[maxVertices] = {};
+  alignas(16) float normalY[maxVertices] = {};
+  int count = 0;
+
+  /// Sets the polygon to the convex hull of the points. Returns 1 if the
+  /// hull has fewer than 3 corners (the points are all in a line) or more
+  /// than maxVertices; the polygon is left empty.
+  bool setPoints(const Vec2 *points, int pointCount);
+  static ConvexPolygon fromAabb(const Aabb &box);
+  static ConvexPolygon fromObb(const Obb &box);
+
+  constexpr Vec2 vertex(int i) const { return {x[i], y[i]}; }
+  constexpr Vec2 normal(int i) const { return {normalX[i], normalY[i]}; }
+};
+
+// Where a ray first meets a shape, at ray.at(t). A ray starting inside a
+// shape hits it at t = 0 with a zero normal.
+struct RayHit {
+  float t = 0;
+  Vec2 normal;
+};
+
+//--- Points
+
+constexpr bool contains(const Aabb &box, Vec2 p) {
+  return p.x >= box.min.x && p.x <= box.max.x && p.y >= box.min.y &&
+         p.y <= box.max.y;
+}
+constexpr bool contains(const Circle &c, Vec2 p) {
+  return lengthSquared(p - c.center) <= c.radius * c.radius;
+}
+inline bool contains(const Obb &box, Vec2 p) {
+  Vec2 d = p - box.center;
+  return fabsf(dot(d, box.axis)) <= box.halfExtents.x &&
+         fabsf(dot(d, perpendicular(box.axis))) <= box.halfExtents.y;
+}
+bool contains(const ConvexPolygon &polygon, Vec2 p);
+
+// Does not extend past the ends.
+constexpr Vec2 closestPoint(const Segment &s, Vec2 p) {
+  Vec2 edge = s.b - s.a;
+  float squared = dot(edge, edge);
+  if (squared <= 0) return s.a;
+  float t = dot(p - s.a, edge) / squared;
+  return s.a + edge * (t < 0 ? 0 : t > 1 ? 1 : t);
+}
+constexpr Vec2 closestPoint(const Aabb &box, Vec2 p) {
+  return max(box.min, min(p, box.max));
+}
+
+//--- Bounds
+
+constexpr Aabb bounds(const Circle &c) {
+  return {c.center - Vec2(c.radius), c.center + Vec2(c.radius)};
+}
+inline Aabb bounds(const Obb &box) {
+  Vec2 extent = {
+      fabsf(box.axis.x) * box.halfExtents.x +
+          fabsf(box.axis.y) * box.halfExtents.y,
+      fabsf(box.axis.y) * box.halfExtents.x +
+          fabsf(box.axis.x) * box.halfExtents.y};
+  return {box.center - extent, box.center + extent};
+}
+constexpr Aabb bounds(const Segment &s) {
+  return {min(s.a, s.b), max(s.a, s.b)};
+}
+Aabb bounds(const ConvexPolygon &polygon);
+constexpr Aabb merge(const Aabb &a, const Aabb &b) {
+  return {min(a.min, b.min), max(a.max, b.max)};
+}
+
+//--- Overlap
+
+constexpr bool overlaps(const Aabb &a, const Aabb &b) {
+  return a.min.x <= b.max.x && b.min.x <= a.max.x && a.min.y <= b.max.y &&
+         b.min.y <= a.max.y;
+}
+constexpr bool overlaps(const Circle &a, const Circle &b) {
+  float reach = a.radius + b.radius;
+  return lengthSquared(b.center - a.center) <= reach * reach;
+}
+constexpr bool overlaps(const Aabb &box, const Circle &c) {
+  return contains(c, closestPoint(box, c.center));
+}
+bool overlaps(const Obb &a, const Obb &b);
+bool overlaps(const Obb &box, const Circle &c);
+bool overlaps(const Segment &a, const Segment &b);
+// Separating axis test over both polygons' edge normals.
+bool overlaps(const ConvexPolygon &a, const ConvexPolygon &b);
+
+// The largest gap between the polygons along one of a's edge normals, and
+// that edge's index; negative when they overlap, when it is the depth of
+// the shallowest way out along a's normals.
+float maxSeparation(const ConvexPolygon &a, const ConvexPolygon &b,
+                    int *edge);
+
+//--- Rays
+// Each returns whether the ray meets the shape at some t in [0, maxT], and
+// if so fills `hit`.
+
+bool raycast(const Ray &ray, const Aabb &box, float maxT, RayHit *hit);
+bool raycast(const Ray &ray, const Circle &c, float maxT, RayHit *hit);
+bool raycast(const Ray &ray, const Obb &box, float maxT, RayHit *hit);
+// The normal faces back along the ray; segments have no inside.
+bool raycast(const Ray &ray, const Segment &s, float maxT, RayHit *hit);
+bool raycast(const Ray &ray, const ConvexPolygon &polygon, float maxT,
+             RayHit *hit);
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_GEOMETRY_H
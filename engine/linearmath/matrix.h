@@ -0,0 +1,244 @@
+#ifndef LINEARMATH_MATRIX_H
+#define LINEARMATH_MATRIX_H
+
+#include <math.h>
+
+#include "vector.h"
+
+namespace LinearMath {
+
+// Matrices are column-major and multiply column vectors (m * v), as OpenGL
+// and most shader code expect. Default construction gives the identity.
+
+struct Mat3 {
+  Vec3 columns[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+  constexpr Mat3() = default;
+  constexpr Mat3(Vec3 x, Vec3 y, Vec3 z) : columns{x, y, z} {}
+
+  constexpr Vec3 &operator[](int column) { return columns[column]; }
+  constexpr const Vec3 &operator[](int column) const {
+    return columns[column];
+  }
+
+  //--- 2D transforms in homogeneous coordinates
+  static constexpr Mat3 translation(Vec2 offset) {
+    return {{1, 0, 0}, {0, 1, 0}, {offset.x, offset.y, 1}};
+  }
+  static constexpr Mat3 scale(Vec2 factor) {
+    return {{factor.x, 0, 0}, {0, factor.y, 0}, {0, 0, 1}};
+  }
+  static inline Mat3 rotation(float radians) {  // counter-clockwise
+    float c = cosf(radians), s = sinf(radians);
+    return {{c, s, 0}, {-s, c, 0}, {0, 0, 1}};
+  }
+  constexpr Vec2 transformPoint(Vec2 p) const {
+    return {columns[0].x * p.x + columns[1].x * p.y + columns[2].x,
+            columns[0].y * p.x + columns[1].y * p.y + columns[2].y};
+  }
+  constexpr Vec2 transformVector(Vec2 v) const {
+    return {columns[0].x * v.x + columns[1].x * v.y,
+            columns[0].y * v.x + columns[1].y * v.y};
+  }
+};
+
+struct alignas(16) Mat4 {
+  Vec4 columns[4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+
+  constexpr Mat4() = default;
+  constexpr Mat4(Vec4 x, Vec4 y, Vec4 z, Vec4 w) : columns{x, y, z, w} {}
+  constexpr explicit Mat4(const Mat3 &m)
+      : columns{{m[0], 0}, {m[1], 0}, {m[2], 0}, {0, 0, 0, 1}} {}
+
+  constexpr Vec4 &operator[](int column) { return columns[column]; }
+  constexpr const Vec4 &operator[](int column) const {
+    return columns[column];
+  }
+
+  static constexpr Mat4 translation(Vec3 offset) {
+    return {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {offset, 1}};
+  }
+  static constexpr Mat4 scale(Vec3 factor) {
+    return {{factor.x, 0, 0, 0},
+            {0, factor.y, 0, 0},
+            {0, 0, factor.z, 0},
+            {0, 0, 0, 1}};
+  }
+  // Maps the box to clip space with z in [-1, 1], as OpenGL does.
+  static constexpr Mat4 orthographic(float left, float right, float bottom,
+                                     float top, float near, float far) {
+    return {{2 / (right - left), 0, 0, 0},
+            {0, 2 / (top - bottom), 0, 0},
+            {0, 0, -2 / (far - near), 0},
+            {-(right + left) / (right - left), -(top + bottom) / (top - bottom),
+             -(far + near) / (far - near), 1}};
+  }
+  static inline Mat4 perspective(float fieldOfViewY, float aspect, float near,
+                                 float far) {
+    float f = 1 / tanf(fieldOfViewY / 2);
+    return {{f / aspect, 0, 0, 0},
+            {0, f, 0, 0},
+            {0, 0, (far + near) / (near - far), -1},
+            {0, 0, 2 * far * near / (near - far), 0}};
+  }
+  static inline Mat4 lookAt(Vec3 eye, Vec3 target, Vec3 up) {
+    Vec3 forward = normalize(target - eye);
+    Vec3 side = normalize(cross(forward, up));
+    Vec3 upward = cross(side, forward);
+    return {{side.x, upward.x, -forward.x, 0},
+            {side.y, upward.y, -forward.y, 0},
+            {side.z, upward.z, -forward.z, 0},
+            {-dot(side, eye), -dot(upward, eye), dot(forward, eye), 1}};
+  }
+
+  constexpr Vec3 transformPoint(Vec3 p) const;   // w = 1, no divide
+  constexpr Vec3 transformVector(Vec3 v) const;  // w = 0
+};
+
+//--- Mat3
+
+constexpr Vec3 operator*(const Mat3 &m, Vec3 v) {
+  return m[0] * v.x + m[1] * v.y + m[2] * v.z;
+}
+constexpr Mat3 operator*(const Mat3 &a, const Mat3 &b) {
+  return {a * b[0], a * b[1], a * b[2]};
+}
+constexpr bool operator==(const Mat3 &a, const Mat3 &b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+}
+constexpr bool operator!=(const Mat3 &a, const Mat3 &b) { return !(a == b); }
+
+constexpr Mat3 transpose(const Mat3 &m) {
+  return {{m[0].x, m[1].x, m[2].x},
+          {m[0].y, m[1].y, m[2].y},
+          {m[0].z, m[1].z, m[2].z}};
+}
+constexpr float determinant(const Mat3 &m) {
+  return dot(m[0], cross(m[1], m[2]));
+}
+// The matrix must be invertible; a singular one gives infinities.
+constexpr Mat3 inverse(const Mat3 &m) {
+  // The rows of the inverse are these cross products over the determinant.
+  Vec3 r0 = cross(m[1], m[2]), r1 = cross(m[2], m[0]), r2 = cross(m[0], m[1]);
+  float scale = 1 / dot(m[0], r0);
+  return transpose(Mat3(r0 * scale, r1 * scale, r2 * scale));
+}
+
+//--- Mat4
+
+constexpr Vec4 operator*(const Mat4 &m, Vec4 v) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) {
+    __m128 r = _mm_mul_ps(m[0].load(), _mm_set1_ps(v.x));
+    r = _mm_add_ps(r, _mm_mul_ps(m[1].load(), _mm_set1_ps(v.y)));
+    r = _mm_add_ps(r, _mm_mul_ps(m[2].load(), _mm_set1_ps(v.z)));
+    r = _mm_add_ps(r, _mm_mul_ps(m[3].load(), _mm_set1_ps(v.w)));
+    return Vec4::store(r);
+  }
+#endif
+  return {m[0].x * v.x + m[1].x * v.y + m[2].x * v.z + m[3].x * v.w,
+          m[0].y * v.x + m[1].y * v.y + m[2].y * v.z + m[3].y * v.w,
+          m[0].z * v.x + m[1].z * v.y + m[2].z * v.z + m[3].z * v.w,
+          m[0].w * v.x + m[1].w * v.y + m[2].w * v.z + m[3].w * v.w};
+}
+
+constexpr Mat4 operator*(const Mat4 &a, const Mat4 &b) {
+#if LINEARMATH_AVX
+  if (LINEARMATH_RUNTIME()) {
+    auto column = [](const Mat4 &m, int i) {
+      return _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(&m[i].x));
+    };
+    // Two result columns per register, each half a's column k scaled by
+    // element k of the matching column of b. Unaligned, as Mat4 is only
+    // 16-byte aligned.
+    Mat4 r;
+    for (int pair = 0; pair < 4; pair += 2) {
+      __m256 columns = _mm256_loadu_ps(&b[pair].x);
+      __m256 sum = _mm256_mul_ps(column(a, 0),
+                                 _mm256_shuffle_ps(columns, columns, 0x00));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(column(a, 1),
+                                             _mm256_shuffle_ps(columns, columns,
+                                                               0x55)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(column(a, 2),
+                                             _mm256_shuffle_ps(columns, columns,
+                                                               0xaa)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(column(a, 3),
+                                             _mm256_shuffle_ps(columns, columns,
+                                                               0xff)));
+      _mm256_storeu_ps(&r[pair].x, sum);
+    }
+    return r;
+  }
+#endif
+  return {a * b[0], a * b[1], a * b[2], a * b[3]};
+}
+constexpr bool operator==(const Mat4 &a, const Mat4 &b) {
+  return a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+constexpr bool operator!=(const Mat4 &a, const Mat4 &b) { return !(a == b); }
+
+constexpr Vec3 Mat4::transformPoint(Vec3 p) const {
+  return (*this * Vec4(p, 1)).xyz();
+}
+constexpr Vec3 Mat4::transformVector(Vec3 v) const {
+  return (*this * Vec4(v, 0)).xyz();
+}
+
+constexpr Mat4 transpose(const Mat4 &m) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) {
+    __m128 c0 = m[0].load(), c1 = m[1].load(), c2 = m[2].load(),
+           c3 = m[3].load();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    return {Vec4::store(c0), Vec4::store(c1), Vec4::store(c2),
+            Vec4::store(c3)};
+  }
+#endif
+  return {{m[0].x, m[1].x, m[2].x, m[3].x},
+          {m[0].y, m[1].y, m[2].y, m[3].y},
+          {m[0].z, m[1].z, m[2].z, m[3].z},
+          {m[0].w, m[1].w, m[2].w, m[3].w}};
+}
+
+// General inverse by cofactors. The matrix must be invertible; a singular
+// one gives infinities.
+constexpr Mat4 inverse(const Mat4 &m) {
+  // 2x2 minors of the top two and bottom two rows.
+  float s0 = m[0].x * m[1].y - m[1].x * m[0].y;
+  float s1 = m[0].x * m[2].y - m[2].x * m[0].y;
+  float s2 = m[0].x * m[3].y - m[3].x * m[0].y;
+  float s3 = m[1].x * m[2].y - m[2].x * m[1].y;
+  float s4 = m[1].x * m[3].y - m[3].x * m[1].y;
+  float s5 = m[2].x * m[3].y - m[3].x * m[2].y;
+  float c5 = m[2].z * m[3].w - m[3].z * m[2].w;
+  float c4 = m[1].z * m[3].w - m[3].z * m[1].w;
+  float c3 = m[1].z * m[2].w - m[2].z * m[1].w;
+  float c2 = m[0].z * m[3].w - m[3].z * m[0].w;
+  float c1 = m[0].z * m[2].w - m[2].z * m[0].w;
+  float c0 = m[0].z * m[1].w - m[1].z * m[0].w;
+  float scale =
+      1 / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+  Mat4 r;
+  r[0] = {(m[1].y * c5 - m[2].y * c4 + m[3].y * c3) * scale,
+          (-m[0].y * c5 + m[2].y * c2 - m[3].y * c1) * scale,
+          (m[0].y * c4 - m[1].y * c2 + m[3].y * c0) * scale,
+          (-m[0].y * c3 + m[1].y * c1 - m[2].y * c0) * scale};
+  r[1] = {(-m[1].x * c5 + m[2].x * c4 - m[3].x * c3) * scale,
+          (m[0].x * c5 - m[2].x * c2 + m[3].x * c1) * scale,
+          (-m[0].x * c4 + m[1].x * c2 - m[3].x * c0) * scale,
+          (m[0].x * c3 - m[1].x * c1 + m[2].x * c0) * scale};
+  r[2] = {(m[1].w * s5 - m[2].w * s4 + m[3].w * s3) * scale,
+          (-m[0].w * s5 + m[2].w * s2 - m[3].w * s1) * scale,
+          (m[0].w * s4 - m[1].w * s2 + m[3].w * s0) * scale,
+          (-m[0].w * s3 + m[1].w * s1 - m[2].w * s0) * scale};
+  r[3] = {(-m[1].z * s5 + m[2].z * s4 - m[3].z * s3) * scale,
+          (m[0].z * s5 - m[2].z * s2 + m[3].z * s1) * scale,
+          (-m[0].z * s4 + m[1].z * s2 - m[3].z * s0) * scale,
+          (m[0].z * s3 - m[1].z * s1 + m[2].z * s0) * scale};
+  return r;
+}
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_MATRIX_H
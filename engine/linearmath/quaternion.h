@@ -0,0 +1,117 @@
+#ifndef LINEARMATH_QUATERNION_H
+#define LINEARMATH_QUATERNION_H
+
+#include <math.h>
+
+#include "matrix.h"
+
+namespace LinearMath {
+
+// Rotations as unit quaternions, (x, y, z) the vector part and w the
+// scalar. Products compose like matrices: (a * b) rotates by b, then a.
+struct alignas(16) Quat {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+  float w = 1;
+
+  constexpr Quat() = default;
+  constexpr Quat(float x, float y, float z, float w)
+      : x(x), y(y), z(z), w(w) {}
+
+  // `axis` must be unit length.
+  static inline Quat fromAxisAngle(Vec3 axis, float radians) {
+    float s = sinf(radians / 2);
+    return {axis.x * s, axis.y * s, axis.z * s, cosf(radians / 2)};
+  }
+  // A 2D rotation, counter-clockwise about +z.
+  static inline Quat fromAngle(float radians) {
+    return {0, 0, sinf(radians / 2), cosf(radians / 2)};
+  }
+
+  constexpr Vec4 toVec4() const { return {x, y, z, w}; }
+  static constexpr Quat fromVec4(Vec4 v) { return {v.x, v.y, v.z, v.w}; }
+};
+
+constexpr Quat operator*(Quat a, Quat b) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) {
+    // Each lane of b is scaled by one component of a, with the signs of the
+    // Hamilton product.
+    __m128 qa = _mm_load_ps(&a.x), qb = _mm_load_ps(&b.x);
+    auto term = [&](__m128 lane, __m128 from, __m128 signs) {
+      return _mm_xor_ps(signs, _mm_mul_ps(lane, from));
+    };
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(3, 3, 3, 3)), qb);
+    r = _mm_add_ps(r, term(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(0, 0, 0, 0)),
+                           _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(0, 1, 2, 3)),
+                           _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f)));
+    r = _mm_add_ps(r, term(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(1, 1, 1, 1)),
+                           _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(1, 0, 3, 2)),
+                           _mm_set_ps(-0.0f, -0.0f, 0.0f, 0.0f)));
+    r = _mm_add_ps(r, term(_mm_shuffle_ps(qa, qa, _MM_SHUFFLE(2, 2, 2, 2)),
+                           _mm_shuffle_ps(qb, qb, _MM_SHUFFLE(2, 3, 0, 1)),
+                           _mm_set_ps(-0.0f, 0.0f, 0.0f, -0.0f)));
+    Quat q;
+    _mm_store_ps(&q.x, r);
+    return q;
+  }
+#endif
+  return {a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+          a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+          a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+          a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z};
+}
+constexpr bool operator==(Quat a, Quat b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+}
+constexpr bool operator!=(Quat a, Quat b) { return !(a == b); }
+
+constexpr float dot(Quat a, Quat b) { return dot(a.toVec4(), b.toVec4()); }
+// The inverse of a unit quaternion.
+constexpr Quat conjugate(Quat q) { return {-q.x, -q.y, -q.z, q.w}; }
+inline Quat normalize(Quat q) {
+  return Quat::fromVec4(normalize(q.toVec4()));
+}
+
+constexpr Vec3 rotate(Quat q, Vec3 v) {
+  // v + 2w(u x v) + 2u x (u x v), u the vector part.
+  Vec3 u(q.x, q.y, q.z);
+  Vec3 t = cross(u, v) * 2;
+  return v + t * q.w + cross(u, t);
+}
+constexpr Vec2 rotate(Quat q, Vec2 v) { return rotate(q, Vec3(v, 0)).xy(); }
+
+// Normalised linear interpolation along the shorter arc; cheaper than
+// slerp and close enough for small steps.
+inline Quat nlerp(Quat a, Quat b, float t) {
+  Vec4 to = dot(a, b) < 0 ? -b.toVec4() : b.toVec4();
+  return Quat::fromVec4(normalize(lerp(a.toVec4(), to, t)));
+}
+inline Quat slerp(Quat a, Quat b, float t) {
+  float cosine = dot(a, b);
+  Vec4 to = b.toVec4();
+  if (cosine < 0) {
+    cosine = -cosine;
+    to = -to;
+  }
+  if (cosine > 0.9995f) return nlerp(a, Quat::fromVec4(to), t);
+  float angle = acosf(cosine);
+  float scale = 1 / sinf(angle);
+  return Quat::fromVec4(a.toVec4() * (sinf((1 - t) * angle) * scale) +
+                        to * (sinf(t * angle) * scale));
+}
+
+constexpr Mat3 toMat3(Quat q) {
+  float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+  float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+  float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+  return {{1 - 2 * (yy + zz), 2 * (xy + wz), 2 * (xz - wy)},
+          {2 * (xy - wz), 1 - 2 * (xx + zz), 2 * (yz + wx)},
+          {2 * (xz + wy), 2 * (yz - wx), 1 - 2 * (xx + yy)}};
+}
+constexpr Mat4 toMat4(Quat q) { return Mat4(toMat3(q)); }
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_QUATERNION_H
@@ -0,0 +1,202 @@
+#ifndef LINEARMATH_RANDOM_H
+#define LINEARMATH_RANDOM_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <utility>
+
+#include "trig.h"
+
+// Small, fast generators and distributions whose output is fixed by the
+// seed alone, unlike <random>'s distributions, which differ between
+// standard libraries. Everything here is integer arithmetic or IEEE
+// +, -, *, / and sqrt, plus the trig.h approximations built from the same,
+// so a replay gives the same numbers on every machine running the same
+// build. (A build that lets the compiler fuse multiply-adds, e.g. -mfma
+// with -ffp-contract=fast, gets different last bits from one that doesn't.)
+//
+// Generators provide next() and meet UniformRandomBitGenerator. Avoid
+// handing them to std::shuffle or std distributions if results must
+// match across platforms; use the functions below.
+
+namespace LinearMath {
+
+// PCG-XSH-RR: 64 bits of state, 32-bit output. Generators seeded alike but
+// with different streams give unrelated sequences, and advance() skips
+// ahead in O(log n), e.g. to resynchronise a replay.
+class Pcg32 {
+ public:
+  using result_type = uint32_t;
+
+  constexpr explicit Pcg32(uint64_t seed = 0x853c49e6748fea9bULL,
+                           uint64_t stream = 0xda3e39cb94b95bdbULL)
+      : state(0), increment((stream << 1) | 1) {
+    next();
+    state += seed;
+    next();
+  }
+
+  constexpr uint32_t next() {
+    uint64_t old = state;
+    state = old * multiplier + increment;
+    uint32_t shifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (shifted >> rotation) | (shifted << ((32 - rotation) & 31));
+  }
+  constexpr void advance(uint64_t steps) {
+    uint64_t multiply = 1, add = 0;
+    uint64_t stepMultiply = multiplier, stepAdd = increment;
+    for (; steps; steps >>= 1) {
+      if (steps & 1) {
+        multiply *= stepMultiply;
+        add = add * stepMultiply + stepAdd;
+      }
+      stepAdd = (stepMultiply + 1) * stepAdd;
+      stepMultiply *= stepMultiply;
+    }
+    state = multiply * state + add;
+  }
+
+  constexpr uint32_t operator()() { return next(); }
+  static constexpr uint32_t min() { return 0; }
+  static constexpr uint32_t max() { return 0xffffffffu; }
+
+  // Both words are the whole state, for saving alongside a replay.
+  uint64_t state;
+  uint64_t increment;
+
+ private:
+  static constexpr uint64_t multiplier = 6364136223846793005ULL;
+};
+
+// xoshiro128+: 128 bits of state and only adds, xors and shifts, so it is
+// the fastest here and the one Batch::Random runs 16 of side by side. The
+// lowest bits are weaker than the rest; the distributions below only use
+// the top ones.
+class Xoshiro128Plus {
+ public:
+  using result_type = uint32_t;
+
+  // The state comes from SplitMix64, so nearby seeds are unrelated.
+  constexpr explicit Xoshiro128Plus(uint64_t seed = 0) : s() {
+    for (int i = 0; i < 4; i += 2) {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      z ^= z >> 31;
+      s[i] = static_cast<uint32_t>(z);
+      s[i + 1] = static_cast<uint32_t>(z >> 32);
+    }
+  }
+
+  constexpr uint32_t next() {
+    uint32_t result = s[0] + s[3];
+    uint32_t t = s[1] << 9;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+    return result;
+  }
+  // Skips 2^64 outputs; successive jumps give non-overlapping streams.
+  constexpr void jump() {
+    constexpr uint32_t polynomial[4] = {0x8764000b, 0xf542d2d3, 0x6fa035c3,
+                                        0x77f2db5b};
+    uint32_t jumped[4] = {};
+    for (uint32_t word : polynomial) {
+      for (int bit = 0; bit < 32; bit++) {
+        if (word & (1u << bit))
+          for (int i = 0; i < 4; i++) jumped[i] ^= s[i];
+        next();
+      }
+    }
+    for (int i = 0; i < 4; i++) s[i] = jumped[i];
+  }
+
+  constexpr uint32_t operator()() { return next(); }
+  static constexpr uint32_t min() { return 0; }
+  static constexpr uint32_t max() { return 0xffffffffu; }
+
+  uint32_t s[4];
+};
+
+//--- Distributions
+
+// [0, 1) from the top 24 bits; every value is exact.
+constexpr float unitFloat(uint32_t bits) {
+  return static_cast<float>(bits >> 8) * (1.0f / 16777216);
+}
+
+template <typename Generator>
+float uniform(Generator &g) {
+  return unitFloat(g.next());
+}
+// [lo, hi); hi itself only through rounding.
+template <typename Generator>
+float uniform(Generator &g, float lo, float hi) {
+  return lo + (hi - lo) * unitFloat(g.next());
+}
+// [0, bound) without bias, by Lemire's multiply-and-reject.
+template <typename Generator>
+uint32_t uniformInt(Generator &g, uint32_t bound) {
+  uint64_t product = static_cast<uint64_t>(g.next()) * bound;
+  if (static_cast<uint32_t>(product) < bound) {
+    uint32_t threshold = (0u - bound) % bound;
+    while (static_cast<uint32_t>(product) < threshold)
+      product = static_cast<uint64_t>(g.next()) * bound;
+  }
+  return static_cast<uint32_t>(product >> 32);
+}
+// [lo, hi], both inclusive.
+template <typename Generator>
+int uniformInt(Generator &g, int lo, int hi) {
+  uint32_t span = static_cast<uint32_t>(hi) - static_cast<uint32_t>(lo) + 1;
+  uint32_t offset = span ? uniformInt(g, span) : g.next();
+  return static_cast<int>(static_cast<uint32_t>(lo) + offset);
+}
+template <typename Generator>
+bool chance(Generator &g, float probability) {
+  return unitFloat(g.next()) < probability;
+}
+
+// Box-Muller; uses two draws and keeps one of the pair.
+template <typename Generator>
+float normal(Generator &g, float mean = 0, float deviation = 1) {
+  float u = 1 - unitFloat(g.next());  // (0, 1], so the log is finite
+  float angle = tau * unitFloat(g.next());
+  return mean + deviation * sqrtf(-2 * fastLog(u)) * fastCos(angle);
+}
+
+template <typename Generator>
+Vec2 onCircle(Generator &g) {
+  return direction(tau * unitFloat(g.next()));
+}
+// Uniform over the unit disc.
+template <typename Generator>
+Vec2 inCircle(Generator &g) {
+  float radius = sqrtf(unitFloat(g.next()));
+  return direction(tau * unitFloat(g.next())) * radius;
+}
+// Uniform over the unit sphere's surface (Archimedes: z is uniform).
+template <typename Generator>
+Vec3 onSphere(Generator &g) {
+  float z = 2 * unitFloat(g.next()) - 1;
+  float radius = sqrtf(1 - z * z);
+  return Vec3(direction(tau * unitFloat(g.next())) * radius, z);
+}
+
+// Fisher-Yates; the same order everywhere, unlike std::shuffle.
+template <typename Generator, typename T>
+void shuffle(Generator &g, T *items, size_t count) {
+  for (size_t i = count; i > 1; i--) {
+    size_t j = uniformInt(g, static_cast<uint32_t>(i));
+    std::swap(items[i - 1], items[j]);
+  }
+}
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_RANDOM_H
@@ -0,0 +1,38 @@
+#ifndef LINEARMATH_REAL_H
+#define LINEARMATH_REAL_H
+
+#include "fixed.h"
+#include "trig.h"
+#include "vector.h"
+
+// The number types simulation code is written against. They are floats by
+// default; building with -DENGINE_FIXED_POINT=1 makes them the Fixed types,
+// whose results are identical on every machine, for lockstep multiplayer
+// and replays.
+//
+// Code that compiles either way sticks to what both share: arithmetic and
+// comparisons, explicit construction from constants (Real(0.5f)),
+// static_cast to float for output, and abs, floor, sqrt, sin, cos, atan2,
+// lerp, dot, cross, length, distance, normalize, direction and angleOf.
+// Fixed has a smaller range (see fixed.h); keep within it in both modes so
+// that switching changes precision, not behavior.
+
+#ifndef ENGINE_FIXED_POINT
+#define ENGINE_FIXED_POINT 0
+#endif
+
+namespace LinearMath {
+
+#if ENGINE_FIXED_POINT
+using Real = Fixed;
+using RealVec2 = FixedVec2;
+using RealVec3 = FixedVec3;
+#else
+using Real = float;
+using RealVec2 = Vec2;
+using RealVec3 = Vec3;
+#endif
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_REAL_H
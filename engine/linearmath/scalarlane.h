@@ -0,0 +1,73 @@
+#ifndef LINEARMATH_SCALARLANE_H
+#define LINEARMATH_SCALARLANE_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <cstddef>
+
+// The one-lane register that approx.h and batchkernels.h are written
+// against; batch.cpp defines the 4, 8 and 16 lane ones with the same
+// operations. Bitwise operators work on the IEEE bit patterns.
+
+namespace LinearMath {
+namespace ScalarLane {
+#define BATCH_TARGET
+#define BATCH_INLINE inline
+
+struct F {
+  static constexpr size_t width = 1;
+  static F load(const float *p) { return {*p}; }
+  static F set(float s) { return {s}; }
+  static F loadBits(const uint32_t *p) { return setBits(*p); }
+  static F setBits(uint32_t bits) {
+    F f;
+    memcpy(&f.v, &bits, sizeof(bits));
+    return f;
+  }
+  void store(float *p) const { *p = v; }
+  uint32_t bits() const {
+    uint32_t b;
+    memcpy(&b, &v, sizeof(b));
+    return b;
+  }
+  float v;
+};
+using Mask = bool;
+
+inline F operator+(F a, F b) { return {a.v + b.v}; }
+inline F operator-(F a, F b) { return {a.v - b.v}; }
+inline F operator*(F a, F b) { return {a.v * b.v}; }
+inline F operator/(F a, F b) { return {a.v / b.v}; }
+inline F operator&(F a, F b) { return F::setBits(a.bits() & b.bits()); }
+inline F operator|(F a, F b) { return F::setBits(a.bits() | b.bits()); }
+inline F operator^(F a, F b) { return F::setBits(a.bits() ^ b.bits()); }
+inline Mask operator<(F a, F b) { return a.v < b.v; }
+inline Mask operator>(F a, F b) { return a.v > b.v; }
+inline Mask operator<=(F a, F b) { return a.v <= b.v; }
+inline Mask operator>=(F a, F b) { return a.v >= b.v; }
+// Lane i of the mask as bit i.
+inline unsigned maskBits(Mask m) { return m; }
+inline F select(Mask m, F ifTrue, F ifFalse) { return m ? ifTrue : ifFalse; }
+inline F abs(F a) { return {fabsf(a.v)}; }
+inline F min(F a, F b) { return {a.v < b.v ? a.v : b.v}; }
+inline F max(F a, F b) { return {a.v > b.v ? a.v : b.v}; }
+inline F sqrt(F a) { return {sqrtf(a.v)}; }
+inline F safeInverseSqrt(F s) { return {s.v > 0 ? 1 / sqrtf(s.v) : 1}; }
+// The float whose bits are the integer a (which must be whole).
+inline F floatWithBits(F a) {
+  return F::setBits(static_cast<uint32_t>(static_cast<int32_t>(a.v)));
+}
+// a's bits read as a signed integer.
+inline F bitsAsNumber(F a) {
+  return {static_cast<float>(static_cast<int32_t>(a.bits()))};
+}
+
+#include "approx.h"
+#undef BATCH_TARGET
+#undef BATCH_INLINE
+}  // namespace ScalarLane
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_SCALARLANE_H
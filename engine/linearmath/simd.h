@@ -0,0 +1,36 @@
+#ifndef LINEARMATH_SIMD_H
+#define LINEARMATH_SIMD_H
+
+// Which instruction sets the LinearMath types may use. Build with
+// -DENGINE_SIMD=0 to force the scalar code everywhere, e.g. to compare
+// results. AVX is only used when the compiler targets it (-mavx); runtime
+// dispatch is for the batch kernels, not the per-object types.
+
+#ifndef ENGINE_SIMD
+#define ENGINE_SIMD 1
+#endif
+
+#if ENGINE_SIMD && (defined(__SSE2__) || defined(_M_X64) || \
+                    (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define LINEARMATH_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define LINEARMATH_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+
+// The SIMD paths sit behind this so the same functions stay usable in
+// constant expressions. Without the builtin, the scalar path is always used.
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define LINEARMATH_RUNTIME() (!__builtin_is_constant_evaluated())
+#endif
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+#define LINEARMATH_RUNTIME() (!__builtin_is_constant_evaluated())
+#endif
+#ifndef LINEARMATH_RUNTIME
+#define LINEARMATH_RUNTIME() false
+#endif
+
+#endif  // LINEARMATH_SIMD_H
@@ -0,0 +1,83 @@
+#ifndef LINEARMATH_TRIG_H
+#define LINEARMATH_TRIG_H
+
+#include "matrix.h"
+#include "scalarlane.h"
+
+namespace LinearMath {
+
+constexpr float pi = 3.14159265358979f;
+constexpr float tau = 6.28318530717959f;
+
+// Branch-free approximations for hot loops. One at a time they run about
+// as fast as <math.h>; the gain is in the Batch forms over arrays, which
+// are several times faster at every SIMD level. Worst errors measured
+// against double precision:
+//   fastSin, fastCos  8e-8 absolute for |x| <= 8192, 1e-6 up to 65536;
+//                     wrap larger angles first
+//   fastAtan2         3e-7 radians; (0, 0) gives 0
+//   fastExp           4e-7 relative; +inf above 88.72, 0 below -87.33
+//   fastLog           8e-8 relative (absolute for results within 1 of
+//                     0); -inf for 0 and subnormals, NaN below 0
+// NaN inputs give unspecified results.
+
+inline void fastSinCos(float radians, float *sine, float *cosine) {
+  ScalarLane::F s, c;
+  ScalarLane::sinCos(ScalarLane::F::set(radians), &s, &c);
+  *sine = s.v;
+  *cosine = c.v;
+}
+inline float fastSin(float radians) {
+  float s, c;
+  fastSinCos(radians, &s, &c);
+  return s;
+}
+inline float fastCos(float radians) {
+  float s, c;
+  fastSinCos(radians, &s, &c);
+  return c;
+}
+inline float fastAtan2(float y, float x) {
+  return ScalarLane::atan2(ScalarLane::F::set(y), ScalarLane::F::set(x)).v;
+}
+inline float fastExp(float x) {
+  return ScalarLane::exp(ScalarLane::F::set(x)).v;
+}
+inline float fastLog(float x) {
+  return ScalarLane::log(ScalarLane::F::set(x)).v;
+}
+
+//--- Angles
+
+// To [-pi, pi].
+inline float wrapAngle(float radians) {
+  using ScalarLane::F;
+  return radians - tau * roundSmall(F::set(radians / tau)).v;
+}
+// The signed turn from `from` to `to` the short way round.
+inline float angleDifference(float from, float to) {
+  return wrapAngle(to - from);
+}
+// The unit vector at `radians` counter-clockwise from +x.
+inline Vec2 direction(float radians) {
+  Vec2 d;
+  fastSinCos(radians, &d.y, &d.x);
+  return d;
+}
+inline float angleOf(Vec2 v) { return fastAtan2(v.y, v.x); }
+inline Vec2 rotate(Vec2 v, float radians) {
+  Vec2 d = direction(radians);
+  return {d.x * v.x - d.y * v.y, d.y * v.x + d.x * v.y};
+}
+// translation(t) * rotation(radians) * scale(s) without the products, for
+// sprites and other 2D nodes.
+inline Mat3 transform2D(Vec2 translation, float radians, Vec2 scale) {
+  Vec2 d = direction(radians);
+  return {{d.x * scale.x, d.y * scale.x, 0},
+          {-d.y * scale.y, d.x * scale.y, 0},
+          {translation.x, translation.y, 1}};
+}
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_TRIG_H
@@ -0,0 +1,272 @@
+#ifndef LINEARMATH_VECTOR_H
+#define LINEARMATH_VECTOR_H
+
+#include <math.h>
+
+#include "simd.h"
+
+namespace LinearMath {
+
+// Vec2 and Vec3 are tightly packed so arrays of them can be handed to
+// renderers and file formats as-is; they are left to the compiler's
+// auto-vectoriser, apart from the Vec3 cross product. Vec4 is 16-byte
+// aligned and uses SSE where available.
+// Bulk work belongs in the batch kernels, not loops over these.
+
+struct Vec2 {
+  float x = 0;
+  float y = 0;
+
+  constexpr Vec2() = default;
+  constexpr Vec2(float x, float y) : x(x), y(y) {}
+  constexpr explicit Vec2(float scalar) : x(scalar), y(scalar) {}
+
+  constexpr float &operator[](int i) { return i ? y : x; }
+  constexpr float operator[](int i) const { return i ? y : x; }
+
+  constexpr Vec2 &operator+=(Vec2 o) { return *this = {x + o.x, y + o.y}; }
+  constexpr Vec2 &operator-=(Vec2 o) { return *this = {x - o.x, y - o.y}; }
+  constexpr Vec2 &operator*=(Vec2 o) { return *this = {x * o.x, y * o.y}; }
+  constexpr Vec2 &operator*=(float s) { return *this = {x * s, y * s}; }
+  constexpr Vec2 &operator/=(float s) { return *this = {x / s, y / s}; }
+};
+
+struct Vec3 {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+
+  constexpr Vec3() = default;
+  constexpr Vec3(float x, float y, float z) : x(x), y(y), z(z) {}
+  constexpr Vec3(Vec2 xy, float z) : x(xy.x), y(xy.y), z(z) {}
+  constexpr explicit Vec3(float scalar) : x(scalar), y(scalar), z(scalar) {}
+
+  constexpr Vec2 xy() const { return {x, y}; }
+  constexpr float &operator[](int i) { return i == 0 ? x : i == 1 ? y : z; }
+  constexpr float operator[](int i) const {
+    return i == 0 ? x : i == 1 ? y : z;
+  }
+
+  constexpr Vec3 &operator+=(Vec3 o) {
+    return *this = {x + o.x, y + o.y, z + o.z};
+  }
+  constexpr Vec3 &operator-=(Vec3 o) {
+    return *this = {x - o.x, y - o.y, z - o.z};
+  }
+  constexpr Vec3 &operator*=(Vec3 o) {
+    return *this = {x * o.x, y * o.y, z * o.z};
+  }
+  constexpr Vec3 &operator*=(float s) { return *this = {x * s, y * s, z * s}; }
+  constexpr Vec3 &operator/=(float s) { return *this = {x / s, y / s, z / s}; }
+};
+
+struct alignas(16) Vec4 {
+  float x = 0;
+  float y = 0;
+  float z = 0;
+  float w = 0;
+
+  constexpr Vec4() = default;
+  constexpr Vec4(float x, float y, float z, float w)
+      : x(x), y(y), z(z), w(w) {}
+  constexpr Vec4(Vec3 xyz, float w) : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
+  constexpr explicit Vec4(float scalar)
+      : x(scalar), y(scalar), z(scalar), w(scalar) {}
+
+  constexpr Vec2 xy() const { return {x, y}; }
+  constexpr Vec3 xyz() const { return {x, y, z}; }
+  constexpr float &operator[](int i) {
+    return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
+  }
+  constexpr float operator[](int i) const {
+    return i == 0 ? x : i == 1 ? y : i == 2 ? z : w;
+  }
+
+#if LINEARMATH_SSE2
+  __m128 load() const { return _mm_load_ps(&x); }
+  static Vec4 store(__m128 value) {
+    Vec4 v;
+    _mm_store_ps(&v.x, value);
+    return v;
+  }
+#endif
+
+  constexpr Vec4 &operator+=(Vec4 o);
+  constexpr Vec4 &operator-=(Vec4 o);
+  constexpr Vec4 &operator*=(Vec4 o);
+  constexpr Vec4 &operator*=(float s);
+  constexpr Vec4 &operator/=(float s) { return *this *= 1 / s; }
+};
+
+//--- Vec2
+
+constexpr Vec2 operator-(Vec2 a) { return {-a.x, -a.y}; }
+constexpr Vec2 operator+(Vec2 a, Vec2 b) { return a += b; }
+constexpr Vec2 operator-(Vec2 a, Vec2 b) { return a -= b; }
+constexpr Vec2 operator*(Vec2 a, Vec2 b) { return a *= b; }
+constexpr Vec2 operator*(Vec2 a, float s) { return a *= s; }
+constexpr Vec2 operator*(float s, Vec2 a) { return a *= s; }
+constexpr Vec2 operator/(Vec2 a, float s) { return a /= s; }
+constexpr bool operator==(Vec2 a, Vec2 b) { return a.x == b.x && a.y == b.y; }
+constexpr bool operator!=(Vec2 a, Vec2 b) { return !(a == b); }
+
+constexpr float dot(Vec2 a, Vec2 b) { return a.x * b.x + a.y * b.y; }
+// The z of the 3D cross product: positive if b is counter-clockwise of a.
+constexpr float cross(Vec2 a, Vec2 b) { return a.x * b.y - a.y * b.x; }
+constexpr Vec2 perpendicular(Vec2 a) { return {-a.y, a.x}; }  // +90 degrees
+constexpr Vec2 min(Vec2 a, Vec2 b) {
+  return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y};
+}
+constexpr Vec2 max(Vec2 a, Vec2 b) {
+  return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y};
+}
+
+//--- Vec3
+
+constexpr Vec3 operator-(Vec3 a) { return {-a.x, -a.y, -a.z}; }
+constexpr Vec3 operator+(Vec3 a, Vec3 b) { return a += b; }
+constexpr Vec3 operator-(Vec3 a, Vec3 b) { return a -= b; }
+constexpr Vec3 operator*(Vec3 a, Vec3 b) { return a *= b; }
+constexpr Vec3 operator*(Vec3 a, float s) { return a *= s; }
+constexpr Vec3 operator*(float s, Vec3 a) { return a *= s; }
+constexpr Vec3 operator/(Vec3 a, float s) { return a /= s; }
+constexpr bool operator==(Vec3 a, Vec3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+constexpr bool operator!=(Vec3 a, Vec3 b) { return !(a == b); }
+
+constexpr float dot(Vec3 a, Vec3 b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+constexpr Vec3 cross(Vec3 a, Vec3 b) {
+#if LINEARMATH_SSE2
+  // a * b.yzx - a.yzx * b is the cross product in zxy order.
+  if (LINEARMATH_RUNTIME()) {
+    __m128 u = Vec4(a, 0).load(), v = Vec4(b, 0).load();
+    __m128 zxy = _mm_sub_ps(
+        _mm_mul_ps(u, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(u, u, _MM_SHUFFLE(3, 0, 2, 1)), v));
+    return Vec4::store(_mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(3, 0, 2, 1)))
+        .xyz();
+  }
+#endif
+  return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+          a.x * b.y - a.y * b.x};
+}
+constexpr Vec3 min(Vec3 a, Vec3 b) {
+  return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y,
+          a.z < b.z ? a.z : b.z};
+}
+constexpr Vec3 max(Vec3 a, Vec3 b) {
+  return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y,
+          a.z > b.z ? a.z : b.z};
+}
+
+//--- Vec4
+
+constexpr Vec4 &Vec4::operator+=(Vec4 o) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) return *this = store(_mm_add_ps(load(), o.load()));
+#endif
+  return *this = {x + o.x, y + o.y, z + o.z, w + o.w};
+}
+constexpr Vec4 &Vec4::operator-=(Vec4 o) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) return *this = store(_mm_sub_ps(load(), o.load()));
+#endif
+  return *this = {x - o.x, y - o.y, z - o.z, w - o.w};
+}
+constexpr Vec4 &Vec4::operator*=(Vec4 o) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) return *this = store(_mm_mul_ps(load(), o.load()));
+#endif
+  return *this = {x * o.x, y * o.y, z * o.z, w * o.w};
+}
+constexpr Vec4 &Vec4::operator*=(float s) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME())
+    return *this = store(_mm_mul_ps(load(), _mm_set1_ps(s)));
+#endif
+  return *this = {x * s, y * s, z * s, w * s};
+}
+
+constexpr Vec4 operator-(Vec4 a) { return {-a.x, -a.y, -a.z, -a.w}; }
+constexpr Vec4 operator+(Vec4 a, Vec4 b) { return a += b; }
+constexpr Vec4 operator-(Vec4 a, Vec4 b) { return a -= b; }
+constexpr Vec4 operator*(Vec4 a, Vec4 b) { return a *= b; }
+constexpr Vec4 operator*(Vec4 a, float s) { return a *= s; }
+constexpr Vec4 operator*(float s, Vec4 a) { return a *= s; }
+constexpr Vec4 operator/(Vec4 a, float s) { return a /= s; }
+constexpr bool operator==(Vec4 a, Vec4 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+}
+constexpr bool operator!=(Vec4 a, Vec4 b) { return !(a == b); }
+
+#if LINEARMATH_SSE2
+// The sum of all four lanes, in every lane.
+inline __m128 horizontalSum(__m128 v) {
+  __m128 pairs = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_add_ps(pairs,
+                    _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+#endif
+
+constexpr float dot(Vec4 a, Vec4 b) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME())
+    return _mm_cvtss_f32(horizontalSum(_mm_mul_ps(a.load(), b.load())));
+#endif
+  return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+}
+constexpr Vec4 min(Vec4 a, Vec4 b) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) return Vec4::store(_mm_min_ps(a.load(), b.load()));
+#endif
+  return {a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z,
+          a.w < b.w ? a.w : b.w};
+}
+constexpr Vec4 max(Vec4 a, Vec4 b) {
+#if LINEARMATH_SSE2
+  if (LINEARMATH_RUNTIME()) return Vec4::store(_mm_max_ps(a.load(), b.load()));
+#endif
+  return {a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z,
+          a.w > b.w ? a.w : b.w};
+}
+
+//--- Common to all sizes
+
+template <typename V>
+constexpr float lengthSquared(V v) {
+  return dot(v, v);
+}
+template <typename V>
+inline float length(V v) {
+  return sqrtf(dot(v, v));
+}
+template <typename V>
+inline float distance(V a, V b) {
+  return length(a - b);
+}
+// A zero vector comes back unchanged rather than as NaNs.
+template <typename V>
+inline V normalize(V v) {
+  float squared = dot(v, v);
+  return squared > 0 ? v * (1 / sqrtf(squared)) : v;
+}
+#if LINEARMATH_SSE2
+inline Vec4 normalize(Vec4 v) {
+  __m128 value = v.load();
+  __m128 squared = horizontalSum(_mm_mul_ps(value, value));
+  if (!(_mm_cvtss_f32(squared) > 0)) return v;
+  return Vec4::store(
+      _mm_mul_ps(value, _mm_div_ps(_mm_set1_ps(1), _mm_sqrt_ps(squared))));
+}
+#endif
+template <typename V>
+constexpr V lerp(V a, V b, float t) {
+  return a + (b - a) * t;
+}
+
+}  // namespace LinearMath
+
+#endif  // LINEARMATH_VECTOR_H
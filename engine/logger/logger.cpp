@@ -0,0 +1,396 @@
+#include "logger.h"
+
+#include <chrono>
+#include <unordered_map>
+
+#include "memory/memorytracker.h"
+
+namespace {
+using logClock = std::chrono::steady_clock;
+const logClock::time_point epoch = logClock::now();
+
+const char binaryMagic[8] = {'G', 'E', 'L', 'O', 'G', 'v', '1', '\n'};
+
+unsigned short threadIndex() {
+  static std::atomic<unsigned short> next{0};
+  thread_local unsigned short index = next.fetch_add(1);
+  return index;
+}
+
+template <typename T>
+T load(const char *data) {
+  T value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+size_t prefix(char *out, size_t outSize, unsigned long long timestamp,
+              unsigned int thread, logSeverity severity) {
+  int n = snprintf(out, outSize, "[%12.6f] [%u] %-5s ",
+                   static_cast<double>(timestamp) / 1e9, thread,
+                   Logger::severityName(severity));
+  return n < 0 ? 0 : static_cast<size_t>(n) < outSize ? n : outSize - 1;
+}
+}  // namespace
+
+Logger &Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger() {
+  for (size_t i = 0; i < capacity; i++)
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  worker = std::thread(&Logger::run, this);
+}
+
+Logger::~Logger() {
+  running.store(false);
+  worker.join();
+  if (FILE *file = binary.load()) fclose(file);
+}
+
+const char *Logger::severityName(logSeverity severity) {
+  static const char *names[] = {"TRACE", "DEBUG", "INFO",
+                                "WARN",  "ERROR", "FATAL"};
+  return severity <= LOG_FATAL ? names[severity] : "?";
+}
+
+//--- Producers
+
+bool Logger::write(logSeverity severity, std::string_view contents) {
+  if (severity < level.load(std::memory_order_relaxed)) return 0;
+
+  // Lines are terminated by the drain thread.
+  if (!contents.empty() && contents.back() == '\n') contents.remove_suffix(1);
+  if (contents.size() > maxLength) contents = contents.substr(0, maxLength);
+  return push(severity, false, contents.data(), contents.size());
+}
+
+void Logger::encodeString(char *buffer, size_t &size, std::string_view value) {
+  size_t room = maxLength - size;
+  if (room < 1 + sizeof(unsigned short)) return;
+  room -= 1 + sizeof(unsigned short);
+  if (value.size() > room) value = value.substr(0, room);
+
+  unsigned short length = static_cast<unsigned short>(value.size());
+  buffer[size++] = ARG_STRING;
+  memcpy(buffer + size, &length, sizeof(length));
+  size += sizeof(length);
+  memcpy(buffer + size, value.data(), length);
+  size += length;
+}
+
+bool Logger::push(logSeverity severity, bool formatted, const char *data,
+                  size_t size) {
+  size_t chunks = size == 0 ? 1 : (size - 1) / textSize + 1;
+
+  // Claim `chunks` consecutive slots. The consumer frees slots in order, so
+  // if the last one is free for this lap, every slot before it is too.
+  size_t pos = enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    size_t last = pos + chunks - 1;
+    size_t seq = slots[last & (capacity - 1)].sequence.load(
+        std::memory_order_acquire);
+    auto diff = static_cast<std::ptrdiff_t>(seq - last);
+    if (diff == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + chunks,
+                                           std::memory_order_relaxed))
+        break;
+    } else if (diff < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return 0;
+    } else
+      pos = enqueuePos.load(std::memory_order_relaxed);
+  }
+
+  slot &first = slots[pos & (capacity - 1)];
+  first.timestamp = static_cast<unsigned long long>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(logClock::now() -
+                                                           epoch)
+          .count());
+  first.length = static_cast<unsigned short>(size);
+  first.chunks = static_cast<unsigned char>(chunks);
+  first.severity = severity;
+  first.thread = threadIndex();
+  first.formatted = formatted;
+  for (size_t i = 0; i < chunks; i++) {
+    slot &s = slots[(pos + i) & (capacity - 1)];
+    size_t offset = i * textSize;
+    size_t n = size - offset < textSize ? size - offset : textSize;
+    memcpy(s.text, data + offset, n);
+    s.sequence.store(pos + i + 1, std::memory_order_release);
+  }
+
+  if (severity == LOG_FATAL) flush();
+  return 1;
+}
+
+//--- Formatting
+
+size_t Logger::format(char *out, size_t outSize, const char *format,
+                      const char *args, size_t argsSize) {
+  size_t n = 0, a = 0;
+  auto put = [&](const char *s, size_t length) {
+    if (length > outSize - n) length = outSize - n;
+    memcpy(out + n, s, length);
+    n += length;
+  };
+  // Records decoded from a file can be cut short or corrupt, so every read
+  // is checked against what is left.
+  auto truncated = [&](size_t size) {
+    if (size <= argsSize - a) return false;
+    put("<truncated>", 11);
+    return true;
+  };
+
+  for (const char *c = format; *c && n < outSize; c++) {
+    if (c[0] == '{' && c[1] == '{') {
+      put("{", 1);
+      c++;
+      continue;
+    }
+    if (c[0] == '}' && c[1] == '}') {
+      put("}", 1);
+      c++;
+      continue;
+    }
+    if (c[0] != '{' || c[1] != '}') {
+      put(c, 1);
+      continue;
+    }
+    c++;
+    if (a >= argsSize) {
+      put("{}", 2);
+      continue;
+    }
+
+    char scratch[32];
+    int length = 0;
+    switch (static_cast<argument>(args[a++])) {
+      case ARG_INT:
+        if (truncated(sizeof(long long))) return n;
+        length = snprintf(scratch, sizeof(scratch), "%lld",
+                          load<long long>(args + a));
+        a += sizeof(long long);
+        break;
+      case ARG_UINT:
+        if (truncated(sizeof(unsigned long long))) return n;
+        length = snprintf(scratch, sizeof(scratch), "%llu",
+                          load<unsigned long long>(args + a));
+        a += sizeof(unsigned long long);
+        break;
+      case ARG_DOUBLE:
+        if (truncated(sizeof(double))) return n;
+        length = snprintf(scratch, sizeof(scratch), "%g",
+                          load<double>(args + a));
+        a += sizeof(double);
+        break;
+      case ARG_BOOL:
+        if (truncated(1)) return n;
+        length = snprintf(scratch, sizeof(scratch), "%s",
+                          args[a++] ? "true" : "false");
+        break;
+      case ARG_CHAR:
+        if (truncated(1)) return n;
+        scratch[0] = args[a++];
+        length = 1;
+        break;
+      case ARG_POINTER:
+        if (truncated(sizeof(unsigned long long))) return n;
+        length = snprintf(scratch, sizeof(scratch), "0x%llx",
+                          load<unsigned long long>(args + a));
+        a += sizeof(unsigned long long);
+        break;
+      case ARG_STRING: {
+        if (truncated(sizeof(unsigned short))) return n;
+        unsigned short size = load<unsigned short>(args + a);
+        a += sizeof(size);
+        if (truncated(size)) return n;
+        put(args + a, size);
+        a += size;
+        break;
+      }
+      default:
+        a = argsSize;  // corrupt record; stop consuming arguments
+        break;
+    }
+    put(scratch, static_cast<size_t>(length));
+  }
+  return n;
+}
+
+//--- Consumer
+
+void Logger::writeBinary(FILE *file, const slot &first, const char *payload) {
+  if (first.formatted) {
+    const char *id = load<const char *>(payload);
+    if (writtenFormats.insert(id).second) {
+      unsigned long long key = reinterpret_cast<unsigned long long>(id);
+      unsigned short length = static_cast<unsigned short>(strlen(id));
+      fputc('F', file);
+      fwrite(&key, sizeof(key), 1, file);
+      fwrite(&length, sizeof(length), 1, file);
+      fwrite(id, 1, length, file);
+    }
+  }
+  fputc('M', file);
+  fwrite(&first.timestamp, sizeof(first.timestamp), 1, file);
+  fputc(first.severity, file);
+  fwrite(&first.thread, sizeof(first.thread), 1, file);
+  fputc(first.formatted, file);
+  fwrite(&first.length, sizeof(first.length), 1, file);
+  fwrite(payload, 1, first.length, file);
+}
+
+bool Logger::drain() {
+  size_t pos = dequeuePos.load(std::memory_order_relaxed);
+  FILE *file = binary.load(std::memory_order_acquire);
+  bool any = false;
+  char payload[maxLength];
+  char line[maxLength * 2 + 64];
+
+  for (;;) {
+    slot &first = slots[pos & (capacity - 1)];
+    if (first.sequence.load(std::memory_order_acquire) != pos + 1) break;
+
+    size_t chunks = first.chunks;
+    size_t length = first.length;
+    for (size_t i = 0; i < chunks; i++) {
+      slot &s = slots[(pos + i) & (capacity - 1)];
+      // The producer publishes chunks one at a time; wait for the rest.
+      while (s.sequence.load(std::memory_order_acquire) != pos + i + 1)
+        std::this_thread::yield();
+      size_t offset = i * textSize;
+      memcpy(payload + offset, s.text,
+             length - offset < textSize ? length - offset : textSize);
+    }
+
+    if (file) writeBinary(file, first, payload);
+    if (!file || first.severity >= LOG_ERROR) {
+      size_t n = prefix(line, sizeof(line), first.timestamp, first.thread,
+                        first.severity);
+      if (first.formatted)
+        n += format(line + n, sizeof(line) - n - 1,
+                    load<const char *>(payload), payload + sizeof(char *),
+                    length - sizeof(char *));
+      else {
+        memcpy(line + n, payload, length);
+        n += length;
+      }
+      line[n++] = '\n';
+      fwrite(line, 1, n, first.severity >= LOG_ERROR ? stderr : stdout);
+    }
+
+    for (size_t i = 0; i < chunks; i++)
+      slots[(pos + i) & (capacity - 1)].sequence.store(
+          pos + i + capacity, std::memory_order_release);
+    pos += chunks;
+    dequeuePos.store(pos, std::memory_order_release);
+    any = true;
+  }
+
+  unsigned long long drops = dropped.load(std::memory_order_relaxed);
+  if (drops != reportedDrops) {
+    fprintf(stderr, "[logger] %llu messages dropped\n", drops - reportedDrops);
+    reportedDrops = drops;
+  }
+  if (any) {
+    if (file) fflush(file);
+    fflush(stdout);
+    fflush(stderr);
+  }
+  return any;
+}
+
+void Logger::run() {
+  MemoryScope scope(MEMTAG_LOGGING);
+  while (running.load(std::memory_order_relaxed))
+    if (!drain()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  drain();
+}
+
+void Logger::flush() {
+  size_t target = enqueuePos.load(std::memory_order_acquire);
+  while (dequeuePos.load(std::memory_order_acquire) < target)
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+//--- Binary files
+
+bool Logger::openBinary(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file) return 1;
+  fwrite(binaryMagic, 1, sizeof(binaryMagic), file);
+  flush();
+  if (FILE *previous = binary.exchange(file)) {
+    flush();
+    fclose(previous);
+  }
+  return 0;
+}
+
+bool Logger::decode(const char *path, FILE *out) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return 1;
+
+  char magic[sizeof(binaryMagic)];
+  if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+      memcmp(magic, binaryMagic, sizeof(magic))) {
+    fclose(file);
+    return 1;
+  }
+
+  // Format strings are keyed by their address in the process that wrote the
+  // file, so ids are only meaningful within a single file.
+  std::unordered_map<unsigned long long, std::string> formats;
+  char payload[maxLength];
+  char line[maxLength * 2 + 64];
+  bool failed = false;
+  int kind;
+  while ((kind = fgetc(file)) != EOF) {
+    unsigned short length;
+    if (kind == 'F') {
+      unsigned long long key;
+      if (fread(&key, sizeof(key), 1, file) != 1 ||
+          fread(&length, sizeof(length), 1, file) != 1 ||
+          length > maxLength || fread(payload, 1, length, file) != length) {
+        failed = true;
+        break;
+      }
+      formats[key].assign(payload, length);
+      continue;
+    }
+
+    unsigned long long timestamp;
+    unsigned short thread;
+    int severity = EOF, formatted = EOF;
+    if (kind != 'M' || fread(&timestamp, sizeof(timestamp), 1, file) != 1 ||
+        (severity = fgetc(file)) == EOF ||
+        fread(&thread, sizeof(thread), 1, file) != 1 ||
+        (formatted = fgetc(file)) == EOF ||
+        fread(&length, sizeof(length), 1, file) != 1 ||
+        length > maxLength || fread(payload, 1, length, file) != length) {
+      failed = true;
+      break;
+    }
+
+    size_t n = prefix(line, sizeof(line), timestamp, thread,
+                      static_cast<logSeverity>(severity));
+    if (formatted && length >= sizeof(unsigned long long)) {
+      auto found = formats.find(load<unsigned long long>(payload));
+      const char *fmt = found == formats.end() ? "<unknown format>"
+                                               : found->second.c_str();
+      n += format(line + n, sizeof(line) - n - 1, fmt,
+                  payload + sizeof(unsigned long long),
+                  length - sizeof(unsigned long long));
+    } else {
+      memcpy(line + n, payload, length);
+      n += length;
+    }
+    line[n++] = '\n';
+    fwrite(line, 1, n, out);
+  }
+  fclose(file);
+  return failed;
+}
@@ -0,0 +1,196 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+
+enum logSeverity : unsigned char {
+  LOG_TRACE = 0,
+  LOG_DEBUG,
+  LOG_INFO,
+  LOG_WARNING,
+  LOG_ERROR,
+  LOG_FATAL,
+  LOG_NONFATAL = LOG_INFO
+};
+
+// Messages below this severity are compiled out of ENGINE_LOG call sites,
+// arguments and all, and out of Application::log calls with a constant
+// severity.
+#ifndef ENGINE_LOG_LEVEL
+#ifdef NDEBUG
+#define ENGINE_LOG_LEVEL LOG_INFO
+#else
+#define ENGINE_LOG_LEVEL LOG_TRACE
+#endif
+#endif
+
+#define ENGINE_LOG(severity, contents)                  \
+  do {                                                  \
+    if constexpr ((severity) >= ENGINE_LOG_LEVEL)       \
+      Logger::instance().write((severity), (contents)); \
+  } while (0)
+
+// Deferred formatting: only the format string's address and the raw argument
+// values are queued. The format must be a string literal (see
+// Logger::writeFormat()); "{}" placeholders are filled in by the drain
+// thread or by Logger::decode().
+#define ENGINE_LOGF(severity, format, ...)                                  \
+  do {                                                                      \
+    if constexpr ((severity) >= ENGINE_LOG_LEVEL)                           \
+      Logger::instance().writeFormat((severity), (format), ##__VA_ARGS__); \
+  } while (0)
+
+// Asynchronous logger. write() copies the message into a bounded lock-free
+// MPSC ring and returns; a background thread formats and prints it. When the
+// ring is full the message is dropped (and counted) rather than waiting.
+class Logger {
+ public:
+  static Logger &instance();
+
+  bool write(logSeverity severity, std::string_view contents);
+  // Queues only the format's address, which the drain thread reads later
+  // and binary logs use to name it, so the format must be a string literal.
+  // Taking a const array keeps out pointers such as std::string::c_str().
+  template <size_t N, typename... Args>
+  bool writeFormat(logSeverity severity, const char (&format)[N],
+                   const Args &...args);
+  template <size_t N, typename... Args>
+  bool writeFormat(logSeverity, char (&)[N], const Args &...) = delete;
+  void flush();  /// Blocks until everything written so far is printed.
+
+  void setLevel(logSeverity severity) { level.store(severity); }
+  logSeverity getLevel() const { return level.load(); }
+  unsigned long long droppedCount() const { return dropped.load(); }
+
+  // Records go to `path` unformatted instead of to stdout; errors are still
+  // printed to stderr. Read the file back with decode().
+  bool openBinary(const char *path);  /// Returns 1 if it can't be opened.
+  static bool decode(const char *path, FILE *out);  /// Returns 1 on error.
+
+  static const char *severityName(logSeverity severity);
+
+ private:
+  Logger();
+  ~Logger();
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  static constexpr size_t capacity = 4096;  // slots; power of two
+  static constexpr size_t slotSize = 128;
+  static constexpr size_t maxChunks = 32;   // longest message in slots
+
+  struct alignas(64) slot {
+    std::atomic<size_t> sequence;
+    // Only meaningful in the first slot of a message.
+    unsigned long long timestamp;
+    unsigned short length;
+    unsigned char chunks;
+    logSeverity severity;
+    unsigned short thread;
+    bool formatted;
+    char text[slotSize - 23];
+  };
+  static constexpr size_t textSize = sizeof(slot::text);
+  static constexpr size_t maxLength = textSize * maxChunks;
+  static_assert(sizeof(slot) == slotSize);
+
+  // Argument encoding for writeFormat(): a tag byte followed by the value.
+  enum argument : unsigned char {
+    ARG_INT,
+    ARG_UINT,
+    ARG_DOUBLE,
+    ARG_BOOL,
+    ARG_CHAR,
+    ARG_POINTER,
+    ARG_STRING  // unsigned short length, then the bytes
+  };
+  template <typename T>
+  static void encode(char *buffer, size_t &size, const T &value);
+  static void encodeString(char *buffer, size_t &size, std::string_view value);
+  static size_t format(char *out, size_t outSize, const char *format,
+                       const char *args, size_t argsSize);
+
+  bool push(logSeverity severity, bool formatted, const char *data,
+            size_t size);
+  bool drain();
+  void run();
+  void writeBinary(FILE *file, const slot &first, const char *payload);
+
+  slot slots[capacity];
+  alignas(64) std::atomic<size_t> enqueuePos{0};
+  alignas(64) std::atomic<size_t> dequeuePos{0};
+  std::atomic<unsigned long long> dropped{0};
+  std::atomic<logSeverity> level{LOG_TRACE};
+  std::atomic<bool> running{true};
+  std::atomic<FILE *> binary{nullptr};
+  std::unordered_set<const char *> writtenFormats;  // drain thread only
+  unsigned long long reportedDrops = 0;
+  std::thread worker;
+};
+
+template <typename T>
+void Logger::encode(char *buffer, size_t &size, const T &value) {
+  using type = std::decay_t<T>;
+  // Leave room for the largest scalar; strings check for themselves.
+  if (size + 1 + sizeof(double) > maxLength) return;
+  if constexpr (std::is_same_v<type, bool>) {
+    buffer[size++] = ARG_BOOL;
+    buffer[size++] = value;
+  } else if constexpr (std::is_same_v<type, char>) {
+    buffer[size++] = ARG_CHAR;
+    buffer[size++] = value;
+  } else if constexpr (std::is_integral_v<type> || std::is_enum_v<type>) {
+    if constexpr (std::is_signed_v<type>) {
+      long long v = static_cast<long long>(value);
+      buffer[size++] = ARG_INT;
+      memcpy(buffer + size, &v, sizeof(v));
+      size += sizeof(v);
+    } else {
+      unsigned long long v = static_cast<unsigned long long>(value);
+      buffer[size++] = ARG_UINT;
+      memcpy(buffer + size, &v, sizeof(v));
+      size += sizeof(v);
+    }
+  } else if constexpr (std::is_floating_point_v<type>) {
+    double v = static_cast<double>(value);
+    buffer[size++] = ARG_DOUBLE;
+    memcpy(buffer + size, &v, sizeof(v));
+    size += sizeof(v);
+  } else if constexpr (std::is_array_v<T>) {
+    encodeString(buffer, size, value);
+  } else if constexpr (std::is_same_v<type, const char *> ||
+                       std::is_same_v<type, char *>) {
+    encodeString(buffer, size, value ? value : "(null)");
+  } else if constexpr (std::is_convertible_v<const T &, std::string_view>) {
+    encodeString(buffer, size, value);
+  } else if constexpr (std::is_pointer_v<type>) {
+    unsigned long long v = reinterpret_cast<unsigned long long>(value);
+    buffer[size++] = ARG_POINTER;
+    memcpy(buffer + size, &v, sizeof(v));
+    size += sizeof(v);
+  } else
+    static_assert(!sizeof(T), "unsupported log argument type");
+}
+
+template <size_t N, typename... Args>
+bool Logger::writeFormat(logSeverity severity, const char (&format)[N],
+                         const Args &...args) {
+  if (severity < level.load(std::memory_order_relaxed)) return 0;
+  char buffer[maxLength];
+  const char *address = format;
+  size_t size = sizeof(address);
+  memcpy(buffer, &address, sizeof(address));
+  (encode(buffer, size, args), ...);
+  return push(severity, true, buffer, size);
+}
+
+#endif  // LOGGER_H
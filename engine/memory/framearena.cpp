@@ -0,0 +1,70 @@
+#include "framearena.h"
+
+#include <stdlib.h>
+
+#include "memorytracker.h"
+
+FrameArena::FrameArena(size_t blockSize) : blockSize(blockSize) {
+  blocks = newBlock(blockSize);
+  cursor = blocks->data();
+  end = cursor + blocks->size;
+}
+
+FrameArena::~FrameArena() {
+  while (blocks) {
+    block *next = blocks->next;
+    Memory::recordFree(MEMTAG_POOLS, blocks->size);
+    free(blocks);
+    blocks = next;
+  }
+}
+
+FrameArena::block *FrameArena::newBlock(size_t size) {
+  block *b = static_cast<block *>(malloc(sizeof(block) + size));
+  if (!b) throw std::bad_alloc();
+  Memory::recordAllocation(MEMTAG_POOLS, size);
+  b->next = nullptr;
+  b->size = size;
+  return b;
+}
+
+void *FrameArena::allocateSlow(size_t size, size_t alignment) {
+  size_t needed = size + alignment;
+  block *b = newBlock(needed > blockSize ? needed : blockSize);
+  retired += static_cast<size_t>(cursor - blocks->data());
+  b->next = blocks;
+  blocks = b;
+  cursor = b->data();
+  end = cursor + b->size;
+  return allocate(size, alignment);
+}
+
+size_t FrameArena::used() const {
+  return retired + static_cast<size_t>(cursor - blocks->data());
+}
+
+size_t FrameArena::capacity() const {
+  size_t total = 0;
+  for (block *b = blocks; b; b = b->next) total += b->size;
+  return total;
+}
+
+void FrameArena::reset() {
+  size_t frameUsed = used();
+  if (frameUsed > peakUsed) peakUsed = frameUsed;
+
+  if (blocks->next) {
+    // Replace every block with one that would have held the whole frame.
+    size_t total = capacity();
+    while (blocks) {
+      block *next = blocks->next;
+      Memory::recordFree(MEMTAG_POOLS, blocks->size);
+      free(blocks);
+      blocks = next;
+    }
+    blocks = newBlock(total);
+  }
+  retired = 0;
+  cursor = blocks->data();
+  end = cursor + blocks->size;
+}
@@ -0,0 +1,87 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of the current tick.
+// Allocation is a pointer increment; nothing is freed individually and
+// reset() releases everything at once. Not thread safe: use one per thread.
+class FrameArena : public std::pmr::memory_resource {
+ public:
+  explicit FrameArena(size_t blockSize = 1 << 20);
+  ~FrameArena() override;
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
+
+  void *allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    size_t padding = (alignment - reinterpret_cast<size_t>(cursor)) &
+                     (alignment - 1);
+    if (padding + size > static_cast<size_t>(end - cursor))
+      return allocateSlow(size, alignment);
+    char *result = cursor + padding;
+    cursor = result + size;
+    return result;
+  }
+  template <typename T>
+  T *allocateArray(size_t count) {
+    return static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+  }
+  // Destructors never run, so only trivially destructible types are allowed.
+  template <typename T, typename... Args>
+  T *create(Args &&...args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "FrameArena never runs destructors");
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // Invalidates everything allocated since the last reset. If the frame
+  // spilled into extra blocks they are merged into one larger block, so a
+  // steady workload settles into a single allocation.
+  void reset();
+
+  size_t used() const;           /// Bytes handed out this frame.
+  size_t capacity() const;       /// Bytes reserved across all blocks.
+  size_t peak() const { return peakUsed; }  /// Largest used() at a reset.
+
+ private:
+  struct block {
+    block *next;
+    size_t size;
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+  };
+
+  void *allocateSlow(size_t size, size_t alignment);
+  block *newBlock(size_t size);
+
+  // std::pmr::memory_resource
+  void *do_allocate(size_t size, size_t alignment) override {
+    return allocate(size, alignment);
+  }
+  void do_deallocate(void *, size_t, size_t) override {}
+  bool do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept override {
+    return this == &other;
+  }
+
+  size_t blockSize;
+  block *blocks = nullptr;   // current block first
+  size_t retired = 0;        // bytes used in blocks behind the current one
+  char *cursor = nullptr;
+  char *end = nullptr;
+  size_t peakUsed = 0;
+};
+
+// Containers that allocate from a FrameArena, e.g.
+//   FrameVector<int> ids(&frameArena);
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
+
+#endif  // FRAMEARENA_H
@@ -0,0 +1,227 @@
+#include "memorytracker.h"
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#include "logger/logger.h"
+
+namespace {
+
+struct alignas(64) tagCounters {
+  std::atomic<size_t> live{0};
+  std::atomic<size_t> peak{0};
+  std::atomic<size_t> budget{0};
+  std::atomic<unsigned long long> allocations{0};
+  std::atomic<unsigned long long> frees{0};
+};
+tagCounters counters[MEMTAG_COUNT];
+
+thread_local memoryTag current = MEMTAG_GENERAL;
+thread_local bool warning = false;
+
+// Sits directly in front of every pointer handed out by Memory::allocate.
+struct header {
+  size_t size;
+  unsigned int offset;  // from the start of the malloc'd block
+  memoryTag tag;
+};
+constexpr size_t headerSize = 16;
+static_assert(sizeof(header) <= headerSize);
+
+const char *names[MEMTAG_COUNT] = {"general",  "resource", "config",
+                                   "game",     "logging",  "profiler",
+                                   "metrics",  "pools"};
+
+void add(memoryTag tag, size_t bytes) {
+  tagCounters &c = counters[tag];
+  size_t live = c.live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+  size_t peak = c.peak.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !c.peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+    ;
+
+  size_t budget = c.budget.load(std::memory_order_relaxed);
+  // Warn on the allocation that crosses the budget, not on every one after.
+  // The logger never allocates, but guard against re-entry anyway.
+  if (budget && live > budget && live - bytes <= budget && !warning) {
+    warning = true;
+    Logger::instance().writeFormat(
+        LOG_WARNING, "Memory budget for '{}' exceeded: {} of {} bytes",
+        names[tag], live, budget);
+    warning = false;
+  }
+}
+
+void remove(memoryTag tag, size_t bytes) {
+  counters[tag].live.fetch_sub(bytes, std::memory_order_relaxed);
+  counters[tag].frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+namespace Memory {
+
+void *allocate(size_t size, memoryTag tag, size_t alignment) {
+  if (alignment < headerSize) alignment = headerSize;
+  char *raw = static_cast<char *>(malloc(size + alignment));
+  if (!raw) return nullptr;
+
+  // malloc is at least 16-byte aligned, so there is always room for the
+  // header between `raw` and the aligned pointer.
+  size_t address = reinterpret_cast<size_t>(raw) + headerSize;
+  address = (address + alignment - 1) & ~(alignment - 1);
+  char *pointer = reinterpret_cast<char *>(address);
+
+  header *h = reinterpret_cast<header *>(pointer - headerSize);
+  h->size = size;
+  h->offset = static_cast<unsigned int>(pointer - raw);
+  h->tag = tag;
+  add(tag, size);
+  return pointer;
+}
+
+void deallocate(void *pointer) {
+  if (!pointer) return;
+  char *p = static_cast<char *>(pointer);
+  header *h = reinterpret_cast<header *>(p - headerSize);
+  remove(h->tag, h->size);
+  free(p - h->offset);
+}
+
+void recordAllocation(memoryTag tag, size_t bytes) { add(tag, bytes); }
+void recordFree(memoryTag tag, size_t bytes) { remove(tag, bytes); }
+
+memoryTag currentTag() { return current; }
+
+TagStats stats(memoryTag tag) {
+  const tagCounters &c = counters[tag];
+  return TagStats{c.live.load(std::memory_order_relaxed),
+                  c.peak.load(std::memory_order_relaxed),
+                  c.budget.load(std::memory_order_relaxed),
+                  c.allocations.load(std::memory_order_relaxed),
+                  c.frees.load(std::memory_order_relaxed)};
+}
+
+const char *tagName(memoryTag tag) {
+  return tag < MEMTAG_COUNT ? names[tag] : "?";
+}
+
+bool tagFromName(const char *name, memoryTag *tag) {
+  for (unsigned char i = 0; i < MEMTAG_COUNT; i++) {
+    if (!strcmp(name, names[i])) {
+      *tag = static_cast<memoryTag>(i);
+      return 0;
+    }
+  }
+  return 1;
+}
+
+void setBudget(memoryTag tag, size_t bytes) {
+  counters[tag].budget.store(bytes, std::memory_order_relaxed);
+}
+
+bool reportLeaks() {
+  bool leaked = false;
+  for (unsigned char i = 0; i < MEMTAG_COUNT; i++) {
+    memoryTag tag = static_cast<memoryTag>(i);
+    TagStats s = stats(tag);
+    bool scoped = tag == MEMTAG_RESOURCE || tag == MEMTAG_CONFIG ||
+                  tag == MEMTAG_GAME;
+    if (scoped && s.liveBytes) {
+      leaked = true;
+      Logger::instance().writeFormat(
+          LOG_ERROR, "Leaked {} bytes tagged '{}' ({} allocations, {} frees)",
+          s.liveBytes, names[i], s.allocations, s.frees);
+    } else if (s.allocations) {
+      Logger::instance().writeFormat(
+          LOG_INFO, "Memory '{}': {} bytes live, {} peak, {} allocations",
+          names[i], s.liveBytes, s.peakBytes, s.allocations);
+    }
+  }
+  return leaked;
+}
+
+}  // namespace Memory
+
+MemoryScope::MemoryScope(memoryTag tag) : previous(current) { current = tag; }
+MemoryScope::~MemoryScope() { current = previous; }
+
+void *TaggedResource::do_allocate(size_t size, size_t alignment) {
+  void *pointer = Memory::allocate(size, tag, alignment);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+
+//--- Global operator new / delete
+
+#if ENGINE_MEMORY_TRACKING
+void *operator new(size_t size) {
+  void *pointer = Memory::allocate(size, current);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+void *operator new[](size_t size) { return operator new(size); }
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return Memory::allocate(size, current);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return Memory::allocate(size, current);
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+  void *pointer =
+      Memory::allocate(size, current, static_cast<size_t>(alignment));
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return Memory::allocate(size, current, static_cast<size_t>(alignment));
+}
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return Memory::allocate(size, current, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *pointer) noexcept { Memory::deallocate(pointer); }
+void operator delete[](void *pointer) noexcept { Memory::deallocate(pointer); }
+void operator delete(void *pointer, size_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete[](void *pointer, size_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete(void *pointer, std::align_val_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete(void *pointer, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  Memory::deallocate(pointer);
+}
+void operator delete[](void *pointer, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  Memory::deallocate(pointer);
+}
+#endif
@@ -0,0 +1,89 @@
+#ifndef MEMORYTRACKER_H
+#define MEMORYTRACKER_H
+
+#include <cstddef>
+#include <memory_resource>
+
+// Every allocation made through operator new (and Memory::allocate) is
+// attributed to the memory tag that is current on the allocating thread.
+// Define ENGINE_MEMORY_TRACKING to 0 to leave the global operator new alone;
+// explicit Memory::allocate calls are tracked either way.
+#ifndef ENGINE_MEMORY_TRACKING
+#define ENGINE_MEMORY_TRACKING 1
+#endif
+
+enum memoryTag : unsigned char {
+  MEMTAG_GENERAL = 0,
+  MEMTAG_RESOURCE,
+  MEMTAG_CONFIG,
+  MEMTAG_GAME,
+  MEMTAG_LOGGING,
+  MEMTAG_PROFILER,
+  MEMTAG_METRICS,
+  MEMTAG_POOLS,  // slabs and arenas handed out by the engine allocators
+  MEMTAG_COUNT
+};
+
+namespace Memory {
+
+struct TagStats {
+  size_t liveBytes;
+  size_t peakBytes;
+  size_t budgetBytes;  // 0 = unlimited
+  unsigned long long allocations;
+  unsigned long long frees;
+};
+
+void *allocate(size_t size, memoryTag tag, size_t alignment = 16);
+void deallocate(void *pointer);  /// Only for memory from allocate().
+
+// For allocators that manage their own backing memory (slabs, arenas).
+void recordAllocation(memoryTag tag, size_t bytes);
+void recordFree(memoryTag tag, size_t bytes);
+
+memoryTag currentTag();
+TagStats stats(memoryTag tag);
+const char *tagName(memoryTag tag);
+bool tagFromName(const char *name, memoryTag *tag);  /// Returns 1 if unknown.
+
+// A warning is logged each time a tag's live bytes cross its budget.
+void setBudget(memoryTag tag, size_t bytes);
+
+// Logs live bytes per tag. Tags that must be empty once the subsystems that
+// use them have shut down (resource, config, game) are reported as leaks;
+// returns 1 if any are found.
+bool reportLeaks();
+
+}  // namespace Memory
+
+// Makes `tag` current on this thread for the lifetime of the scope.
+class MemoryScope {
+ public:
+  explicit MemoryScope(memoryTag tag);
+  ~MemoryScope();
+  MemoryScope(const MemoryScope &) = delete;
+  MemoryScope &operator=(const MemoryScope &) = delete;
+
+ private:
+  memoryTag previous;
+};
+
+// std::pmr resource that attributes everything it allocates to one tag.
+class TaggedResource : public std::pmr::memory_resource {
+ public:
+  explicit TaggedResource(memoryTag tag) : tag(tag) {}
+
+ private:
+  void *do_allocate(size_t size, size_t alignment) override;
+  void do_deallocate(void *pointer, size_t, size_t) override {
+    Memory::deallocate(pointer);
+  }
+  bool do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept override {
+    return this == &other;
+  }
+
+  memoryTag tag;
+};
+
+#endif  // MEMORYTRACKER_H
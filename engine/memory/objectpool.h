@@ -0,0 +1,124 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Reference to an object in an ObjectPool. The generation changes every time
+// a slot is reused, so a handle to a destroyed object stays detectably stale
+// instead of silently pointing at whatever took its place.
+template <typename T>
+struct Handle {
+  unsigned int index = 0;
+  unsigned int generation = 0;  // never issued, so Handle{} is null
+
+  explicit operator bool() const { return generation != 0; }
+  bool operator==(const Handle &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Handle &other) const { return !(*this == other); }
+};
+
+// Stable storage for objects created and destroyed at a high rate. Objects
+// live in fixed pages that are never moved, freed slots are reused through an
+// intrusive free list, and nothing touches the heap once the pool is warm.
+// Not thread safe.
+template <typename T, size_t PageSize = 256>
+class ObjectPool {
+ public:
+  ObjectPool() = default;
+  ~ObjectPool() { clear(); }
+  ObjectPool(const ObjectPool &) = delete;
+  ObjectPool &operator=(const ObjectPool &) = delete;
+
+  template <typename... Args>
+  Handle<T> create(Args &&...args) {
+    if (freeHead == npos) grow();
+    unsigned int index = freeHead;
+    slot &s = at(index);
+    new (s.storage) T(std::forward<Args>(args)...);
+    freeHead = s.nextFree;
+    s.alive = true;
+    live++;
+    return Handle<T>{index, s.generation};
+  }
+
+  bool destroy(Handle<T> handle) {  /// Returns 1 if the handle is stale.
+    if (!valid(handle)) return 1;
+    slot &s = at(handle.index);
+    s.object()->~T();
+    s.alive = false;
+    if (++s.generation == 0) s.generation = 1;
+    s.nextFree = freeHead;
+    freeHead = handle.index;
+    live--;
+    return 0;
+  }
+
+  bool valid(Handle<T> handle) const {
+    if (handle.index >= capacity) return false;
+    const slot &s = at(handle.index);
+    return s.alive && s.generation == handle.generation;
+  }
+  T *get(Handle<T> handle) {
+    return valid(handle) ? at(handle.index).object() : nullptr;
+  }
+  const T *get(Handle<T> handle) const {
+    return valid(handle) ? at(handle.index).object() : nullptr;
+  }
+
+  size_t size() const { return live; }
+  size_t slots() const { return capacity; }
+
+  template <typename F>
+  void forEach(F &&f) {  // f(Handle<T>, T &)
+    for (unsigned int i = 0; i < capacity; i++) {
+      slot &s = at(i);
+      if (s.alive) f(Handle<T>{i, s.generation}, *s.object());
+    }
+  }
+
+  void clear() {  /// Destroys every object; outstanding handles go stale.
+    for (unsigned int i = 0; i < capacity; i++)
+      if (at(i).alive) destroy(Handle<T>{i, at(i).generation});
+  }
+
+ private:
+  static constexpr unsigned int npos = ~0u;
+
+  struct slot {
+    alignas(T) unsigned char storage[sizeof(T)];
+    unsigned int generation = 1;
+    unsigned int nextFree = npos;
+    bool alive = false;
+    T *object() { return std::launder(reinterpret_cast<T *>(storage)); }
+  };
+
+  slot &at(unsigned int index) {
+    return pages[index / PageSize][index % PageSize];
+  }
+  const slot &at(unsigned int index) const {
+    return pages[index / PageSize][index % PageSize];
+  }
+
+  void grow() {
+    pages.emplace_back(new slot[PageSize]);
+    unsigned int base = capacity;
+    capacity += PageSize;
+    // Link the new slots so they are handed out in index order.
+    for (unsigned int i = PageSize; i-- > 0;) {
+      pages.back()[i].nextFree = freeHead;
+      freeHead = base + i;
+    }
+  }
+
+  std::vector<std::unique_ptr<slot[]>> pages;
+  unsigned int capacity = 0;
+  unsigned int freeHead = npos;
+  size_t live = 0;
+};
+
+#endif  // OBJECTPOOL_H
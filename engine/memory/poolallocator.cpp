@@ -0,0 +1,197 @@
+#include "poolallocator.h"
+
+#include <stdlib.h>
+
+#include <new>
+
+#include "memorytracker.h"
+
+static_assert(sizeof(void *) == 8, "the batch stack tags pointer bits");
+static_assert(PoolAllocator::slabSize % PoolAllocator::maxBlock == 0);
+
+namespace {
+constexpr unsigned long long pointerMask = (1ull << 48) - 1;
+constexpr unsigned int tagShift = 48;
+
+// Every slab ever carved, so the memory stays reachable for leak checkers.
+struct slabRecord {
+  void *slab;
+  slabRecord *next;
+};
+std::atomic<slabRecord *> slabs{nullptr};
+}  // namespace
+
+PoolAllocator::batchStack PoolAllocator::stacks[classCount];
+
+struct PoolAllocator::threadCache {
+  freeBlock *lists[classCount] = {};
+  size_t counts[classCount] = {};
+
+  ~threadCache() {
+    // Hand everything back so other threads can use it.
+    for (size_t c = 0; c < classCount; c++) {
+      while (lists[c]) {
+        freeBlock *batch = lists[c];
+        freeBlock *last = batch;
+        for (size_t i = 1; i < batchSize && last->next; i++) last = last->next;
+        lists[c] = last->next;
+        last->next = nullptr;
+        pushBatch(c, batch);
+      }
+    }
+  }
+};
+
+PoolAllocator::threadCache &PoolAllocator::cache() {
+  thread_local threadCache local;
+  return local;
+}
+
+void PoolAllocator::pushBatch(size_t sizeClass, freeBlock *batch) {
+  batchStack &stack = stacks[sizeClass];
+  unsigned long long old = stack.head.load(std::memory_order_relaxed);
+  unsigned long long replacement;
+  do {
+    batch->nextBatch.store(reinterpret_cast<freeBlock *>(old & pointerMask),
+                           std::memory_order_relaxed);
+    replacement = (reinterpret_cast<unsigned long long>(batch) & pointerMask) |
+                  (((old >> tagShift) + 1) << tagShift);
+  } while (!stack.head.compare_exchange_weak(old, replacement,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+  stack.count.fetch_add(1, std::memory_order_relaxed);
+}
+
+PoolAllocator::freeBlock *PoolAllocator::popBatch(size_t sizeClass) {
+  batchStack &stack = stacks[sizeClass];
+  unsigned long long old = stack.head.load(std::memory_order_acquire);
+  freeBlock *top;
+  unsigned long long replacement;
+  do {
+    top = reinterpret_cast<freeBlock *>(old & pointerMask);
+    if (!top) return nullptr;
+    // Slabs are never unmapped, so this read is safe even if `top` has
+    // already been popped and reused by another thread.
+    freeBlock *next = top->nextBatch.load(std::memory_order_relaxed);
+    replacement = (reinterpret_cast<unsigned long long>(next) & pointerMask) |
+                  (((old >> tagShift) + 1) << tagShift);
+  } while (!stack.head.compare_exchange_weak(old, replacement,
+                                             std::memory_order_acquire,
+                                             std::memory_order_acquire));
+  stack.count.fetch_sub(1, std::memory_order_relaxed);
+  return top;
+}
+
+PoolAllocator::freeBlock *PoolAllocator::carveSlab(size_t sizeClass) {
+  // Page alignment keeps every block aligned to its own size.
+  char *slab = static_cast<char *>(aligned_alloc(4096, slabSize));
+  slabRecord *record = static_cast<slabRecord *>(malloc(sizeof(slabRecord)));
+  if (!slab || !record) {
+    free(slab);
+    free(record);
+    return nullptr;
+  }
+  Memory::recordAllocation(MEMTAG_POOLS, slabSize);
+  record->slab = slab;
+  record->next = slabs.load(std::memory_order_relaxed);
+  while (!slabs.compare_exchange_weak(record->next, record,
+                                      std::memory_order_relaxed))
+    ;
+
+  size_t size = blockSize(sizeClass);
+  size_t blocks = slabSize / size;
+  freeBlock *first = nullptr;
+  for (size_t start = 0; start < blocks; start += batchSize) {
+    size_t end = start + batchSize < blocks ? start + batchSize : blocks;
+    for (size_t i = start; i < end; i++) {
+      freeBlock *b = reinterpret_cast<freeBlock *>(slab + i * size);
+      b->next = i + 1 < end ? reinterpret_cast<freeBlock *>(slab + (i + 1) * size)
+                            : nullptr;
+      new (&b->nextBatch) std::atomic<freeBlock *>(nullptr);
+    }
+    freeBlock *batch = reinterpret_cast<freeBlock *>(slab + start * size);
+    if (!first)
+      first = batch;
+    else
+      pushBatch(sizeClass, batch);
+  }
+  return first;
+}
+
+void *PoolAllocator::allocate(size_t size) {
+  if (size > maxBlock) return Memory::allocate(size, Memory::currentTag());
+
+  size_t c = classFor(size);
+  threadCache &tc = cache();
+  freeBlock *b = tc.lists[c];
+  if (!b) {
+    b = popBatch(c);
+    if (!b) b = carveSlab(c);
+    if (!b) return nullptr;
+    size_t count = 0;
+    for (freeBlock *i = b; i; i = i->next) count++;
+    tc.counts[c] = count;
+  }
+  tc.lists[c] = b->next;
+  tc.counts[c]--;
+  return b;
+}
+
+void PoolAllocator::deallocate(void *pointer, size_t size) {
+  if (!pointer) return;
+  if (size > maxBlock) {
+    Memory::deallocate(pointer);
+    return;
+  }
+
+  size_t c = classFor(size);
+  threadCache &tc = cache();
+  freeBlock *b = static_cast<freeBlock *>(pointer);
+  new (&b->nextBatch) std::atomic<freeBlock *>(nullptr);
+  b->next = tc.lists[c];
+  tc.lists[c] = b;
+
+  // Keep at most two batches locally; give one back to the global stack.
+  if (++tc.counts[c] >= 2 * batchSize) {
+    freeBlock *batch = tc.lists[c];
+    freeBlock *last = batch;
+    for (size_t i = 1; i < batchSize; i++) last = last->next;
+    tc.lists[c] = last->next;
+    last->next = nullptr;
+    tc.counts[c] -= batchSize;
+    pushBatch(c, batch);
+  }
+}
+
+size_t PoolAllocator::globalBatches(size_t sizeClass) {
+  return stacks[sizeClass].count.load(std::memory_order_relaxed);
+}
+
+//--- PoolResource
+
+PoolResource *PoolResource::instance() {
+  static PoolResource resource;
+  return &resource;
+}
+
+void *PoolResource::do_allocate(size_t size, size_t alignment) {
+  // Blocks are aligned to their size, so round small requests up to the
+  // alignment. Anything that doesn't fit the largest block bypasses the
+  // pools, which would otherwise drop the alignment.
+  if (size > PoolAllocator::maxBlock || alignment > PoolAllocator::maxBlock) {
+    void *pointer = Memory::allocate(size, Memory::currentTag(), alignment);
+    if (!pointer) throw std::bad_alloc();
+    return pointer;
+  }
+  void *pointer = PoolAllocator::allocate(size > alignment ? size : alignment);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+
+void PoolResource::do_deallocate(void *pointer, size_t size,
+                                 size_t alignment) {
+  if (size > PoolAllocator::maxBlock || alignment > PoolAllocator::maxBlock)
+    Memory::deallocate(pointer);
+  else
+    PoolAllocator::deallocate(pointer, size > alignment ? size : alignment);
+}
@@ -0,0 +1,75 @@
+#ifndef POOLALLOCATOR_H
+#define POOLALLOCATOR_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+
+// Size-class allocator for small, frequently recycled objects. Each thread
+// keeps a short free list per class; threads exchange whole batches of
+// blocks through a lock-free global stack, and new blocks are carved out of
+// 64KB slabs. Slabs are never returned to the system, so memory settles at
+// the high-water mark instead of fragmenting the heap. Requests larger than
+// the biggest class go to Memory::allocate under the current memory tag.
+class PoolAllocator {
+ public:
+  static constexpr size_t classCount = 8;
+  static constexpr size_t minBlock = 16;
+  static constexpr size_t maxBlock = minBlock << (classCount - 1);  // 2048
+  static constexpr size_t batchSize = 32;  // blocks moved at a time
+  static constexpr size_t slabSize = 64 * 1024;
+
+  static void *allocate(size_t size);
+  static void deallocate(void *pointer, size_t size);  /// Same size as given
+                                                       /// to allocate().
+  static constexpr size_t classFor(size_t size) {
+    size_t c = 0;
+    while ((minBlock << c) < size) c++;
+    return c;
+  }
+  static constexpr size_t blockSize(size_t sizeClass) {
+    return minBlock << sizeClass;
+  }
+
+  // Blocks of a class held outside thread caches, across all threads.
+  static size_t globalBatches(size_t sizeClass);
+
+ private:
+  struct freeBlock {
+    freeBlock *next;  // next block in the same batch or cache
+    // Only used by the first block of a batch. Atomic because a thread
+    // popping a stale head may read it while the block is being reused;
+    // the tagged CAS then fails and the value is discarded.
+    std::atomic<freeBlock *> nextBatch;
+  };
+  // Treiber stack of batches. The head packs a 48-bit pointer with a 16-bit
+  // tag bumped on every update, which rules out ABA on 64-bit targets.
+  struct alignas(64) batchStack {
+    std::atomic<unsigned long long> head{0};
+    std::atomic<size_t> count{0};
+  };
+  struct threadCache;
+
+  static void pushBatch(size_t sizeClass, freeBlock *batch);
+  static freeBlock *popBatch(size_t sizeClass);
+  static freeBlock *carveSlab(size_t sizeClass);
+  static threadCache &cache();
+
+  static batchStack stacks[classCount];
+};
+
+// std::pmr adapter over PoolAllocator.
+class PoolResource : public std::pmr::memory_resource {
+ public:
+  static PoolResource *instance();
+
+ private:
+  void *do_allocate(size_t size, size_t alignment) override;
+  void do_deallocate(void *pointer, size_t size, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other)
+      const noexcept override {
+    return this == &other;
+  }
+};
+
+#endif  // POOLALLOCATOR_H
@@ -0,0 +1,295 @@
+#include "metrics.h"
+
+#include <stdio.h>
+
+#include <chrono>
+#include <cstring>
+
+#include "memory/memorytracker.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define METRICS_HAVE_SOCKETS 1
+#ifdef MSG_NOSIGNAL
+// A scraper hanging up early must not SIGPIPE the whole process.
+static const int sendFlags = MSG_NOSIGNAL;
+#else
+static const int sendFlags = 0;
+#endif
+#endif
+
+namespace Metrics {
+
+size_t shardIndex() {
+  static std::atomic<size_t> next{0};
+  thread_local size_t index = next.fetch_add(1) % shardCount;
+  return index;
+}
+
+//--- Counter, Gauge
+
+unsigned long long Counter::value() const {
+  unsigned long long total = 0;
+  for (const shard &s : shards) total += s.value.load(std::memory_order_relaxed);
+  return total;
+}
+
+void Gauge::add(double v) {
+  double current = value_.load(std::memory_order_relaxed);
+  while (!value_.compare_exchange_weak(current, current + v,
+                                       std::memory_order_relaxed))
+    ;
+}
+
+//--- Histogram
+
+unsigned int Histogram::bucketFor(unsigned long long value) {
+  if (value < subBuckets) return static_cast<unsigned int>(value);
+  unsigned int msb = 63 - static_cast<unsigned int>(__builtin_clzll(value));
+  unsigned int shift = msb - subBucketBits;
+  return (shift + 1) * subBuckets +
+         static_cast<unsigned int>((value >> shift) - subBuckets);
+}
+
+unsigned long long Histogram::bucketUpperBound(unsigned int bucket) {
+  if (bucket < 2 * subBuckets) return bucket;
+  unsigned int shift = bucket / subBuckets - 1;
+  unsigned long long lower =
+      static_cast<unsigned long long>(subBuckets + bucket % subBuckets)
+      << shift;
+  return lower + ((1ull << shift) - 1);
+}
+
+void Histogram::record(unsigned long long value) {
+  shard &s = shards[shardIndex()];
+  s.buckets[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+  s.count.fetch_add(1, std::memory_order_relaxed);
+  s.sum.fetch_add(value, std::memory_order_relaxed);
+  unsigned long long max = s.max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !s.max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+    ;
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  Snapshot result;
+  result.buckets.assign(bucketCount, 0);
+  for (size_t i = 0; i < shardCount; i++) {
+    const shard &s = shards[i];
+    result.count += s.count.load(std::memory_order_relaxed);
+    result.sum += s.sum.load(std::memory_order_relaxed);
+    unsigned long long max = s.max.load(std::memory_order_relaxed);
+    if (max > result.max) result.max = max;
+    for (unsigned int b = 0; b < bucketCount; b++)
+      result.buckets[b] += s.buckets[b].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+double Histogram::Snapshot::percentile(double p) const {
+  if (count == 0) return 0;
+  unsigned long long total = 0;
+  for (unsigned long long n : buckets) total += n;
+  // Shards are read one after another, so `count` can run ahead of the
+  // buckets; rank against what was actually merged.
+  double rank = p / 100 * static_cast<double>(total);
+  unsigned long long seen = 0;
+  for (unsigned int b = 0; b < bucketCount; b++) {
+    seen += buckets[b];
+    if (buckets[b] && static_cast<double>(seen) >= rank) {
+      unsigned long long upper = bucketUpperBound(b);
+      return static_cast<double>(upper < max ? upper : max);
+    }
+  }
+  return static_cast<double>(max);
+}
+
+//--- Registry
+
+Registry &Registry::instance() {
+  static Registry registry;
+  return registry;
+}
+
+void *Registry::find(const char *name, type kind) const {
+  for (const entry &e : entries)
+    if (e.kind == kind && e.name == name) return e.metric;
+  return nullptr;
+}
+
+Counter &Registry::counter(const char *name, const char *help) {
+  MemoryScope scope(MEMTAG_METRICS);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (void *existing = find(name, TYPE_COUNTER))
+    return *static_cast<Counter *>(existing);
+  counters.emplace_back(new Counter);
+  entries.push_back(entry{name, help, TYPE_COUNTER, counters.back().get()});
+  return *counters.back();
+}
+
+Gauge &Registry::gauge(const char *name, const char *help) {
+  MemoryScope scope(MEMTAG_METRICS);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (void *existing = find(name, TYPE_GAUGE))
+    return *static_cast<Gauge *>(existing);
+  gauges.emplace_back(new Gauge);
+  entries.push_back(entry{name, help, TYPE_GAUGE, gauges.back().get()});
+  return *gauges.back();
+}
+
+Histogram &Registry::histogram(const char *name, const char *help) {
+  MemoryScope scope(MEMTAG_METRICS);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (void *existing = find(name, TYPE_HISTOGRAM))
+    return *static_cast<Histogram *>(existing);
+  histograms.emplace_back(new Histogram);
+  entries.push_back(entry{name, help, TYPE_HISTOGRAM, histograms.back().get()});
+  return *histograms.back();
+}
+
+std::string Registry::prometheusText() const {
+  static const char *typeNames[] = {"counter", "gauge", "summary"};
+  static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::string text;
+  char line[256];
+  for (const entry &e : entries) {
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n",
+             e.name.c_str(), e.help.c_str(), e.name.c_str(),
+             typeNames[e.kind]);
+    text += line;
+    switch (e.kind) {
+      case TYPE_COUNTER:
+        snprintf(line, sizeof(line), "%s %llu\n", e.name.c_str(),
+                 static_cast<Counter *>(e.metric)->value());
+        text += line;
+        break;
+      case TYPE_GAUGE:
+        snprintf(line, sizeof(line), "%s %.17g\n", e.name.c_str(),
+                 static_cast<Gauge *>(e.metric)->value());
+        text += line;
+        break;
+      case TYPE_HISTOGRAM: {
+        Histogram::Snapshot s = static_cast<Histogram *>(e.metric)->snapshot();
+        for (double q : quantiles) {
+          snprintf(line, sizeof(line), "%s{quantile=\"%g\"} %.17g\n",
+                   e.name.c_str(), q, s.percentile(q * 100));
+          text += line;
+        }
+        snprintf(line, sizeof(line), "%s_sum %llu\n%s_count %llu\n",
+                 e.name.c_str(), s.sum, e.name.c_str(), s.count);
+        text += line;
+        break;
+      }
+    }
+  }
+  return text;
+}
+
+//--- Exporter
+
+bool Exporter::start(const char *file, const char *socket,
+                     double intervalSeconds) {
+  stop();
+  filePath = file ? file : "";
+  socketPath = socket ? socket : "";
+  interval = intervalSeconds > 0 ? intervalSeconds : 10;
+
+#ifdef METRICS_HAVE_SOCKETS
+  if (!socketPath.empty()) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) return 1;
+    memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenSocket < 0) return 1;
+    unlink(socketPath.c_str());
+    if (bind(listenSocket, reinterpret_cast<sockaddr *>(&address),
+             sizeof(address)) ||
+        listen(listenSocket, 4)) {
+      close(listenSocket);
+      listenSocket = -1;
+      return 1;
+    }
+  }
+#else
+  if (!socketPath.empty()) return 1;
+#endif
+
+  running.store(true);
+  worker = std::thread(&Exporter::run, this);
+  return 0;
+}
+
+void Exporter::stop() {
+  if (!running.exchange(false)) return;
+  worker.join();
+  if (!filePath.empty()) writeFile();
+#ifdef METRICS_HAVE_SOCKETS
+  if (listenSocket >= 0) {
+    close(listenSocket);
+    unlink(socketPath.c_str());
+    listenSocket = -1;
+  }
+#endif
+}
+
+void Exporter::writeFile() const {
+  // Write then rename so readers never see a partial snapshot.
+  std::string temporary = filePath + ".tmp";
+  FILE *file = fopen(temporary.c_str(), "w");
+  if (!file) return;
+  std::string text = Registry::instance().prometheusText();
+  fwrite(text.data(), 1, text.size(), file);
+  fclose(file);
+  rename(temporary.c_str(), filePath.c_str());
+}
+
+void Exporter::run() {
+  MemoryScope scope(MEMTAG_METRICS);
+  using clock = std::chrono::steady_clock;
+  auto period = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(interval));
+  auto next = clock::now() + period;
+
+  while (running.load()) {
+    // Wake at least every 100ms so stop() doesn't wait out a long interval.
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next - clock::now());
+    if (wait.count() > 100) wait = std::chrono::milliseconds(100);
+    if (wait.count() < 0) wait = std::chrono::milliseconds(0);
+
+#ifdef METRICS_HAVE_SOCKETS
+    if (listenSocket >= 0) {
+      pollfd fd = {listenSocket, POLLIN, 0};
+      if (poll(&fd, 1, static_cast<int>(wait.count())) > 0) {
+        int client = accept(listenSocket, nullptr, nullptr);
+        if (client >= 0) {
+          std::string text = Registry::instance().prometheusText();
+          size_t sent = 0;
+          while (sent < text.size()) {
+            ssize_t n = send(client, text.data() + sent, text.size() - sent,
+                             sendFlags);
+            if (n <= 0) break;
+            sent += static_cast<size_t>(n);
+          }
+          close(client);
+        }
+      }
+    } else
+#endif
+      std::this_thread::sleep_for(wait);
+
+    if (clock::now() >= next) {
+      if (!filePath.empty()) writeFile();
+      next += period;
+    }
+  }
+}
+
+}  // namespace Metrics
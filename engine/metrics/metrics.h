@@ -0,0 +1,130 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Metric updates touch only the calling thread's shard with a relaxed atomic,
+// so hot paths never contend; reads merge every shard.
+namespace Metrics {
+
+constexpr size_t shardCount = 16;
+size_t shardIndex();  /// Stable per thread.
+
+class Counter {
+ public:
+  void add(unsigned long long n = 1) {
+    shards[shardIndex()].value.fetch_add(n, std::memory_order_relaxed);
+  }
+  unsigned long long value() const;
+
+ private:
+  struct alignas(64) shard {
+    std::atomic<unsigned long long> value{0};
+  };
+  shard shards[shardCount];
+};
+
+class Gauge {
+ public:
+  void set(double v) { value_.store(v, std::memory_order_relaxed); }
+  void add(double v);
+  double value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+// Log-linear (HDR-style) histogram of non-negative integers: each power of
+// two is split into subBuckets linear buckets, so any recorded value is
+// reproduced within 1 / subBuckets (12.5%) relative error.
+class Histogram {
+ public:
+  static constexpr unsigned int subBucketBits = 3;
+  static constexpr unsigned int subBuckets = 1u << subBucketBits;
+  static constexpr unsigned int bucketCount = (64 - subBucketBits + 1) *
+                                              subBuckets;
+
+  struct Snapshot {
+    unsigned long long count = 0;
+    unsigned long long sum = 0;
+    unsigned long long max = 0;
+    std::vector<unsigned long long> buckets;
+    double percentile(double p) const;  /// p in [0, 100]
+  };
+
+  void record(unsigned long long value);
+  Snapshot snapshot() const;
+
+  static unsigned int bucketFor(unsigned long long value);
+  static unsigned long long bucketUpperBound(unsigned int bucket);
+
+ private:
+  struct alignas(64) shard {
+    std::atomic<unsigned long long> count{0};
+    std::atomic<unsigned long long> sum{0};
+    std::atomic<unsigned long long> max{0};
+    std::atomic<unsigned long long> buckets[bucketCount] = {};
+  };
+  std::unique_ptr<shard[]> shards{new shard[shardCount]};
+};
+
+class Registry {
+ public:
+  static Registry &instance();
+
+  // Registration takes a lock and is meant for startup; keep the returned
+  // reference (it lives as long as the process) rather than looking it up
+  // every time. Asking for an existing name returns the same metric.
+  Counter &counter(const char *name, const char *help);
+  Gauge &gauge(const char *name, const char *help);
+  Histogram &histogram(const char *name, const char *help);
+
+  std::string prometheusText() const;  /// Prometheus text format 0.0.4
+
+ private:
+  enum type { TYPE_COUNTER, TYPE_GAUGE, TYPE_HISTOGRAM };
+  struct entry {
+    std::string name;
+    std::string help;
+    type kind;
+    void *metric;
+  };
+  void *find(const char *name, type kind) const;
+
+  mutable std::mutex mutex;
+  std::vector<entry> entries;
+  std::vector<std::unique_ptr<Counter>> counters;
+  std::vector<std::unique_ptr<Gauge>> gauges;
+  std::vector<std::unique_ptr<Histogram>> histograms;
+};
+
+// Background thread that periodically writes a snapshot to a file and/or
+// answers scrapes on a local UNIX socket.
+class Exporter {
+ public:
+  ~Exporter() { stop(); }
+  bool start(const char *filePath, const char *socketPath,
+             double intervalSeconds);  /// Returns 1 on failure.
+  void stop();
+
+ private:
+  void run();
+  void writeFile() const;
+
+  std::string filePath;
+  std::string socketPath;
+  int listenSocket = -1;
+  double interval = 10;
+  std::atomic<bool> running{false};
+  std::thread worker;
+};
+
+}  // namespace Metrics
+
+#endif  // METRICS_H
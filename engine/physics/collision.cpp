@@ -0,0 +1,314 @@
+#include "collision.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "linearmath/trig.h"
+
+using LinearMath::Aabb;
+using LinearMath::ConvexPolygon;
+using LinearMath::Vec2;
+
+namespace Physics {
+
+namespace {
+// How much deeper a's best axis must be than b's before b's face is used
+// as the reference instead, so the choice doesn't flicker between equals.
+constexpr float referenceTolerance = 0.0005f;
+// timeOfImpact() gives up after this many steps towards the hit, returning
+// how far it got.
+constexpr int toiIterations = 20;
+
+ConvexPolygon transformed(const ConvexPolygon &local, const Transform &t) {
+  ConvexPolygon world;
+  world.count = local.count;
+  for (int i = 0; i < ConvexPolygon::maxVertices; i++) {
+    Vec2 p = t.apply(local.vertex(i));
+    Vec2 n = t.turn(local.normal(i));
+    world.x[i] = p.x;
+    world.y[i] = p.y;
+    world.normalX[i] = n.x;
+    world.normalY[i] = n.y;
+  }
+  return world;
+}
+
+struct clipVertex {
+  Vec2 point;
+  uint32_t id;
+};
+
+// Keeps the part of the segment where dot(normal, p) <= offset; a cut
+// end is tagged with `id`. Returns how many ends are left.
+int clip(const clipVertex in[2], clipVertex out[2], Vec2 normal, float offset,
+         uint32_t id) {
+  int count = 0;
+  float d0 = dot(normal, in[0].point) - offset;
+  float d1 = dot(normal, in[1].point) - offset;
+  if (d0 <= 0) out[count++] = in[0];
+  if (d1 <= 0) out[count++] = in[1];
+  if (d0 * d1 < 0) {
+    float t = d0 / (d0 - d1);
+    out[count++] = {in[0].point + (in[1].point - in[0].point) * t, id};
+  }
+  return count;
+}
+
+void collideCircles(const Shape &a, const Transform &ta, const Shape &b,
+                    const Transform &tb, float margin, Manifold *m) {
+  Vec2 d = tb.position - ta.position;
+  float distance = length(d);
+  float separation = distance - a.radius - b.radius;
+  if (separation > margin) return;
+  m->normal = distance > 0 ? d / distance : Vec2{0, 1};
+  m->points[0] = {
+      ta.position + m->normal * (a.radius + 0.5f * separation), separation,
+      0};
+  m->pointCount = 1;
+}
+
+// The gap between a polygon and a circle, and its normal and features.
+float polygonCircleSeparation(const ConvexPolygon &polygon, Vec2 c,
+                              float radius, Vec2 *normal, uint32_t *id) {
+  int edge = 0;
+  float most = -INFINITY;
+  for (int i = 0; i < polygon.count; i++) {
+    float s = dot(polygon.normal(i), c - polygon.vertex(i));
+    if (s > most) {
+      most = s;
+      edge = i;
+    }
+  }
+  Vec2 v1 = polygon.vertex(edge);
+  Vec2 v2 = polygon.vertex(edge + 1 < polygon.count ? edge + 1 : 0);
+  *normal = polygon.normal(edge);
+  *id = static_cast<uint32_t>(edge);
+  // Outside the edge's span the nearest feature is a corner.
+  if (most > 0 && dot(c - v1, v2 - v1) < 0) {
+    Vec2 d = c - v1;
+    *normal = d / length(d);
+    *id |= 0x100;
+    return length(d) - radius;
+  }
+  if (most > 0 && dot(c - v2, v1 - v2) < 0) {
+    Vec2 d = c - v2;
+    *normal = d / length(d);
+    *id |= 0x200;
+    return length(d) - radius;
+  }
+  return most - radius;
+}
+
+void collidePolygonCircle(const Shape &a, const Transform &ta,
+                          const Shape &b, const Transform &tb, float margin,
+                          Manifold *m) {
+  ConvexPolygon polygon = transformed(a.polygon, ta);
+  Vec2 c = tb.position;
+  Vec2 normal;
+  uint32_t id;
+  float separation = polygonCircleSeparation(polygon, c, b.radius, &normal,
+                                             &id);
+  if (separation > margin) return;
+  m->normal = normal;
+  m->points[0] = {c - normal * (b.radius + 0.5f * separation), separation,
+                  id};
+  m->pointCount = 1;
+}
+
+// The farthest any point of the shape is from the body's center.
+float reach(const Shape &shape) {
+  if (shape.type == SHAPE_CIRCLE) return shape.radius;
+  float most = 0;
+  for (int i = 0; i < shape.polygon.count; i++)
+    most = std::max(most, length(shape.polygon.vertex(i)));
+  return most;
+}
+
+// Clips the edge of one polygon that faces the other's most separating
+// edge (the reference edge) against that edge's sides.
+void collidePolygons(const Shape &a, const Transform &ta, const Shape &b,
+                     const Transform &tb, float margin, Manifold *m) {
+  ConvexPolygon polygonA = transformed(a.polygon, ta);
+  ConvexPolygon polygonB = transformed(b.polygon, tb);
+  int edgeA, edgeB;
+  float separationA = maxSeparation(polygonA, polygonB, &edgeA);
+  if (separationA > margin) return;
+  float separationB = maxSeparation(polygonB, polygonA, &edgeB);
+  if (separationB > margin) return;
+
+  const ConvexPolygon *reference = &polygonA, *incident = &polygonB;
+  int edge = edgeA;
+  bool flip = separationB > separationA + referenceTolerance;
+  if (flip) {
+    std::swap(reference, incident);
+    edge = edgeB;
+  }
+  Vec2 normal = reference->normal(edge);
+  int incidentEdge = 0;
+  float leastDot = INFINITY;
+  for (int i = 0; i < incident->count; i++) {
+    float d = dot(normal, incident->normal(i));
+    if (d < leastDot) {
+      leastDot = d;
+      incidentEdge = i;
+    }
+  }
+  int incidentNext = incidentEdge + 1 < incident->count ? incidentEdge + 1 : 0;
+  uint32_t base = static_cast<uint32_t>(flip) << 16 |
+                  static_cast<uint32_t>(edge) << 8 |
+                  static_cast<uint32_t>(incidentEdge) << 4;
+  clipVertex segment[2] = {{incident->vertex(incidentEdge), base},
+                           {incident->vertex(incidentNext), base | 1}};
+
+  Vec2 r1 = reference->vertex(edge);
+  Vec2 r2 = reference->vertex(edge + 1 < reference->count ? edge + 1 : 0);
+  Vec2 tangent = normalize(r2 - r1);
+  clipVertex once[2], twice[2];
+  if (clip(segment, once, -tangent, -dot(tangent, r1), base | 2) < 2) return;
+  if (clip(once, twice, tangent, dot(tangent, r2), base | 3) < 2) return;
+
+  m->normal = flip ? -normal : normal;
+  int count = 0;
+  for (const clipVertex &v : twice) {
+    float separation = dot(normal, v.point - r1);
+    if (separation > margin) continue;
+    m->points[count++] = {v.point - normal * (0.5f * separation), separation,
+                          v.id};
+  }
+  m->pointCount = count;
+}
+}  // namespace
+
+Transform Sweep::at(float t) const {
+  float angle = startAngle + (endAngle - startAngle) * t;
+  return {start + (end - start) * t, LinearMath::direction(angle)};
+}
+
+Shape Shape::circle(float radius) {
+  Shape s;
+  s.type = SHAPE_CIRCLE;
+  s.radius = radius;
+  return s;
+}
+
+Shape Shape::box(float halfWidth, float halfHeight) {
+  Aabb box = {{-halfWidth, -halfHeight}, {halfWidth, halfHeight}};
+  return convex(ConvexPolygon::fromAabb(box));
+}
+
+Shape Shape::convex(const ConvexPolygon &polygon) {
+  Shape s;
+  s.type = SHAPE_POLYGON;
+  s.radius = 0;
+  s.polygon = polygon;
+  return s;
+}
+
+// Polygons are summed as triangles fanned from the first corner, which
+// keeps the products small for polygons far from the origin.
+MassData massOf(const Shape &shape, float density) {
+  if (shape.type == SHAPE_CIRCLE) {
+    float mass = density * 3.14159265f * shape.radius * shape.radius;
+    return {mass, 0.5f * mass * shape.radius * shape.radius, {}};
+  }
+  const ConvexPolygon &p = shape.polygon;
+  Vec2 origin = p.vertex(0);
+  float area = 0, inertia = 0;
+  Vec2 center;
+  for (int i = 1; i + 1 < p.count; i++) {
+    Vec2 e1 = p.vertex(i) - origin, e2 = p.vertex(i + 1) - origin;
+    float d = cross(e1, e2);
+    area += 0.5f * d;
+    center += (e1 + e2) * (d / 6);
+    float xx = e1.x * e1.x + e2.x * e1.x + e2.x * e2.x;
+    float yy = e1.y * e1.y + e2.y * e1.y + e2.y * e2.y;
+    inertia += d / 12 * (xx + yy);
+  }
+  center = center / area;
+  float mass = density * area;
+  // The sum is about the first corner; move it to the centroid.
+  return {mass, density * inertia - mass * dot(center, center),
+          origin + center};
+}
+
+float innerRadius(const Shape &shape) {
+  if (shape.type == SHAPE_CIRCLE) return shape.radius;
+  float least = INFINITY;
+  for (int i = 0; i < shape.polygon.count; i++)
+    least = std::min(least,
+                     dot(shape.polygon.normal(i), shape.polygon.vertex(i)));
+  return std::max(least, 0.0f);
+}
+
+Aabb bounds(const Shape &shape, const Transform &t) {
+  if (shape.type == SHAPE_CIRCLE)
+    return {t.position - Vec2(shape.radius), t.position + Vec2(shape.radius)};
+  Vec2 first = t.apply(shape.polygon.vertex(0));
+  Aabb box = {first, first};
+  for (int i = 1; i < shape.polygon.count; i++) {
+    Vec2 p = t.apply(shape.polygon.vertex(i));
+    box = {min(box.min, p), max(box.max, p)};
+  }
+  return box;
+}
+
+void collide(const Shape &a, const Transform &ta, const Shape &b,
+             const Transform &tb, float margin, Manifold *manifold) {
+  manifold->pointCount = 0;
+  if (a.type == SHAPE_CIRCLE && b.type == SHAPE_CIRCLE) {
+    collideCircles(a, ta, b, tb, margin, manifold);
+  } else if (a.type == SHAPE_POLYGON && b.type == SHAPE_POLYGON) {
+    collidePolygons(a, ta, b, tb, margin, manifold);
+  } else if (a.type == SHAPE_POLYGON) {
+    collidePolygonCircle(a, ta, b, tb, margin, manifold);
+  } else {
+    collidePolygonCircle(b, tb, a, ta, margin, manifold);
+    manifold->normal = -manifold->normal;
+  }
+}
+
+// Two convex polygons are apart by at least the gap along any edge normal,
+// and when apart, one of those normals shows it.
+float distance(const Shape &a, const Transform &ta, const Shape &b,
+               const Transform &tb) {
+  if (a.type == SHAPE_CIRCLE && b.type == SHAPE_CIRCLE)
+    return length(tb.position - ta.position) - a.radius - b.radius;
+  Vec2 normal;
+  uint32_t id;
+  if (a.type == SHAPE_CIRCLE)
+    return polygonCircleSeparation(transformed(b.polygon, tb), ta.position,
+                                   a.radius, &normal, &id);
+  if (b.type == SHAPE_CIRCLE)
+    return polygonCircleSeparation(transformed(a.polygon, ta), tb.position,
+                                   b.radius, &normal, &id);
+  ConvexPolygon polygonA = transformed(a.polygon, ta);
+  ConvexPolygon polygonB = transformed(b.polygon, tb);
+  int edge;
+  return std::max(maxSeparation(polygonA, polygonB, &edge),
+                  maxSeparation(polygonB, polygonA, &edge));
+}
+
+// Conservative advancement: no point of either shape moves faster than
+// `bound` over the sweep, so neither can close the gap in less time than
+// the gap over `bound`. Stepping by that never passes the hit, and the
+// steps shrink as the gap does.
+float timeOfImpact(const Shape &a, const Sweep &sa, const Shape &b,
+                   const Sweep &sb, float target) {
+  float bound = length((sb.end - sb.start) - (sa.end - sa.start)) +
+                fabsf(sa.endAngle - sa.startAngle) * reach(a) +
+                fabsf(sb.endAngle - sb.startAngle) * reach(b);
+  float tolerance = 0.25f * target;
+  float t = 0;
+  for (int i = 0; i < toiIterations; i++) {
+    float gap = distance(a, sa.at(t), b, sb.at(t));
+    if (gap < target + tolerance) return t;
+    if (bound <= 0) return 1;
+    t += (gap - target) / bound;
+    if (t >= 1) return 1;
+  }
+  return t;
+}
+
+}  // namespace Physics
@@ -0,0 +1,92 @@
+#ifndef PHYSICS_COLLISION_H
+#define PHYSICS_COLLISION_H
+
+#include <stdint.h>
+
+#include "linearmath/geometry.h"
+
+// Shapes and the narrowphase: contact manifolds between pairs of shapes,
+// for the solver in world.h.
+
+namespace Physics {
+
+enum shapeType : unsigned char { SHAPE_CIRCLE = 0, SHAPE_POLYGON };
+
+// A body's collider in the body's frame. World::createBody moves polygons
+// so that their centroid, the body's center of mass, is at the origin.
+struct Shape {
+  shapeType type = SHAPE_CIRCLE;
+  float radius = 0.5f;  // circles only
+  LinearMath::ConvexPolygon polygon;
+
+  static Shape circle(float radius);
+  static Shape box(float halfWidth, float halfHeight);
+  static Shape convex(const LinearMath::ConvexPolygon &polygon);
+};
+
+// Rotation by `rotation`, (cos, sin) of the angle, then translation.
+struct Transform {
+  LinearMath::Vec2 position;
+  LinearMath::Vec2 rotation = {1, 0};
+
+  constexpr LinearMath::Vec2 apply(LinearMath::Vec2 p) const {
+    return position + turn(p);
+  }
+  constexpr LinearMath::Vec2 turn(LinearMath::Vec2 v) const {
+    return {rotation.x * v.x - rotation.y * v.y,
+            rotation.y * v.x + rotation.x * v.y};
+  }
+};
+
+// A body's motion over a step, for timeOfImpact(): its center and angle
+// go linearly from start to end.
+struct Sweep {
+  LinearMath::Vec2 start;
+  LinearMath::Vec2 end;
+  float startAngle;
+  float endAngle;
+
+  Transform at(float t) const;
+};
+
+struct MassData {
+  float mass;
+  float inertia;            // about the center
+  LinearMath::Vec2 center;  // in the shape's frame
+};
+
+struct ManifoldPoint {
+  LinearMath::Vec2 point;  // midway between the two surfaces
+  float separation;        // negative when they overlap
+  uint32_t id;             // the features that made it, for warm starting
+};
+
+// Where two shapes touch or nearly do; the normal points from the first
+// shape to the second.
+struct Manifold {
+  LinearMath::Vec2 normal;
+  ManifoldPoint points[2];
+  int pointCount = 0;
+};
+
+MassData massOf(const Shape &shape, float density);
+// The largest circle about the shape's origin that fits inside it.
+float innerRadius(const Shape &shape);
+LinearMath::Aabb bounds(const Shape &shape, const Transform &transform);
+// Keeps points up to `margin` apart as well as touching ones, so the solver
+// can stop bodies as they arrive instead of after they overlap.
+void collide(const Shape &a, const Transform &transformA, const Shape &b,
+             const Transform &transformB, float margin, Manifold *manifold);
+
+// At most the gap between the shapes, and exact unless two corners are
+// nearest; negative when they overlap.
+float distance(const Shape &a, const Transform &transformA, const Shape &b,
+               const Transform &transformB);
+// The fraction of the sweeps at which the shapes first come within
+// `target` of each other: 0 if they start that close, 1 if they never do.
+float timeOfImpact(const Shape &a, const Sweep &sweepA, const Shape &b,
+                   const Sweep &sweepB, float target);
+
+}  // namespace Physics
+
+#endif  // PHYSICS_COLLISION_H
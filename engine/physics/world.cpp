@@ -0,0 +1,631 @@
+#include "world.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "jobs/jobsystem.h"
+#include "linearmath/batch.h"
+#include "linearmath/trig.h"
+#include "profiler/profiler.h"
+
+using LinearMath::Aabb;
+using LinearMath::Vec2;
+using LinearMath::Batch::Points2;
+
+namespace Physics {
+
+namespace {
+// Tree boxes are fattened by this, so most steps move no proxies.
+constexpr float treeMargin = 0.1f;
+// Shapes this close count as touching; see collide().
+constexpr float speculativeDistance = 0.02f;
+// Overlap left alone, so resting contacts don't jitter.
+constexpr float linearSlop = 0.005f;
+// The fraction of deeper overlap pushed out per step, and the most speed
+// that pushing may add.
+constexpr float baumgarte = 0.2f;
+constexpr float maxPushout = 3;
+// Slower impacts don't bounce, so resting bodies settle.
+constexpr float restitutionThreshold = 1;
+constexpr size_t pairGrain = 64;
+constexpr size_t contactGrain = 64;
+constexpr size_t bulletGrain = 16;
+// A bullet's core, swept once it touches something, as a fraction of the
+// largest circle that fits inside it.
+constexpr float coreFraction = 0.25f;
+
+// w x r for a scalar angular velocity.
+constexpr Vec2 crossScalar(float w, Vec2 r) { return {-w * r.y, w * r.x}; }
+
+template <typename F>
+void forRange(JobSystem *jobs, size_t count, size_t grain, F &&body) {
+  if (jobs)
+    jobs->parallelFor(count, grain, body);
+  else if (count)
+    body(size_t{0}, count);
+}
+}  // namespace
+
+World::World(Vec2 gravity) : gravity(gravity), tree(treeMargin) {
+  islandStart.push_back(0);
+}
+
+//--- Bodies
+
+BodyHandle World::createBody(const BodyDef &def) {
+  Shape shape = def.shape;
+  Vec2 offset;
+  if (shape.type == SHAPE_POLYGON) {
+    offset = massOf(shape, 1).center;
+    for (int i = 0; i < LinearMath::ConvexPolygon::maxVertices; i++) {
+      shape.polygon.x[i] -= offset.x;
+      shape.polygon.y[i] -= offset.y;
+    }
+  }
+  MassData mass = massOf(shape, def.density);
+  bool dynamic = def.type == BODY_DYNAMIC;
+  bool moving = def.type != BODY_STATIC;
+  Transform t = {{}, LinearMath::direction(def.angle)};
+  t.position = def.position + t.turn(offset);
+
+  uint32_t index;
+  if (freeSlot != ~0u) {
+    index = freeSlot;
+    freeSlot = slots[index].dense;
+  } else {
+    index = static_cast<uint32_t>(slots.size());
+    slots.push_back({0, 1, false});
+  }
+  slot &s = slots[index];
+  s.dense = static_cast<uint32_t>(shapes.size());
+  s.live = true;
+
+  positionX.push_back(t.position.x);
+  positionY.push_back(t.position.y);
+  angles.push_back(def.angle);
+  cosines.push_back(t.rotation.x);
+  sines.push_back(t.rotation.y);
+  velocityX.push_back(moving ? def.velocity.x : 0);
+  velocityY.push_back(moving ? def.velocity.y : 0);
+  angularVelocities.push_back(moving ? def.angularVelocity : 0);
+  forceX.push_back(0);
+  forceY.push_back(0);
+  torques.push_back(0);
+  accelerationX.push_back(0);
+  accelerationY.push_back(0);
+  inverseMass.push_back(dynamic && mass.mass > 0 ? 1 / mass.mass : 0);
+  inverseInertia.push_back(dynamic && mass.inertia > 0 ? 1 / mass.inertia
+                                                       : 0);
+  gravityScale.push_back(dynamic ? 1 : 0);
+  linearDamping.push_back(def.linearDamping);
+  angularDamping.push_back(def.angularDamping);
+  friction.push_back(def.friction);
+  restitution.push_back(def.restitution);
+  types.push_back(def.type);
+  bullets.push_back(def.bullet);
+  shapes.push_back(shape);
+  slotOf.push_back(index);
+  int32_t proxy =
+      tree.createProxy(bounds(shape, t).expanded(speculativeDistance), index);
+  proxies.push_back(proxy);
+  moveBuffer.push_back(proxy);
+  return BodyHandle{index, s.generation};
+}
+
+bool World::destroyBody(BodyHandle body) {
+  if (!valid(body)) return 1;
+  slot &s = slots[body.index];
+  int32_t proxy = proxies[s.dense];
+  tree.destroyProxy(proxy);
+  moveBuffer.erase(std::remove(moveBuffer.begin(), moveBuffer.end(), proxy),
+                   moveBuffer.end());
+  removeDense(s.dense);
+  // Contacts with the body are dropped by the next step's updatePairs().
+  s.live = false;
+  if (++s.generation == 0) s.generation = 1;
+  s.dense = freeSlot;
+  freeSlot = body.index;
+  return 0;
+}
+
+// Moves the last body into the gap.
+void World::removeDense(uint32_t index) {
+  uint32_t last = static_cast<uint32_t>(shapes.size() - 1);
+  auto fill = [index, last](auto &array) {
+    array[index] = array[last];
+    array.pop_back();
+  };
+  fill(positionX);
+  fill(positionY);
+  fill(angles);
+  fill(cosines);
+  fill(sines);
+  fill(velocityX);
+  fill(velocityY);
+  fill(angularVelocities);
+  fill(forceX);
+  fill(forceY);
+  fill(torques);
+  fill(accelerationX);
+  fill(accelerationY);
+  fill(inverseMass);
+  fill(inverseInertia);
+  fill(gravityScale);
+  fill(linearDamping);
+  fill(angularDamping);
+  fill(friction);
+  fill(restitution);
+  fill(types);
+  fill(bullets);
+  fill(shapes);
+  fill(proxies);
+  fill(slotOf);
+  if (index != last) slots[slotOf[index]].dense = index;
+}
+
+Vec2 World::position(BodyHandle body) const {
+  uint32_t i = slots[body.index].dense;
+  return {positionX[i], positionY[i]};
+}
+float World::angle(BodyHandle body) const {
+  return angles[slots[body.index].dense];
+}
+Transform World::transform(BodyHandle body) const {
+  uint32_t i = slots[body.index].dense;
+  return {{positionX[i], positionY[i]}, {cosines[i], sines[i]}};
+}
+Vec2 World::velocity(BodyHandle body) const {
+  uint32_t i = slots[body.index].dense;
+  return {velocityX[i], velocityY[i]};
+}
+float World::angularVelocity(BodyHandle body) const {
+  return angularVelocities[slots[body.index].dense];
+}
+void World::setVelocity(BodyHandle body, Vec2 velocity, float angular) {
+  uint32_t i = slots[body.index].dense;
+  if (types[i] == BODY_STATIC) return;
+  velocityX[i] = velocity.x;
+  velocityY[i] = velocity.y;
+  angularVelocities[i] = angular;
+}
+void World::applyForce(BodyHandle body, Vec2 force) {
+  uint32_t i = slots[body.index].dense;
+  forceX[i] += force.x;
+  forceY[i] += force.y;
+}
+void World::applyTorque(BodyHandle body, float torque) {
+  torques[slots[body.index].dense] += torque;
+}
+void World::applyImpulse(BodyHandle body, Vec2 impulse, Vec2 point) {
+  uint32_t i = slots[body.index].dense;
+  velocityX[i] += inverseMass[i] * impulse.x;
+  velocityY[i] += inverseMass[i] * impulse.y;
+  Vec2 r = point - Vec2{positionX[i], positionY[i]};
+  angularVelocities[i] += inverseInertia[i] * cross(r, impulse);
+}
+
+//--- Stepping
+
+void World::step(float dt, JobSystem *jobs) {
+  if (dt <= 0) return;
+  {
+    PROFILE_ZONE("Physics::broadphase");
+    updatePairs(jobs);
+  }
+  {
+    PROFILE_ZONE("Physics::narrowphase");
+    forRange(jobs, contacts.size(), contactGrain, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++) updateContact(contacts[i]);
+    });
+  }
+  {
+    PROFILE_ZONE("Physics::solve");
+    integrateVelocities(dt);
+    buildIslands();
+    constraints.resize(contacts.size());
+    forRange(jobs, islandCount(), 1, [&](size_t b, size_t e) {
+      for (size_t i = b; i < e; i++) solveIsland(islandOrder[i], dt);
+    });
+  }
+  bulletSweeps.clear();
+  for (size_t i = 0; i < shapes.size(); i++) {
+    if (!bullets[i] || types[i] != BODY_DYNAMIC) continue;
+    Vec2 start = {positionX[i], positionY[i]};
+    bulletSweeps.push_back(
+        {static_cast<uint32_t>(i), {start, start, angles[i], angles[i]}});
+  }
+  integratePositions(dt);
+  if (!bulletSweeps.empty()) {
+    PROFILE_ZONE("Physics::continuous");
+    sweepBullets(jobs);
+  }
+}
+
+uint64_t World::pairKey(uint32_t slotA, uint32_t slotB) {
+  if (slotA > slotB) std::swap(slotA, slotB);
+  return static_cast<uint64_t>(slotA) << 32 | slotB;
+}
+
+// Moves every non-static proxy to where its body is now, queueing those
+// that left their fat boxes to be checked for new pairs.
+void World::refitProxies() {
+  movingProxies.clear();
+  movingBoxes.clear();
+  for (size_t i = 0; i < shapes.size(); i++) {
+    if (types[i] == BODY_STATIC) continue;
+    Transform t = {{positionX[i], positionY[i]}, {cosines[i], sines[i]}};
+    movingProxies.push_back(proxies[i]);
+    movingBoxes.push_back(bounds(shapes[i], t).expanded(speculativeDistance));
+  }
+  size_t queued = moveBuffer.size();
+  moveBuffer.resize(queued + movingProxies.size());
+  size_t moved = tree.moveProxies(movingProxies.data(), movingBoxes.data(),
+                                  movingProxies.size(),
+                                  moveBuffer.data() + queued);
+  moveBuffer.resize(queued + moved);
+}
+
+// Refits the tree, drops contacts whose fat boxes have parted and adds
+// contacts for new overlaps. Only proxies that left their fat boxes (or
+// are new) can have new overlaps, so only they are queried.
+void World::updatePairs(JobSystem *jobs) {
+  refitProxies();
+
+  for (size_t i = 0; i < contacts.size();) {
+    contact &c = contacts[i];
+    if (valid(c.a) && valid(c.b) &&
+        overlaps(tree.fatBox(proxies[slots[c.a.index].dense]),
+                 tree.fatBox(proxies[slots[c.b.index].dense]))) {
+      i++;
+      continue;
+    }
+    contactIndex.erase(pairKey(c.a.index, c.b.index));
+    if (i + 1 < contacts.size()) {
+      c = contacts.back();
+      contactIndex[pairKey(c.a.index, c.b.index)] = static_cast<uint32_t>(i);
+    }
+    contacts.pop_back();
+  }
+
+  // Chunks fill their own lists, merged in order, so the contacts come out
+  // in the same order however the chunks were run.
+  pairBuffers.resize((moveBuffer.size() + pairGrain - 1) / pairGrain);
+  for (std::vector<uint64_t> &buffer : pairBuffers) buffer.clear();
+  forRange(jobs, moveBuffer.size(), pairGrain, [&](size_t b, size_t e) {
+    std::vector<uint64_t> &found = pairBuffers[b / pairGrain];
+    for (size_t i = b; i < e; i++) {
+      int32_t proxy = moveBuffer[i];
+      uint32_t slotA = tree.userData(proxy);
+      bool dynamicA = types[slots[slotA].dense] == BODY_DYNAMIC;
+      tree.query(tree.fatBox(proxy), [&](int32_t other) {
+        uint32_t slotB = tree.userData(other);
+        if (other != proxy &&
+            (dynamicA || types[slots[slotB].dense] == BODY_DYNAMIC))
+          found.push_back(pairKey(slotA, slotB));
+        return true;
+      });
+    }
+  });
+  for (const std::vector<uint64_t> &buffer : pairBuffers) {
+    for (uint64_t key : buffer) {
+      if (contactIndex.count(key)) continue;
+      addPair(static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key));
+    }
+  }
+  moveBuffer.clear();
+}
+
+void World::addPair(uint32_t slotA, uint32_t slotB) {
+  uint32_t a = slots[slotA].dense, b = slots[slotB].dense;
+  contact c = {};
+  c.a = BodyHandle{slotA, slots[slotA].generation};
+  c.b = BodyHandle{slotB, slots[slotB].generation};
+  c.friction = sqrtf(friction[a] * friction[b]);
+  c.restitution = std::max(restitution[a], restitution[b]);
+  contactIndex[pairKey(slotA, slotB)] = static_cast<uint32_t>(contacts.size());
+  contacts.push_back(c);
+}
+
+// A new point keeps the impulses of the old one made by the same features,
+// so the solver starts from last step's answer.
+void World::updateContact(contact &c) const {
+  uint32_t a = slots[c.a.index].dense, b = slots[c.b.index].dense;
+  Transform ta = {{positionX[a], positionY[a]}, {cosines[a], sines[a]}};
+  Transform tb = {{positionX[b], positionY[b]}, {cosines[b], sines[b]}};
+  Manifold m;
+  collide(shapes[a], ta, shapes[b], tb, speculativeDistance, &m);
+  contactPoint points[2];
+  for (int i = 0; i < m.pointCount; i++) {
+    points[i] = {m.points[i], 0, 0};
+    for (int j = 0; j < c.pointCount; j++) {
+      if (c.points[j].manifold.id != m.points[i].id) continue;
+      points[i].normalImpulse = c.points[j].normalImpulse;
+      points[i].tangentImpulse = c.points[j].tangentImpulse;
+    }
+  }
+  c.normal = m.normal;
+  c.pointCount = m.pointCount;
+  for (int i = 0; i < m.pointCount; i++) c.points[i] = points[i];
+}
+
+void World::integrateVelocities(float dt) {
+  size_t count = shapes.size();
+  for (size_t i = 0; i < count; i++) {
+    accelerationX[i] = forceX[i] * inverseMass[i] + gravity.x * gravityScale[i];
+    accelerationY[i] = forceY[i] * inverseMass[i] + gravity.y * gravityScale[i];
+  }
+  LinearMath::Batch::integrate(
+      Points2{velocityX.data(), velocityY.data()},
+      Points2{accelerationX.data(), accelerationY.data()}, dt, count);
+  for (size_t i = 0; i < count; i++) {
+    float linear = 1 / (1 + dt * linearDamping[i]);
+    velocityX[i] *= linear;
+    velocityY[i] *= linear;
+    angularVelocities[i] += dt * inverseInertia[i] * torques[i];
+    angularVelocities[i] *= 1 / (1 + dt * angularDamping[i]);
+  }
+  std::fill(forceX.begin(), forceX.end(), 0.0f);
+  std::fill(forceY.begin(), forceY.end(), 0.0f);
+  std::fill(torques.begin(), torques.end(), 0.0f);
+}
+
+void World::integratePositions(float dt) {
+  size_t count = shapes.size();
+  LinearMath::Batch::integrate(Points2{positionX.data(), positionY.data()},
+                               Points2{velocityX.data(), velocityY.data()},
+                               dt, count);
+  for (size_t i = 0; i < count; i++) angles[i] += dt * angularVelocities[i];
+  LinearMath::Batch::sinCos(angles.data(), sines.data(), cosines.data(),
+                            count);
+}
+
+// Moves each bullet back along its path to just short of the first body it
+// would have reached this step. It keeps its velocity; the contact made at
+// the start of the next step stops it there. The other bodies are taken
+// where they end the step, and as they can't move the bullets, bullets
+// run in parallel.
+//
+// A bullet already touching a body, say one knocked into a wall by
+// another, sweeps a small circle about its center against it instead, so
+// that it may slide along it or leave but its center can't pass through.
+// The circle has to reach the body itself rather than come within
+// linearSlop, or a bullet embedded that deep would not be swept at all;
+// if the circle already overlaps it, the bullet stays where it started.
+//
+// The tree still holds the boxes from before integratePositions(), so it
+// is refit first; otherwise a body that moved into a bullet's path could
+// be missed.
+void World::sweepBullets(JobSystem *jobs) {
+  refitProxies();
+  forRange(jobs, bulletSweeps.size(), bulletGrain, [&](size_t b, size_t e) {
+    for (size_t k = b; k < e; k++) {
+      uint32_t i = bulletSweeps[k].body;
+      Sweep &sweep = bulletSweeps[k].sweep;
+      sweep.end = {positionX[i], positionY[i]};
+      sweep.endAngle = angles[i];
+      Aabb path = merge(bounds(shapes[i], sweep.at(0)),
+                        bounds(shapes[i], sweep.at(1)));
+      Shape core = Shape::circle(coreFraction * innerRadius(shapes[i]));
+      float first = 1;
+      tree.query(path, [&](int32_t proxy) {
+        uint32_t other = slots[tree.userData(proxy)].dense;
+        if (other == i || bullets[other]) return true;
+        Vec2 p = {positionX[other], positionY[other]};
+        Sweep still = {p, p, angles[other], angles[other]};
+        float hit = timeOfImpact(shapes[i], sweep, shapes[other], still,
+                                 linearSlop);
+        if (hit == 0)
+          hit = timeOfImpact(core, sweep, shapes[other], still, 0);
+        first = std::min(first, hit);
+        return first > 0;
+      });
+      if (first >= 1) continue;
+      Transform t = sweep.at(first);
+      positionX[i] = t.position.x;
+      positionY[i] = t.position.y;
+      angles[i] += (sweep.startAngle - sweep.endAngle) * (1 - first);
+      cosines[i] = t.rotation.x;
+      sines[i] = t.rotation.y;
+    }
+  });
+}
+
+//--- Islands
+
+// Joins dynamic bodies that touch, then groups each touching contact under
+// its island's root. Static and kinematic bodies join nothing, since
+// the solver never changes them and islands can share them safely.
+void World::buildIslands() {
+  size_t count = shapes.size();
+  islandParent.resize(count);
+  for (size_t i = 0; i < count; i++)
+    islandParent[i] = static_cast<uint32_t>(i);
+  auto find = [this](uint32_t i) {
+    while (islandParent[i] != i)
+      i = islandParent[i] = islandParent[islandParent[i]];
+    return i;
+  };
+  for (const contact &c : contacts) {
+    if (!c.pointCount) continue;
+    uint32_t a = slots[c.a.index].dense, b = slots[c.b.index].dense;
+    if (types[a] != BODY_DYNAMIC || types[b] != BODY_DYNAMIC) continue;
+    uint32_t rootA = find(a), rootB = find(b);
+    if (rootA < rootB)
+      islandParent[rootB] = rootA;
+    else if (rootB < rootA)
+      islandParent[rootA] = rootB;
+  }
+
+  // Islands are numbered in the order their first contact appears, and
+  // their contacts placed by a counting sort.
+  islandOfRoot.assign(count, ~0u);
+  contactIsland.assign(contacts.size(), ~0u);
+  islandStart.assign(1, 0);
+  for (size_t i = 0; i < contacts.size(); i++) {
+    const contact &c = contacts[i];
+    if (!c.pointCount) continue;
+    uint32_t a = slots[c.a.index].dense, b = slots[c.b.index].dense;
+    uint32_t root = find(types[a] == BODY_DYNAMIC ? a : b);
+    if (islandOfRoot[root] == ~0u) {
+      islandOfRoot[root] = static_cast<uint32_t>(islandStart.size() - 1);
+      islandStart.push_back(0);
+    }
+    contactIsland[i] = islandOfRoot[root];
+    islandStart[contactIsland[i] + 1]++;
+  }
+  for (size_t i = 1; i < islandStart.size(); i++)
+    islandStart[i] += islandStart[i - 1];
+  islandContacts.resize(islandStart.back());
+  islandOrder.assign(islandStart.begin(), islandStart.end() - 1);
+  for (size_t i = 0; i < contacts.size(); i++) {
+    if (contactIsland[i] == ~0u) continue;
+    islandContacts[islandOrder[contactIsland[i]]++] = static_cast<uint32_t>(i);
+  }
+
+  // The biggest islands go first so a long one doesn't start last.
+  size_t islands = islandStart.size() - 1;
+  islandOrder.resize(islands);
+  for (size_t i = 0; i < islands; i++)
+    islandOrder[i] = static_cast<uint32_t>(i);
+  std::stable_sort(islandOrder.begin(), islandOrder.end(),
+                   [this](uint32_t x, uint32_t y) {
+                     return islandStart[x + 1] - islandStart[x] >
+                            islandStart[y + 1] - islandStart[y];
+                   });
+}
+
+//--- Solver
+
+// Sequential impulses: warm start from last step's impulses, then a number
+// of passes over the contacts, each making every point's relative velocity
+// what it should be given the others. Friction is solved before the normal
+// so that non-penetration wins. Bounces are applied last, where a point
+// pushed during the passes was approaching fast enough before them.
+void World::solveIsland(size_t island, float dt) {
+  const uint32_t *begin = islandContacts.data() + islandStart[island];
+  const uint32_t *end = islandContacts.data() + islandStart[island + 1];
+
+  struct state {
+    Vec2 v;
+    float w;
+  };
+  auto load = [this](uint32_t i) {
+    return state{{velocityX[i], velocityY[i]}, angularVelocities[i]};
+  };
+  // Only dynamic bodies are written; the others are shared with other
+  // islands.
+  auto store = [this](uint32_t i, const state &s) {
+    if (types[i] != BODY_DYNAMIC) return;
+    velocityX[i] = s.v.x;
+    velocityY[i] = s.v.y;
+    angularVelocities[i] = s.w;
+  };
+  auto apply = [this](uint32_t a, uint32_t b, state &sa, state &sb,
+                      const constraintPoint &p, Vec2 impulse) {
+    sa.v -= impulse * inverseMass[a];
+    sa.w -= inverseInertia[a] * cross(p.anchorA, impulse);
+    sb.v += impulse * inverseMass[b];
+    sb.w += inverseInertia[b] * cross(p.anchorB, impulse);
+  };
+  auto relative = [](const state &sa, const state &sb,
+                     const constraintPoint &p) {
+    return sb.v + crossScalar(sb.w, p.anchorB) - sa.v -
+           crossScalar(sa.w, p.anchorA);
+  };
+
+  for (const uint32_t *i = begin; i < end; i++) {
+    contact &c = contacts[*i];
+    constraint &k = constraints[*i];
+    k.a = slots[c.a.index].dense;
+    k.b = slots[c.b.index].dense;
+    uint32_t a = k.a, b = k.b;
+    Vec2 n = c.normal, t = {n.y, -n.x};
+    state sa = load(a), sb = load(b);
+    for (int j = 0; j < c.pointCount; j++) {
+      constraintPoint &p = k.points[j];
+      const contactPoint &cp = c.points[j];
+      p.anchorA = cp.manifold.point - Vec2{positionX[a], positionY[a]};
+      p.anchorB = cp.manifold.point - Vec2{positionX[b], positionY[b]};
+      float nA = cross(p.anchorA, n), nB = cross(p.anchorB, n);
+      float tA = cross(p.anchorA, t), tB = cross(p.anchorB, t);
+      float mass = inverseMass[a] + inverseMass[b];
+      float kNormal =
+          mass + inverseInertia[a] * nA * nA + inverseInertia[b] * nB * nB;
+      float kTangent =
+          mass + inverseInertia[a] * tA * tA + inverseInertia[b] * tB * tB;
+      p.normalMass = kNormal > 0 ? 1 / kNormal : 0;
+      p.tangentMass = kTangent > 0 ? 1 / kTangent : 0;
+      p.separation = cp.manifold.separation;
+      p.approach = dot(relative(sa, sb, p), n);
+      p.maxNormalImpulse = 0;
+      apply(a, b, sa, sb, p, n * cp.normalImpulse + t * cp.tangentImpulse);
+    }
+    store(a, sa);
+    store(b, sb);
+  }
+
+  float inverseDt = 1 / dt;
+  for (int iteration = 0; iteration < velocityIterations; iteration++) {
+    for (const uint32_t *i = begin; i < end; i++) {
+      contact &c = contacts[*i];
+      constraint &k = constraints[*i];
+      Vec2 n = c.normal, t = {n.y, -n.x};
+      state sa = load(k.a), sb = load(k.b);
+      for (int j = 0; j < c.pointCount; j++) {
+        constraintPoint &p = k.points[j];
+        contactPoint &cp = c.points[j];
+        float limit = c.friction * cp.normalImpulse;
+        float lambda = -p.tangentMass * dot(relative(sa, sb, p), t);
+        float total = std::min(std::max(cp.tangentImpulse + lambda, -limit),
+                               limit);
+        lambda = total - cp.tangentImpulse;
+        cp.tangentImpulse = total;
+        apply(k.a, k.b, sa, sb, p, t * lambda);
+      }
+      for (int j = 0; j < c.pointCount; j++) {
+        constraintPoint &p = k.points[j];
+        contactPoint &cp = c.points[j];
+        // A gap may close this step; overlap past the slop is pushed out.
+        float target = p.separation > 0
+                           ? -p.separation * inverseDt
+                           : std::min(baumgarte * inverseDt *
+                                          std::max(-p.separation - linearSlop,
+                                                   0.0f),
+                                      maxPushout);
+        float vn = dot(relative(sa, sb, p), n);
+        float lambda = p.normalMass * (target - vn);
+        float total = std::max(cp.normalImpulse + lambda, 0.0f);
+        lambda = total - cp.normalImpulse;
+        cp.normalImpulse = total;
+        p.maxNormalImpulse = std::max(p.maxNormalImpulse, lambda);
+        apply(k.a, k.b, sa, sb, p, n * lambda);
+      }
+      store(k.a, sa);
+      store(k.b, sb);
+    }
+  }
+
+  for (const uint32_t *i = begin; i < end; i++) {
+    contact &c = contacts[*i];
+    if (c.restitution == 0) continue;
+    constraint &k = constraints[*i];
+    state sa = load(k.a), sb = load(k.b);
+    for (int j = 0; j < c.pointCount; j++) {
+      constraintPoint &p = k.points[j];
+      contactPoint &cp = c.points[j];
+      if (p.approach > -restitutionThreshold || p.maxNormalImpulse <= 0)
+        continue;
+      float vn = dot(relative(sa, sb, p), c.normal);
+      float lambda = p.normalMass * (-c.restitution * p.approach - vn);
+      float total = std::max(cp.normalImpulse + lambda, 0.0f);
+      lambda = total - cp.normalImpulse;
+      cp.normalImpulse = total;
+      apply(k.a, k.b, sa, sb, p, c.normal * lambda);
+    }
+    store(k.a, sa);
+    store(k.b, sb);
+  }
+}
+
+}  // namespace Physics
@@ -0,0 +1,197 @@
+#ifndef PHYSICS_WORLD_H
+#define PHYSICS_WORLD_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+#include "collision.h"
+#include "memory/objectpool.h"
+#include "spatial/dynamictree.h"
+
+class JobSystem;
+
+namespace Physics {
+
+enum bodyType : unsigned char {
+  BODY_STATIC = 0,  // never moves
+  BODY_KINEMATIC,   // moves at its set velocity, pushed by nothing
+  BODY_DYNAMIC,
+};
+
+struct Body;  // only ever named through handles
+using BodyHandle = Handle<Body>;
+
+struct BodyDef {
+  bodyType type = BODY_DYNAMIC;
+  Shape shape;
+  // Where the shape's origin goes. Bodies are tracked by their center of
+  // mass, so position() differs from this for shapes off center.
+  LinearMath::Vec2 position;
+  float angle = 0;
+  LinearMath::Vec2 velocity;
+  float angularVelocity = 0;
+  float density = 1;
+  float friction = 0.6f;
+  float restitution = 0;
+  float linearDamping = 0;
+  float angularDamping = 0;
+  // Swept against the other bodies each step so that it can't pass through
+  // them, however fast it goes. For small fast bodies; it costs a few
+  // distance queries per body nearby. Only dynamic bodies are swept, and
+  // not against one another.
+  bool bullet = false;
+};
+
+// Rigid bodies with one shape each, stepped with a sequential impulse
+// solver. Body state lives in one array per component, so integration runs
+// through the Batch kernels; each step, bodies touching one another are
+// grouped into islands, which share no dynamic bodies and so are solved in
+// parallel on a JobSystem. The result doesn't depend on how many threads
+// there are.
+//
+// Lengths are in meters and times in seconds. Not thread safe.
+class World {
+ public:
+  explicit World(LinearMath::Vec2 gravity = {0, -10});
+  World(const World &) = delete;
+  World &operator=(const World &) = delete;
+
+  BodyHandle createBody(const BodyDef &def);
+  bool destroyBody(BodyHandle body);  /// Returns 1 if the handle is stale.
+  bool valid(BodyHandle body) const {
+    return body.index < slots.size() && slots[body.index].live &&
+           slots[body.index].generation == body.generation;
+  }
+
+  // Advances by dt, solving islands on `jobs` if given. Call it from a
+  // fixed-rate tick; the solver is tuned for steps near 1/60 s.
+  void step(float dt, JobSystem *jobs = nullptr);
+
+  // The handle must be valid for these.
+  LinearMath::Vec2 position(BodyHandle body) const;
+  float angle(BodyHandle body) const;
+  Transform transform(BodyHandle body) const;
+  LinearMath::Vec2 velocity(BodyHandle body) const;
+  float angularVelocity(BodyHandle body) const;
+  void setVelocity(BodyHandle body, LinearMath::Vec2 velocity,
+                   float angularVelocity);
+  // Forces act during the next step only.
+  void applyForce(BodyHandle body, LinearMath::Vec2 force);
+  void applyTorque(BodyHandle body, float torque);
+  void applyImpulse(BodyHandle body, LinearMath::Vec2 impulse,
+                    LinearMath::Vec2 point);
+
+  // f(BodyHandle, const Transform &) for every body, e.g. to draw them.
+  template <typename F>
+  void forEachBody(F &&f) const;
+
+  size_t bodyCount() const { return shapes.size(); }
+  size_t contactCount() const { return contacts.size(); }
+  size_t islandCount() const { return islandStart.size() - 1; }
+
+  LinearMath::Vec2 gravity;
+  int velocityIterations = 8;
+
+ private:
+  struct slot {
+    uint32_t dense;  // index into the body arrays, or the next free slot
+    uint32_t generation;
+    bool live;
+  };
+  struct contactPoint {
+    ManifoldPoint manifold;
+    float normalImpulse;
+    float tangentImpulse;
+  };
+  struct contact {
+    BodyHandle a;
+    BodyHandle b;
+    LinearMath::Vec2 normal;
+    contactPoint points[2];
+    int pointCount;
+    float friction;
+    float restitution;
+  };
+  // Solver state for one contact, rebuilt every step.
+  struct constraintPoint {
+    LinearMath::Vec2 anchorA;  // from each body's center
+    LinearMath::Vec2 anchorB;
+    float normalMass;
+    float tangentMass;
+    float separation;
+    float approach;  // normal speed before solving, for restitution
+    float maxNormalImpulse;
+  };
+  struct constraint {
+    uint32_t a;  // dense indices
+    uint32_t b;
+    constraintPoint points[2];
+  };
+  struct bulletSweep {
+    uint32_t body;  // dense index
+    Sweep sweep;
+  };
+
+  static uint64_t pairKey(uint32_t slotA, uint32_t slotB);
+  void removeDense(uint32_t index);
+  void refitProxies();
+  void updatePairs(JobSystem *jobs);
+  void addPair(uint32_t slotA, uint32_t slotB);
+  void updateContact(contact &c) const;
+  void integrateVelocities(float dt);
+  void buildIslands();
+  void solveIsland(size_t island, float dt);
+  void integratePositions(float dt);
+  void sweepBullets(JobSystem *jobs);
+
+  std::vector<slot> slots;
+  uint32_t freeSlot = ~0u;
+
+  // Body state, one entry per body in every array.
+  std::vector<float> positionX, positionY, angles, cosines, sines;
+  std::vector<float> velocityX, velocityY, angularVelocities;
+  std::vector<float> forceX, forceY, torques;
+  std::vector<float> accelerationX, accelerationY;  // scratch
+  std::vector<float> inverseMass, inverseInertia, gravityScale;
+  std::vector<float> linearDamping, angularDamping;
+  std::vector<float> friction, restitution;
+  std::vector<bodyType> types;
+  std::vector<bool> bullets;
+  std::vector<Shape> shapes;
+  std::vector<int32_t> proxies;
+  std::vector<uint32_t> slotOf;
+
+  DynamicTree tree;
+  std::vector<int32_t> moveBuffer;  // proxies to look for new pairs with
+  std::vector<int32_t> movingProxies;  // scratch for refitProxies()
+  std::vector<LinearMath::Aabb> movingBoxes;
+  std::vector<std::vector<uint64_t>> pairBuffers;
+  std::vector<contact> contacts;
+  std::unordered_map<uint64_t, uint32_t> contactIndex;
+
+  // Islands, rebuilt every step: touching contacts grouped by island.
+  std::vector<uint32_t> islandParent;  // union-find over bodies
+  std::vector<uint32_t> islandOfRoot;  // scratch for buildIslands()
+  std::vector<uint32_t> contactIsland;
+  std::vector<uint32_t> islandContacts;
+  std::vector<uint32_t> islandStart;  // one past the last is the end
+  std::vector<uint32_t> islandOrder;  // largest first
+  std::vector<constraint> constraints;  // by contact index
+  std::vector<bulletSweep> bulletSweeps;  // scratch for sweepBullets()
+};
+
+template <typename F>
+void World::forEachBody(F &&f) const {
+  for (size_t i = 0; i < shapes.size(); i++) {
+    uint32_t s = slotOf[i];
+    f(BodyHandle{s, slots[s].generation},
+      Transform{{positionX[i], positionY[i]}, {cosines[i], sines[i]}});
+  }
+}
+
+}  // namespace Physics
+
+#endif  // PHYSICS_WORLD_H
@@ -0,0 +1,157 @@
+#include "profiler.h"
+
+#include <algorithm>
+
+#include "memory/memorytracker.h"
+
+Profiler &Profiler::instance() {
+  static Profiler profiler;
+  return profiler;
+}
+
+Profiler::Profiler() : frameStart(now()) {}
+
+Profiler::~Profiler() {
+  endCapture();
+  // Thread buffers are shared with threads that may outlive main(); they are
+  // reclaimed with the process.
+}
+
+Profiler::threadBuffer *Profiler::localBuffer() {
+  struct owner {
+    threadBuffer *buffer = nullptr;
+    ~owner() {
+      if (buffer) buffer->inUse.store(false, std::memory_order_release);
+    }
+  };
+  thread_local owner local;
+  if (local.buffer) return local.buffer;
+
+  // Reuse the buffer of a thread that has exited before allocating.
+  for (threadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer;
+       buffer = buffer->next) {
+    bool free = false;
+    if (buffer->inUse.compare_exchange_strong(free, true,
+                                              std::memory_order_acquire))
+      return local.buffer = buffer;
+  }
+
+  MemoryScope scope(MEMTAG_PROFILER);
+  threadBuffer *buffer = new threadBuffer;
+  buffer->id = threadCount.fetch_add(1);
+  buffer->next = buffers.load(std::memory_order_relaxed);
+  while (!buffers.compare_exchange_weak(buffer->next, buffer,
+                                        std::memory_order_release))
+    ;
+  return local.buffer = buffer;
+}
+
+void Profiler::record(const char *name, unsigned long long start,
+                      unsigned long long end) {
+  threadBuffer *buffer = localBuffer();
+  size_t head = buffer->head.load(std::memory_order_relaxed);
+  if (head - buffer->tail.load(std::memory_order_acquire) ==
+      threadBuffer::capacity) {
+    buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  buffer->events[head & (threadBuffer::capacity - 1)] = event{name, start, end};
+  buffer->head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::endFrame() {
+  MemoryScope scope(MEMTAG_PROFILER);
+  unsigned long long end = now();
+  frame.frame++;
+  frame.ms = static_cast<double>(end - frameStart) / 1e6;
+  frame.droppedZones = 0;
+  frameStart = end;
+
+  frameZones.clear();
+  frameIndex.clear();
+  for (threadBuffer *buffer = buffers.load(std::memory_order_acquire); buffer;
+       buffer = buffer->next) {
+    size_t tail = buffer->tail.load(std::memory_order_relaxed);
+    size_t head = buffer->head.load(std::memory_order_acquire);
+    for (; tail != head; tail++) {
+      const event &e = buffer->events[tail & (threadBuffer::capacity - 1)];
+      double ms = static_cast<double>(e.end - e.start) / 1e6;
+
+      auto found = frameIndex.find(e.name);
+      if (found == frameIndex.end()) {
+        frameIndex.emplace(e.name, frameZones.size());
+        frameZones.push_back(ZoneStats{e.name, 1, ms, ms});
+      } else {
+        ZoneStats &z = frameZones[found->second];
+        z.calls++;
+        z.totalMs += ms;
+        z.maxMs = std::max(z.maxMs, ms);
+      }
+      if (capture) writeEvent(e, buffer->id);
+    }
+    buffer->tail.store(tail, std::memory_order_release);
+    frame.droppedZones += buffer->dropped.exchange(0);
+  }
+
+  for (const ZoneStats &z : frameZones) {
+    auto inserted = zones.emplace(z.name, z);
+    if (!inserted.second) {
+      ZoneStats &total = inserted.first->second;
+      total.calls += z.calls;
+      total.totalMs += z.totalMs;
+      total.maxMs = std::max(total.maxMs, z.maxMs);
+    }
+  }
+  std::sort(frameZones.begin(), frameZones.end(),
+            [](const ZoneStats &a, const ZoneStats &b) {
+              return a.totalMs > b.totalMs;
+            });
+}
+
+std::vector<Profiler::ZoneStats> Profiler::totals() const {
+  std::vector<ZoneStats> result;
+  result.reserve(zones.size());
+  for (const auto &zone : zones) result.push_back(zone.second);
+  std::sort(result.begin(), result.end(),
+            [](const ZoneStats &a, const ZoneStats &b) {
+              return a.totalMs > b.totalMs;
+            });
+  return result;
+}
+
+//--- Chrome trace capture
+
+bool Profiler::beginCapture(const char *path) {
+  endCapture();
+  capture = fopen(path, "w");
+  if (!capture) return 1;
+  captureEpoch = now();
+  firstEvent = true;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", capture);
+  return 0;
+}
+
+void Profiler::endCapture() {
+  if (!capture) return;
+  // Pick up whatever was recorded since the last frame.
+  endFrame();
+  fputs("\n]}\n", capture);
+  fclose(capture);
+  capture = nullptr;
+}
+
+void Profiler::writeEvent(const event &e, unsigned int thread) {
+  if (e.start < captureEpoch) return;
+  if (!firstEvent) fputs(",\n", capture);
+  firstEvent = false;
+
+  fputs("{\"name\":\"", capture);
+  for (const char *c = e.name; *c; c++) {
+    if (*c == '"' || *c == '\\') fputc('\\', capture);
+    fputc(*c, capture);
+  }
+  fprintf(capture,
+          "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+          thread, static_cast<double>(e.start - captureEpoch) / 1e3,
+          static_cast<double>(e.end - e.start) / 1e3);
+}
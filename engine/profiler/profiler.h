@@ -0,0 +1,134 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// Zones are compiled in unless building for release; define ENGINE_PROFILER
+// to 0 or 1 to override.
+#ifndef ENGINE_PROFILER
+#ifdef NDEBUG
+#define ENGINE_PROFILER 0
+#else
+#define ENGINE_PROFILER 1
+#endif
+#endif
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if ENGINE_PROFILER
+// Times the enclosing scope. `name` must be a string literal.
+#define PROFILE_ZONE(name) \
+  ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+// Closes the current frame; call once per tick from the main thread.
+#define PROFILE_FRAME() Profiler::instance().endFrame()
+#else
+#define PROFILE_ZONE(name) \
+  do {                     \
+  } while (0)
+#define PROFILE_FUNCTION() \
+  do {                     \
+  } while (0)
+#define PROFILE_FRAME() \
+  do {                  \
+  } while (0)
+#endif
+
+class Profiler {
+ public:
+  struct ZoneStats {
+    const char *name;
+    unsigned long long calls;
+    double totalMs;
+    double maxMs;
+  };
+  struct FrameStats {
+    unsigned long long frame = 0;
+    double ms = 0;
+    unsigned long long droppedZones = 0;
+  };
+
+  static Profiler &instance();
+
+  static unsigned long long now() {
+    return static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+  }
+  // Called by ProfileZone on the owning thread; never blocks.
+  void record(const char *name, unsigned long long start,
+              unsigned long long end);
+
+  // Drains every thread's zones, aggregates them and starts a new frame.
+  void endFrame();
+  const FrameStats &lastFrame() const { return frame; }
+  // Zones of the last frame, sorted by total time.
+  const std::vector<ZoneStats> &lastFrameZones() const { return frameZones; }
+  // Zones accumulated over every frame so far, sorted by total time.
+  std::vector<ZoneStats> totals() const;
+
+  // Streams every zone to a Chrome trace event file (chrome://tracing and
+  // ui.perfetto.dev both open it) until endCapture().
+  bool beginCapture(const char *path);  /// Returns 1 if it can't be opened.
+  void endCapture();
+
+ private:
+  Profiler();
+  ~Profiler();
+
+  struct event {
+    const char *name;
+    unsigned long long start;
+    unsigned long long end;
+  };
+  // Single producer (the owning thread), single consumer (endFrame()).
+  struct threadBuffer {
+    static constexpr size_t capacity = 16384;  // power of two
+    event events[capacity];
+    alignas(64) std::atomic<size_t> head{0};  // written by the owner
+    alignas(64) std::atomic<size_t> tail{0};  // written by the consumer
+    std::atomic<unsigned long long> dropped{0};
+    std::atomic<bool> inUse{true};  // released when the owning thread exits
+    unsigned int id = 0;
+    threadBuffer *next = nullptr;
+  };
+
+  threadBuffer *localBuffer();
+  void writeEvent(const event &e, unsigned int thread);
+
+  std::atomic<threadBuffer *> buffers{nullptr};
+  std::atomic<unsigned int> threadCount{0};
+
+  // Main thread only.
+  unsigned long long frameStart;
+  FrameStats frame;
+  std::vector<ZoneStats> frameZones;
+  std::unordered_map<const char *, ZoneStats> zones;
+  std::unordered_map<const char *, size_t> frameIndex;
+  FILE *capture = nullptr;
+  unsigned long long captureEpoch = 0;
+  bool firstEvent = true;
+};
+
+class ProfileZone {
+ public:
+  explicit ProfileZone(const char *name)
+      : name(name), start(Profiler::now()) {}
+  ~ProfileZone() { Profiler::instance().record(name, start, Profiler::now()); }
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+
+ private:
+  const char *name;
+  unsigned long long start;
+};
+
+#endif  // PROFILER_H
@@ -1,62 +1,246 @@
 #include "resource.h"
 
-#include <fstream>
-#include <iostream>
+#include <climits>
+
+#include "memory/memorytracker.h"
+#include "metrics/metrics.h"
+#include "profiler/profiler.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RESOURCE_HAVE_MMAP 1
+#endif
 
 #define INCBIN_PREFIX r_
 #include "lib/incbin/incbin.h"
 INCBIN(grc, "../data.grc");
 
+namespace {
+struct cacheMetrics {
+  Metrics::Counter &hits;
+  Metrics::Counter &misses;
+  Metrics::Gauge &bytes;
+};
+cacheMetrics &metrics() {
+  Metrics::Registry &registry = Metrics::Registry::instance();
+  static cacheMetrics m{
+      registry.counter("resource_cache_hits_total",
+                       "Resource::getFile calls served from cache"),
+      registry.counter("resource_cache_misses_total",
+                       "Resource::getFile calls read from a pack"),
+      registry.gauge("resource_cache_bytes",
+                     "Bytes of file contents held by Resource caches")};
+  return m;
+}
+
+//--- Tar parsing
+// Just enough of ustar to read what our pack tool and GNU/BSD tar write:
+// regular files, the ustar name prefix and GNU long names.
+
+const size_t blockSize = 512;
+
+size_t parseOctal(const char *field, size_t length) {
+  // GNU tar stores sizes of 8GB and up as big-endian binary instead.
+  if (static_cast<unsigned char>(field[0]) & 0x80) {
+    size_t value = static_cast<unsigned char>(field[0]) & 0x7f;
+    for (size_t i = 1; i < length; i++)
+      value = (value << 8) | static_cast<unsigned char>(field[i]);
+    return value;
+  }
+  size_t value = 0;
+  for (size_t i = 0; i < length && field[i] >= '0' && field[i] <= '7'; i++)
+    value = value * 8 + static_cast<size_t>(field[i] - '0');
+  return value;
+}
+
+bool checksumMatches(const char *header) {
+  unsigned int sum = 0;
+  for (size_t i = 0; i < blockSize; i++)
+    sum += i >= 148 && i < 156 ? ' ' : static_cast<unsigned char>(header[i]);
+  return sum == parseOctal(header + 148, 8);
+}
+
+std::string fieldString(const char *field, size_t length) {
+  return std::string(field, strnlen(field, length));
+}
+}  // namespace
+
 Resource::Resource() {
-  tarData = malloc(r_grcSize);
-  memcpy(tarData, r_grcData, r_grcSize);
+  PROFILE_FUNCTION();
+  // The embedded pack is read where it is linked rather than copied.
+  mountMemory(r_grcData, r_grcSize);
+}
 
-  //  std::ofstream fe("./FUCK");
+bool Resource::mountMemory(const void *data, size_t size) {
+  PROFILE_FUNCTION();
+  packs.push_back(pack{static_cast<const char *>(data), size, pack::EMBEDDED});
+  if (scan(static_cast<unsigned int>(packs.size() - 1))) {
+    packs.pop_back();
+    return 1;
+  }
+  return 0;
+}
 
-  mtar_mem_stream_t e;
-  mtar_init_mem_stream(&e, tarData, r_grcSize);
-  //  mtar_open_mem(&tarball, &e);
-  mtar_open(&tarball, "../data.grc", "r");
+bool Resource::mount(const std::string path) {
+  PROFILE_FUNCTION();
+  MemoryScope scope(MEMTAG_RESOURCE);
+  pack p = {nullptr, 0, pack::MAPPED};
+#ifdef RESOURCE_HAVE_MMAP
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return 1;
+  struct stat info;
+  if (fstat(fd, &info) || info.st_size <= 0) {
+    close(fd);
+    return 1;
+  }
+  p.size = static_cast<size_t>(info.st_size);
+  void *mapped = mmap(nullptr, p.size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) return 1;
+  p.data = static_cast<const char *>(mapped);
+#else
+  FILE *stream = fopen(path.c_str(), "rb");
+  if (!stream) return 1;
+  fseek(stream, 0, SEEK_END);
+  long length = ftell(stream);
+  fseek(stream, 0, SEEK_SET);
+  if (length <= 0) {
+    fclose(stream);
+    return 1;
+  }
+  p.size = static_cast<size_t>(length);
+  char *contents =
+      static_cast<char *>(Memory::allocate(p.size, MEMTAG_RESOURCE));
+  bool failed = fread(contents, 1, p.size, stream) != p.size;
+  fclose(stream);
+  p.data = contents;
+  p.storage = pack::ALLOCATED;
+  if (failed) {
+    release(p);
+    return 1;
+  }
+#endif
 
-  while ((mtar_read_header(&tarball, &header)) != MTAR_ENULLRECORD) {
-    fileList.push_back(Resource::file{header.name, header.size});
-    mtar_next(&tarball);
+  packs.push_back(p);
+  if (scan(static_cast<unsigned int>(packs.size() - 1))) {
+    release(packs.back());
+    packs.pop_back();
+    return 1;
   }
+  return 0;
+}
+
+bool Resource::scan(unsigned int packIndex) {
+  MemoryScope scope(MEMTAG_RESOURCE);
+  const pack &p = packs[packIndex];
+  size_t firstFile = fileList.size();
+  std::string longName;
+  size_t position = 0;
+  bool failed = false;
+
+  while (position + blockSize <= p.size) {
+    const char *header = p.data + position;
+    if (header[0] == '\0') break;  // end-of-archive marker
+    if (!checksumMatches(header)) {
+      failed = true;
+      break;
+    }
+
+    size_t size = parseOctal(header + 124, 12);
+    size_t offset = position + blockSize;
+    if (size > p.size - offset) {
+      failed = true;
+      break;
+    }
+    position = offset + (size + blockSize - 1) / blockSize * blockSize;
+
+    char type = header[156];
+    if (type == 'L') {  // GNU long name for the next entry
+      longName = fieldString(p.data + offset, size);
+      continue;
+    }
+    std::string name;
+    if (!longName.empty())
+      name = std::move(longName);
+    else {
+      name = fieldString(header, 100);
+      if (memcmp(header + 257, "ustar", 5) == 0 && header[345])
+        name = fieldString(header + 345, 155) + "/" + name;
+    }
+    longName.clear();
+    if ((type != '0' && type != '\0' && type != '7') || size > UINT_MAX)
+      continue;
+
+    index.emplace(name, fileList.size());
+    fileList.push_back(file{std::move(name), static_cast<unsigned int>(size),
+                            packIndex, offset});
+  }
+
+  if (failed) {
+    for (size_t i = firstFile; i < fileList.size(); i++) {
+      auto entry = index.find(fileList[i].name);
+      if (entry != index.end() && entry->second == i) index.erase(entry);
+    }
+    fileList.resize(firstFile);
+  }
+  return failed;
+}
+
+void Resource::release(pack &p) {
+#ifdef RESOURCE_HAVE_MMAP
+  if (p.storage == pack::MAPPED)
+    munmap(const_cast<char *>(p.data), p.size);
+#endif
+  if (p.storage == pack::ALLOCATED)
+    Memory::deallocate(const_cast<char *>(p.data));
 }
 
 unsigned long Resource::countFiles() { return fileList.size(); }
 
 Resource::~Resource() {
-  mtar_close(&tarball);
+  for (pack &p : packs)
+    release(p);
+  for (auto &cached : cache) {
+    metrics().bytes.add(-static_cast<double>(cached.second.size));
+    Memory::deallocate(cached.second.contents);
+  }
   fileList.clear();
 }
 
+std::string_view Resource::view(const std::string &name) const {
+  auto entry = index.find(name);
+  if (entry == index.end()) return {};
+  const file &f = fileList[entry->second];
+  return std::string_view(packs[f.pack].data + f.offset, f.size);
+}
+
 const char *Resource::getFile(const std::string name) {
-  unsigned long e = fileList.size() - 1;
-  for (unsigned long i = 0; i < e; i++) {
-    if (fileList.at(i).name == name) {
-      mtar_find(&tarball, name.c_str(), &header);
-      char *contents = static_cast<char *>(calloc(1, header.size));
-      contents[header.size + 1] = '\0';
-      mtar_read_data(&tarball, contents, header.size);
-      return contents;
-    }
+  PROFILE_FUNCTION();
+  MemoryScope scope(MEMTAG_RESOURCE);
+  auto cached = cache.find(name);
+  if (cached != cache.end()) {
+    metrics().hits.add();
+    return cached->second.contents;
   }
-  return nullptr;
+  if (!exists(name)) return nullptr;
+
+  // A copy, so that callers get a null-terminated string.
+  metrics().misses.add();
+  std::string_view contents = view(name);
+  char *copy = static_cast<char *>(
+      Memory::allocate(contents.size() + 1, MEMTAG_RESOURCE));
+  memcpy(copy, contents.data(), contents.size());
+  copy[contents.size()] = '\0';
+  unsigned int size = static_cast<unsigned int>(contents.size());
+  cache.emplace(name, cachedFile{copy, size});
+  metrics().bytes.add(size);
+  return copy;
 }
 
 unsigned int Resource::getSize(const std::string name) {
-  unsigned long e = fileList.size() - 1;
-  for (unsigned long i = 0; i < e; i++) {
-    if (fileList.at(i).name == name) {
-      return fileList.at(i).size;
-    }
-  }
-  return UINT_MAX;
+  auto entry = index.find(name);
+  return entry == index.end() ? UINT_MAX : fileList[entry->second].size;
 }
-
-// TODO: support multiple .grc files (like qrc)
-//  TODO: make it not load all of the tarball into memory
-//  TODO: make it actually work & ignore null terminating chars
-//  TODO: potentially implement custom tar parser by virtue of below
-//  https://techoverflow.net/2013/03/29/reading-tar-files-in-c/
@@ -5,33 +5,54 @@
 
 #include <cstring>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
-#include "lib/microtar/microtar.h"
-
 class Resource {
  public:
   Resource();
   ~Resource();
 
-  void *tarData;
+  // Contents stay cached, and owned by the Resource, until it is destroyed.
   const char *getFile(const std::string name);
+  // The file's bytes where they sit in the pack, without copying; valid until
+  // the Resource is destroyed. Not null-terminated. Empty if there is no such
+  // file.
+  std::string_view view(const std::string &name) const;
   unsigned int getSize(const std::string name);
   unsigned long countFiles();
+  bool exists(const std::string &name) const { return index.count(name); }
+  bool mount(const std::string path);  /// Returns 1 if the pack can't be read.
+  // Mounts a pack image that is already in memory and outlives the Resource.
+  bool mountMemory(const void *data, size_t size);  /// Returns 1 if malformed.
 
   // TODO: add public type wrapper method for getFileList()
-  // TODO: add lots more error checking
-  // TODO: add method to check file existence
 
  private:
   struct file {
     std::string name;
     unsigned int size;
+    unsigned int pack;
+    size_t offset;  // of the contents within the pack image
+  };
+  struct pack {
+    const char *data;
+    size_t size;
+    enum { EMBEDDED, MAPPED, ALLOCATED } storage;
   };
 
-  mtar_t tarball;
-  mtar_header_t header;
+  bool scan(unsigned int pack);  /// Returns 1 if the tar is malformed.
+  static void release(pack &p);
+
+  std::vector<pack> packs;
   std::vector<file> fileList;
+  std::unordered_map<std::string, size_t> index;  // name -> first in fileList
+  struct cachedFile {
+    char *contents;
+    unsigned int size;
+  };
+  std::unordered_map<std::string, cachedFile> cache;
 };
 
 #endif  // RESOURCE_H
@@ -0,0 +1,310 @@
+#include "dynamictree.h"
+
+#include <algorithm>
+
+using LinearMath::Aabb;
+using LinearMath::merge;
+
+namespace {
+// moveProxies checks the tree's cost once this fraction of the proxies have
+// been refit, and rebuilds once it exceeds this multiple of the cost after
+// the last build.
+constexpr size_t checkFraction = 4;
+constexpr float rebuildRatio = 1.5f;
+
+bool encloses(const Aabb &outer, const Aabb &inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+bool sameBox(const Aabb &a, const Aabb &b) {
+  return a.min.x == b.min.x && a.min.y == b.min.y && a.max.x == b.max.x &&
+         a.max.y == b.max.y;
+}
+}  // namespace
+
+DynamicTree::DynamicTree(float margin) : margin(margin) {}
+
+int32_t DynamicTree::createProxy(const Aabb &box, uint32_t userData) {
+  int32_t leaf = allocateNode();
+  node &n = nodes[leaf];
+  n.box = box.expanded(margin);
+  n.child1 = nullProxy;
+  n.child2 = static_cast<int32_t>(userData);
+  n.height = 0;
+  insertLeaf(leaf);
+  proxies++;
+  return leaf;
+}
+
+void DynamicTree::createProxies(const Aabb *boxes, const uint32_t *userData,
+                                size_t count, int32_t *created) {
+  bool build = count > proxies;
+  for (size_t i = 0; i < count; i++) {
+    int32_t leaf = allocateNode();
+    node &n = nodes[leaf];
+    n.box = boxes[i].expanded(margin);
+    n.parent = nullProxy;
+    n.child1 = nullProxy;
+    n.child2 = static_cast<int32_t>(userData[i]);
+    n.height = 0;
+    if (!build) insertLeaf(leaf);
+    created[i] = leaf;
+  }
+  proxies += count;
+  if (build) rebuild();
+}
+
+void DynamicTree::destroyProxy(int32_t proxy) {
+  removeLeaf(proxy);
+  freeNode(proxy);
+  proxies--;
+}
+
+bool DynamicTree::moveProxy(int32_t proxy, const Aabb &box) {
+  node &n = nodes[proxy];
+  if (encloses(n.box, box)) return 0;
+  n.box = box.expanded(margin);
+  refitAncestors(n.parent);
+  movedSinceCheck++;
+  return 1;
+}
+
+size_t DynamicTree::moveProxies(const int32_t *which, const Aabb *boxes,
+                                size_t count, int32_t *moved) {
+  size_t changed = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (!moveProxy(which[i], boxes[i])) continue;
+    if (moved) moved[changed] = which[i];
+    changed++;
+  }
+  if (movedSinceCheck * checkFraction >= proxies) {
+    movedSinceCheck = 0;
+    if (cost() > rebuildRatio * builtCost) rebuild();
+  }
+  return changed;
+}
+
+float DynamicTree::cost() const {
+  float total = 0;
+  for (const node &n : nodes)
+    if (n.height > 0) total += n.box.perimeter();
+  return total;
+}
+
+//--- Building
+
+// Splits the leaves at the median of their centers along the wider axis.
+// Each node is allocated before its children, and rebuild() leaves the free
+// list in ascending order, so the tree comes out depth first in memory.
+int32_t DynamicTree::build(int32_t *leaves, size_t count) {
+  if (count == 1) return leaves[0];
+  Aabb centers = {nodes[leaves[0]].box.center(), nodes[leaves[0]].box.center()};
+  for (size_t i = 1; i < count; i++) {
+    LinearMath::Vec2 c = nodes[leaves[i]].box.center();
+    centers = {min(centers.min, c), max(centers.max, c)};
+  }
+  LinearMath::Vec2 extent = centers.max - centers.min;
+  int axis = extent.y > extent.x;
+  size_t half = count / 2;
+  std::nth_element(leaves, leaves + half, leaves + count,
+                   [this, axis](int32_t a, int32_t b) {
+                     const Aabb &boxA = nodes[a].box, &boxB = nodes[b].box;
+                     return boxA.min[axis] + boxA.max[axis] <
+                            boxB.min[axis] + boxB.max[axis];
+                   });
+
+  int32_t index = allocateNode();
+  int32_t child1 = build(leaves, half);
+  int32_t child2 = build(leaves + half, count - half);
+  node &n = nodes[index];
+  n.child1 = child1;
+  n.child2 = child2;
+  n.box = merge(nodes[child1].box, nodes[child2].box);
+  n.height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+  nodes[child1].parent = index;
+  nodes[child2].parent = index;
+  return index;
+}
+
+void DynamicTree::rebuild() {
+  std::vector<int32_t> leaves;
+  leaves.reserve(proxies);
+  freeList = nullProxy;
+  for (size_t i = nodes.size(); i-- > 0;) {
+    node &n = nodes[i];
+    if (n.height == 0) {
+      leaves.push_back(static_cast<int32_t>(i));
+    } else {
+      n.height = -1;
+      n.parent = freeList;
+      freeList = static_cast<int32_t>(i);
+    }
+  }
+  root = nullProxy;
+  if (!leaves.empty()) {
+    root = build(leaves.data(), leaves.size());
+    nodes[root].parent = nullProxy;
+  }
+  builtCost = cost();
+  movedSinceCheck = 0;
+}
+
+//--- Nodes
+
+int32_t DynamicTree::allocateNode() {
+  if (freeList == nullProxy) {
+    size_t old = nodes.size();
+    nodes.resize(std::max<size_t>(16, old * 2));
+    for (size_t i = nodes.size(); i-- > old;) {
+      nodes[i].height = -1;
+      nodes[i].parent = freeList;
+      freeList = static_cast<int32_t>(i);
+    }
+  }
+  int32_t index = freeList;
+  freeList = nodes[index].parent;
+  nodes[index].parent = nullProxy;
+  nodes[index].height = 0;
+  return index;
+}
+
+void DynamicTree::freeNode(int32_t index) {
+  nodes[index].height = -1;
+  nodes[index].parent = freeList;
+  freeList = index;
+}
+
+// Descends towards the sibling that adds the least perimeter to the tree,
+// counting what the new parent adds to every ancestor, then rebalances on
+// the way back up.
+void DynamicTree::insertLeaf(int32_t leaf) {
+  if (root == nullProxy) {
+    root = leaf;
+    nodes[leaf].parent = nullProxy;
+    return;
+  }
+  Aabb box = nodes[leaf].box;
+  int32_t index = root;
+  while (!nodes[index].leaf()) {
+    const node &n = nodes[index];
+    float perimeter = n.box.perimeter();
+    float combined = merge(n.box, box).perimeter();
+    float cost = 2 * combined;
+    float inherited = 2 * (combined - perimeter);
+    auto descend = [&](int32_t child) {
+      const node &c = nodes[child];
+      float grown = merge(c.box, box).perimeter();
+      return inherited + (c.leaf() ? grown : grown - c.box.perimeter());
+    };
+    float cost1 = descend(n.child1);
+    float cost2 = descend(n.child2);
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? n.child1 : n.child2;
+  }
+
+  int32_t sibling = index;
+  int32_t oldParent = nodes[sibling].parent;
+  int32_t parent = allocateNode();
+  node &p = nodes[parent];
+  p.parent = oldParent;
+  p.box = merge(box, nodes[sibling].box);
+  p.height = nodes[sibling].height + 1;
+  p.child1 = sibling;
+  p.child2 = leaf;
+  nodes[sibling].parent = parent;
+  nodes[leaf].parent = parent;
+  if (oldParent == nullProxy) {
+    root = parent;
+  } else if (nodes[oldParent].child1 == sibling) {
+    nodes[oldParent].child1 = parent;
+  } else {
+    nodes[oldParent].child2 = parent;
+  }
+
+  for (index = oldParent; index != nullProxy; index = nodes[index].parent) {
+    index = balance(index);
+    node &n = nodes[index];
+    n.box = merge(nodes[n.child1].box, nodes[n.child2].box);
+    n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+  }
+}
+
+void DynamicTree::removeLeaf(int32_t leaf) {
+  if (leaf == root) {
+    root = nullProxy;
+    return;
+  }
+  int32_t parent = nodes[leaf].parent;
+  int32_t grandParent = nodes[parent].parent;
+  int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2
+                                                 : nodes[parent].child1;
+  freeNode(parent);
+  nodes[sibling].parent = grandParent;
+  if (grandParent == nullProxy) {
+    root = sibling;
+    return;
+  }
+  if (nodes[grandParent].child1 == parent) {
+    nodes[grandParent].child1 = sibling;
+  } else {
+    nodes[grandParent].child2 = sibling;
+  }
+  for (int32_t index = grandParent; index != nullProxy;
+       index = nodes[index].parent) {
+    index = balance(index);
+    node &n = nodes[index];
+    n.box = merge(nodes[n.child1].box, nodes[n.child2].box);
+    n.height = 1 + std::max(nodes[n.child1].height, nodes[n.child2].height);
+  }
+}
+
+// An AVL rotation: if one child of `index` is more than one level taller
+// than the other, the taller child takes its place. The taller child keeps
+// its own taller child and hands the other to `index`. Returns the node now
+// in `index`'s place.
+int32_t DynamicTree::balance(int32_t index) {
+  node &a = nodes[index];
+  if (a.leaf() || a.height < 2) return index;
+  int difference = nodes[a.child2].height - nodes[a.child1].height;
+  if (difference >= -1 && difference <= 1) return index;
+
+  bool rightHeavy = difference > 1;
+  int32_t up = rightHeavy ? a.child2 : a.child1;
+  int32_t stay = rightHeavy ? a.child1 : a.child2;
+  node &b = nodes[up];
+  int32_t keep = nodes[b.child1].height > nodes[b.child2].height ? b.child1
+                                                                 : b.child2;
+  int32_t move = keep == b.child1 ? b.child2 : b.child1;
+
+  b.child1 = index;
+  b.child2 = keep;
+  b.parent = a.parent;
+  a.parent = up;
+  if (b.parent == nullProxy) {
+    root = up;
+  } else if (nodes[b.parent].child1 == index) {
+    nodes[b.parent].child1 = up;
+  } else {
+    nodes[b.parent].child2 = up;
+  }
+
+  (rightHeavy ? a.child2 : a.child1) = move;
+  nodes[move].parent = index;
+  a.box = merge(nodes[stay].box, nodes[move].box);
+  a.height = 1 + std::max(nodes[stay].height, nodes[move].height);
+  b.box = merge(a.box, nodes[keep].box);
+  b.height = 1 + std::max(a.height, nodes[keep].height);
+  return up;
+}
+
+// Shrinks or grows each ancestor to fit its children, stopping at the
+// first that is already right.
+void DynamicTree::refitAncestors(int32_t index) {
+  while (index != nullProxy) {
+    node &n = nodes[index];
+    Aabb box = merge(nodes[n.child1].box, nodes[n.child2].box);
+    if (sameBox(box, n.box)) return;
+    n.box = box;
+    index = n.parent;
+  }
+}
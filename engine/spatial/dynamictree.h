@@ -0,0 +1,181 @@
+#ifndef DYNAMICTREE_H
+#define DYNAMICTREE_H
+
+#include <stdint.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "linearmath/geometry.h"
+
+// Bounding volume hierarchy over moving boxes, for broadphase collision and
+// for queries against many objects. Each proxy is stored with a fattened
+// box, so small movements need no work at all. A proxy that leaves its fat
+// box gets a new one and its ancestors are refit in place, without changing
+// the tree's shape. When refitting has made the tree noticeably worse than
+// when it was last built, it is rebuilt top-down in one pass.
+//
+// Nodes are 32 bytes, two to a cache line, and rebuilds lay the internal
+// nodes out depth first so that queries walk forward through memory.
+// Queries may run concurrently; changes may not.
+class DynamicTree {
+ public:
+  static constexpr int32_t nullProxy = -1;
+
+  // Boxes are fattened by `margin` on every side.
+  explicit DynamicTree(float margin = 0.1f);
+
+  int32_t createProxy(const LinearMath::Aabb &box, uint32_t userData);
+  // Many at once; on an empty tree this builds it top-down, which gives a
+  // better tree than inserting one at a time. `proxies` receives the ids.
+  void createProxies(const LinearMath::Aabb *boxes, const uint32_t *userData,
+                     size_t count, int32_t *proxies);
+  void destroyProxy(int32_t proxy);
+  /// Returns 1 if the box left the proxy's fat box, so the tree changed.
+  bool moveProxy(int32_t proxy, const LinearMath::Aabb &box);
+  // moveProxy for many proxies, then a rebuild if the tree has degraded.
+  // Writes the proxies that left their fat boxes to `moved`, if given, and
+  // returns how many there were.
+  size_t moveProxies(const int32_t *proxies, const LinearMath::Aabb *boxes,
+                     size_t count, int32_t *moved = nullptr);
+  void rebuild();
+
+  uint32_t userData(int32_t proxy) const {
+    return static_cast<uint32_t>(nodes[proxy].child2);
+  }
+  const LinearMath::Aabb &fatBox(int32_t proxy) const {
+    return nodes[proxy].box;
+  }
+  size_t proxyCount() const { return proxies; }
+  int height() const { return root == nullProxy ? 0 : nodes[root].height; }
+  // The summed perimeters of the internal nodes; what the insertion
+  // heuristic minimizes, and so a measure of the tree's quality.
+  float cost() const;
+
+  // callback(proxy) for every proxy whose fat box overlaps `box`; it
+  // returns false to stop the query.
+  template <typename F>
+  void query(const LinearMath::Aabb &box, F &&callback) const;
+  // callback(proxy, maxT) for every proxy whose fat box the ray meets
+  // before maxT, in no particular order. It returns the new maxT: the hit
+  // t to keep only closer proxies, maxT to carry on, or 0 to stop.
+  template <typename F>
+  void raycast(const LinearMath::Ray &ray, float maxT, F &&callback) const;
+  // The proxy for which distance(proxy) is smallest and below maxDistance,
+  // or nullProxy. distance() must be at least the distance from the point
+  // to the fat box, which prunes the search.
+  template <typename F>
+  int32_t nearest(LinearMath::Vec2 point, float maxDistance,
+                  F &&distance) const;
+
+ private:
+  // Leaves have child1 == nullProxy and keep the user data in child2. Free
+  // nodes have height -1 and link through parent.
+  struct node {
+    LinearMath::Aabb box;
+    int32_t parent;
+    int32_t child1;
+    int32_t child2;
+    int32_t height;
+
+    bool leaf() const { return child1 == nullProxy; }
+  };
+  // Deep enough for any tree built or balanced here, whose heights stay
+  // within about 1.44 log2 of the proxy count.
+  static constexpr int stackSize = 256;
+
+  int32_t allocateNode();
+  void freeNode(int32_t index);
+  void insertLeaf(int32_t leaf);
+  void removeLeaf(int32_t leaf);
+  int32_t balance(int32_t index);
+  void refitAncestors(int32_t index);
+  int32_t build(int32_t *leaves, size_t count);
+
+  std::vector<node> nodes;
+  int32_t root = nullProxy;
+  int32_t freeList = nullProxy;
+  size_t proxies = 0;
+  float margin;
+  float builtCost = 0;  // cost() after the last rebuild
+  size_t movedSinceCheck = 0;
+};
+
+//--- Queries
+
+template <typename F>
+void DynamicTree::query(const LinearMath::Aabb &box, F &&callback) const {
+  if (root == nullProxy) return;
+  int32_t stack[stackSize];
+  int top = 0;
+  stack[top++] = root;
+  while (top) {
+    const node &n = nodes[stack[--top]];
+    if (!LinearMath::overlaps(n.box, box)) continue;
+    if (n.leaf()) {
+      if (!callback(static_cast<int32_t>(&n - nodes.data()))) return;
+    } else {
+      stack[top++] = n.child1;
+      stack[top++] = n.child2;
+    }
+  }
+}
+
+template <typename F>
+void DynamicTree::raycast(const LinearMath::Ray &ray, float maxT,
+                          F &&callback) const {
+  if (root == nullProxy) return;
+  int32_t stack[stackSize];
+  int top = 0;
+  stack[top++] = root;
+  while (top) {
+    int32_t index = stack[--top];
+    const node &n = nodes[index];
+    LinearMath::RayHit hit;
+    if (!LinearMath::raycast(ray, n.box, maxT, &hit)) continue;
+    if (n.leaf()) {
+      maxT = callback(index, maxT);
+      if (maxT <= 0) return;
+    } else {
+      stack[top++] = n.child1;
+      stack[top++] = n.child2;
+    }
+  }
+}
+
+template <typename F>
+int32_t DynamicTree::nearest(LinearMath::Vec2 point, float maxDistance,
+                             F &&distance) const {
+  using LinearMath::closestPoint;
+  using LinearMath::lengthSquared;
+  int32_t best = nullProxy;
+  if (root == nullProxy) return best;
+  float bestSquared = maxDistance * maxDistance;
+  int32_t stack[stackSize];
+  int top = 0;
+  stack[top++] = root;
+  while (top) {
+    int32_t index = stack[--top];
+    const node &n = nodes[index];
+    if (lengthSquared(point - closestPoint(n.box, point)) >= bestSquared)
+      continue;
+    if (n.leaf()) {
+      float d = distance(index);
+      if (d * d < bestSquared) {
+        bestSquared = d * d;
+        best = index;
+      }
+      continue;
+    }
+    // The nearer child goes on top, so it is searched first and the
+    // farther one is more likely to be pruned.
+    const node &a = nodes[n.child1], &b = nodes[n.child2];
+    float da = lengthSquared(point - closestPoint(a.box, point));
+    float db = lengthSquared(point - closestPoint(b.box, point));
+    stack[top++] = da < db ? n.child2 : n.child1;
+    stack[top++] = da < db ? n.child1 : n.child2;
+  }
+  return best;
+}
+
+#endif  // DYNAMICTREE_H
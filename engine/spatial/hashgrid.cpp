@@ -0,0 +1,46 @@
+#include "hashgrid.h"
+
+using LinearMath::Aabb;
+
+HashGrid::HashGrid(float cellSize)
+    : size(cellSize), inverseSize(1 / cellSize) {}
+
+void HashGrid::build(const Aabb *source, size_t count) {
+  boxes.assign(source, source + count);
+  entries.clear();
+  if (!count) return;
+
+  // Counting sort: count each bucket's entries, turn the counts into where
+  // each bucket ends, then fill every bucket from its end backwards.
+  size_t total = 0;
+  extent = source[0];
+  for (const Aabb &b : boxes) {
+    extent = merge(extent, b);
+    total += static_cast<size_t>(cellOf(b.max.x) - cellOf(b.min.x) + 1) *
+             (cellOf(b.max.y) - cellOf(b.min.y) + 1);
+  }
+  size_t buckets = 16;
+  while (buckets < total) buckets *= 2;
+  bucketMask = static_cast<uint32_t>(buckets - 1);
+  bucketStart.assign(buckets + 1, 0);
+  entries.resize(total);
+
+  auto forCells = [this](const Aabb &b, auto &&f) {
+    int32_t x0 = cellOf(b.min.x), x1 = cellOf(b.max.x);
+    int32_t y0 = cellOf(b.min.y), y1 = cellOf(b.max.y);
+    for (int32_t y = y0; y <= y1; y++)
+      for (int32_t x = x0; x <= x1; x++) f(x, y);
+  };
+  for (const Aabb &b : boxes) {
+    forCells(b, [this](int32_t x, int32_t y) {
+      bucketStart[bucketOf(x, y)]++;
+    });
+  }
+  for (size_t i = 1; i <= buckets; i++) bucketStart[i] += bucketStart[i - 1];
+  for (size_t i = count; i-- > 0;) {
+    uint32_t item = static_cast<uint32_t>(i);
+    forCells(boxes[i], [this, item](int32_t x, int32_t y) {
+      entries[--bucketStart[bucketOf(x, y)]] = {x, y, item};
+    });
+  }
+}
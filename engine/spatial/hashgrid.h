@@ -0,0 +1,233 @@
+#ifndef HASHGRID_H
+#define HASHGRID_H
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "linearmath/geometry.h"
+
+// A uniform grid over the whole plane, for many similar-sized objects that
+// all move every step. Rather than being updated, it is rebuilt from every
+// box each step with a counting sort, which leaves each hash bucket's
+// entries side by side in one array. Each object is entered in every cell
+// its box touches, so the cell size should be about that of a typical
+// object; a few larger ones are fine.
+//
+// Queries may run concurrently; build() may not run alongside them.
+class HashGrid {
+ public:
+  static constexpr uint32_t npos = ~0u;
+
+  explicit HashGrid(float cellSize);
+
+  // Replaces the contents with items 0 to count - 1, boxes[i] for item i.
+  void build(const LinearMath::Aabb *boxes, size_t count);
+
+  size_t itemCount() const { return boxes.size(); }
+  const LinearMath::Aabb &box(uint32_t item) const { return boxes[item]; }
+  float cellSize() const { return size; }
+
+  // callback(item) once for every item whose box overlaps `box`; it
+  // returns false to stop the query.
+  template <typename F>
+  void query(const LinearMath::Aabb &box, F &&callback) const;
+  // callback(item, maxT) once for every item whose box the ray meets
+  // before maxT, roughly nearest first. It returns the new maxT: the hit t
+  // to keep only closer items, maxT to carry on, or 0 to stop.
+  template <typename F>
+  void raycast(const LinearMath::Ray &ray, float maxT, F &&callback) const;
+  // The item for which distance(item) is smallest and below maxDistance,
+  // or npos. distance() must be at least the distance from the point to
+  // the item's box, which prunes the search.
+  template <typename F>
+  uint32_t nearest(LinearMath::Vec2 point, float maxDistance,
+                   F &&distance) const;
+
+ private:
+  struct entry {
+    int32_t x;
+    int32_t y;
+    uint32_t item;
+  };
+  // Cells past this are clamped to it, so coordinates can't overflow.
+  static constexpr float cellLimit = 1 << 28;
+
+  int32_t cellOf(float coordinate) const {
+    float cell = floorf(coordinate * inverseSize);
+    return static_cast<int32_t>(
+        cell < -cellLimit ? -cellLimit : cell > cellLimit ? cellLimit : cell);
+  }
+  uint32_t bucketOf(int32_t x, int32_t y) const {
+    uint32_t h = static_cast<uint32_t>(x) * 0x9e3779b1u +
+                 static_cast<uint32_t>(y) * 0x85ebca77u;
+    return (h ^ (h >> 15)) & bucketMask;
+  }
+  // callback(item) for each entry in the cell; false from it stops early.
+  template <typename F>
+  bool forCell(int32_t x, int32_t y, F &&callback) const;
+
+  float size;
+  float inverseSize;
+  std::vector<LinearMath::Aabb> boxes;
+  LinearMath::Aabb extent = {};  // of every box
+  uint32_t bucketMask = 0;
+  std::vector<uint32_t> bucketStart;  // one past the end is the last entry
+  std::vector<entry> entries;         // grouped by bucket
+};
+
+//--- Queries
+
+template <typename F>
+bool HashGrid::forCell(int32_t x, int32_t y, F &&callback) const {
+  uint32_t bucket = bucketOf(x, y);
+  for (uint32_t i = bucketStart[bucket]; i < bucketStart[bucket + 1]; i++) {
+    const entry &e = entries[i];
+    if (e.x == x && e.y == y && !callback(e.item)) return 0;
+  }
+  return 1;
+}
+
+// An item in several of the cells is only taken in the first of them, the
+// one holding the lower corner of where it and the query box overlap.
+template <typename F>
+void HashGrid::query(const LinearMath::Aabb &box, F &&callback) const {
+  if (boxes.empty() || !LinearMath::overlaps(box, extent)) return;
+  int32_t x0 = cellOf(std::max(box.min.x, extent.min.x));
+  int32_t y0 = cellOf(std::max(box.min.y, extent.min.y));
+  int32_t x1 = cellOf(std::min(box.max.x, extent.max.x));
+  int32_t y1 = cellOf(std::min(box.max.y, extent.max.y));
+  // Past this many cells it is quicker to test every box.
+  int64_t cells = static_cast<int64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+  if (cells > static_cast<int64_t>(entries.size())) {
+    for (uint32_t i = 0; i < boxes.size(); i++)
+      if (LinearMath::overlaps(boxes[i], box) && !callback(i)) return;
+    return;
+  }
+  for (int32_t y = y0; y <= y1; y++) {
+    for (int32_t x = x0; x <= x1; x++) {
+      bool more = forCell(x, y, [&](uint32_t item) {
+        const LinearMath::Aabb &b = boxes[item];
+        if (!LinearMath::overlaps(b, box) ||
+            std::max(cellOf(b.min.x), x0) != x ||
+            std::max(cellOf(b.min.y), y0) != y)
+          return true;
+        return static_cast<bool>(callback(item));
+      });
+      if (!more) return;
+    }
+  }
+}
+
+// Walks the cells along the ray in order (Amanatides and Woo). The walk
+// only ever moves one way along each axis, so it passes through any box's
+// cells in one unbroken run, and each item is tested in the first cell of
+// its run.
+template <typename F>
+void HashGrid::raycast(const LinearMath::Ray &ray, float maxT,
+                       F &&callback) const {
+  LinearMath::RayHit hit;
+  if (boxes.empty() || !LinearMath::raycast(ray, extent, maxT, &hit)) return;
+  int32_t xMin = cellOf(extent.min.x), xMax = cellOf(extent.max.x);
+  int32_t yMin = cellOf(extent.min.y), yMax = cellOf(extent.max.y);
+  LinearMath::Vec2 start = ray.at(hit.t);
+  int32_t x = std::min(std::max(cellOf(start.x), xMin), xMax);
+  int32_t y = std::min(std::max(cellOf(start.y), yMin), yMax);
+  int32_t stepX = ray.direction.x > 0 ? 1 : ray.direction.x < 0 ? -1 : 0;
+  int32_t stepY = ray.direction.y > 0 ? 1 : ray.direction.y < 0 ? -1 : 0;
+  // Where the ray leaves the current cell along each axis.
+  auto exitX = [&] {
+    if (!stepX) return INFINITY;
+    return ((x + (stepX > 0)) * size - ray.origin.x) / ray.direction.x;
+  };
+  auto exitY = [&] {
+    if (!stepY) return INFINITY;
+    return ((y + (stepY > 0)) * size - ray.origin.y) / ray.direction.y;
+  };
+
+  int32_t lastX = x, lastY = y;
+  bool first = true;
+  float enter = hit.t;
+  while (enter <= maxT) {
+    bool more = forCell(x, y, [&](uint32_t item) {
+      const LinearMath::Aabb &b = boxes[item];
+      if (!first && lastX >= cellOf(b.min.x) && lastX <= cellOf(b.max.x) &&
+          lastY >= cellOf(b.min.y) && lastY <= cellOf(b.max.y))
+        return true;
+      LinearMath::RayHit itemHit;
+      if (!LinearMath::raycast(ray, b, maxT, &itemHit)) return true;
+      maxT = callback(item, maxT);
+      return maxT > 0;
+    });
+    if (!more) return;
+    first = false;
+    lastX = x;
+    lastY = y;
+    float nextX = exitX(), nextY = exitY();
+    if (nextX < nextY) {
+      x += stepX;
+      enter = nextX;
+    } else {
+      y += stepY;
+      enter = nextY;
+    }
+    if (x < xMin || x > xMax || y < yMin || y > yMax) return;
+  }
+}
+
+// Searches rings of cells outward from the point's cell until the next
+// ring is farther than the best found. An item is taken in whichever of
+// its cells is nearest the point's, which is in the first ring to reach it.
+template <typename F>
+uint32_t HashGrid::nearest(LinearMath::Vec2 point, float maxDistance,
+                           F &&distance) const {
+  using LinearMath::closestPoint;
+  using LinearMath::lengthSquared;
+  uint32_t best = npos;
+  if (boxes.empty()) return best;
+  float bestSquared = maxDistance * maxDistance;
+  int32_t xMin = cellOf(extent.min.x), xMax = cellOf(extent.max.x);
+  int32_t yMin = cellOf(extent.min.y), yMax = cellOf(extent.max.y);
+  int32_t cx = cellOf(point.x), cy = cellOf(point.y);
+  int32_t near = std::max({xMin - cx, cx - xMax, yMin - cy, cy - yMax, 0});
+  int32_t far = std::max({cx - xMin, xMax - cx, cy - yMin, yMax - cy});
+
+  auto visit = [&](int32_t x, int32_t y) {
+    forCell(x, y, [&](uint32_t item) {
+      const LinearMath::Aabb &b = boxes[item];
+      int32_t nearX = std::min(std::max(cx, cellOf(b.min.x)), cellOf(b.max.x));
+      int32_t nearY = std::min(std::max(cy, cellOf(b.min.y)), cellOf(b.max.y));
+      if (nearX != x || nearY != y ||
+          lengthSquared(point - closestPoint(b, point)) >= bestSquared)
+        return true;
+      float d = distance(item);
+      if (d * d < bestSquared) {
+        bestSquared = d * d;
+        best = item;
+      }
+      return true;
+    });
+  };
+  for (int32_t ring = near; ring <= far; ring++) {
+    // Every cell in the ring is at least this far from the point.
+    float gap = (ring - 1) * size;
+    if (gap > 0 && gap * gap >= bestSquared) break;
+    int32_t top = std::min(cy + ring, yMax);
+    for (int32_t y = std::max(cy - ring, yMin); y <= top; y++) {
+      if (y == cy - ring || y == cy + ring) {
+        int32_t right = std::min(cx + ring, xMax);
+        for (int32_t x = std::max(cx - ring, xMin); x <= right; x++)
+          visit(x, y);
+      } else {
+        if (cx - ring >= xMin) visit(cx - ring, y);
+        if (cx + ring <= xMax) visit(cx + ring, y);
+      }
+    }
+  }
+  return best;
+}
+
+#endif  // HASHGRID_H
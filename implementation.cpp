@@ -1,11 +1,46 @@
 #include "implementation.h"
 
+#include "argumentparser/argumentparser.h"
 #include "gui/gui.h"
 void GameApplication::exit() {
   SDL_free(window);
   SDL_free(renderer);
 }
 
+void GameApplication::registerArguments(ArgumentParser &parser) {
+  Application::registerArguments(parser);
+  parser.addOption("bodies", &pileBodies,
+                   "simulate a pile of this many bodies in tick()");
+}
+
+// Alternating boxes and circles dropped in a grid into a walled box.
+void GameApplication::buildPile() {
+  Physics::BodyDef ground;
+  ground.type = Physics::BODY_STATIC;
+  ground.shape = Physics::Shape::box(50, 1);
+  world.createBody(ground);
+  ground.shape = Physics::Shape::box(1, 100);
+  ground.position = {-51, 99};
+  world.createBody(ground);
+  ground.position = {51, 99};
+  world.createBody(ground);
+
+  Physics::BodyDef body;
+  for (unsigned int i = 0; i < pileBodies; i++) {
+    body.shape = i % 2 ? Physics::Shape::circle(0.4f)
+                       : Physics::Shape::box(0.4f, 0.4f);
+    body.position = {-45.0f + (i % 100) * 0.9f, 2.0f + (i / 100) * 0.9f};
+    world.createBody(body);
+  }
+}
+
+bool GameApplication::tick(double step) {
+  if (!pileBodies) return EXIT_SUCCESS;
+  if (!world.bodyCount()) buildPile();
+  world.step(static_cast<float>(step), &jobs);
+  return EXIT_SUCCESS;
+}
+
 void LOL() { printf("Fuck"); }
 bool GameApplication::mainLoop() {
   bool finishedNaturally = true;
@@ -23,18 +58,19 @@ bool GameApplication::mainLoop() {
   //  renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
 
   Resource rc;
-  int bmageSize = static_cast<int>(rc.getSize("bmage.png"));
-  const char *bmageData = rc.getFile("bmage.png");
-  SDL_RWops bmageFp(*SDL_RWFromConstMem(bmageData, bmageSize));
-  int imageSize = static_cast<int>(rc.getSize("image.png"));
-  const char *imageData = rc.getFile("image.png");
-  SDL_RWops imageFp(*SDL_RWFromConstMem(imageData, imageSize));
+  for (const char *pack : packs)
+    if (rc.mount(pack))
+      log(LOG_ERROR, std::string("Could not mount ") + pack + "\n");
+  std::string_view bmage = rc.view("bmage.png");
+  SDL_RWops bmageFp(*SDL_RWFromConstMem(bmage.data(), static_cast<int>(bmage.size())));
+  std::string_view image = rc.view("image.png");
+  SDL_RWops imageFp(*SDL_RWFromConstMem(image.data(), static_cast<int>(image.size())));
 
-  log(LOG_NONFATAL, rc.getFile("test/test.txt"));
+  log(LOG_NONFATAL, rc.view("test/test.txt"));
 
-  log(LOG_NONFATAL, std::to_string(rc.getSize("bmage.png")) + " bytes\n");
-  log(LOG_NONFATAL, std::to_string(rc.getSize("image.png")) + " bytes\n");
-  log(LOG_NONFATAL, std::to_string(rc.getSize("test/test.txt")) + " bytes\n");
+  logf(LOG_NONFATAL, "{} bytes", rc.getSize("bmage.png"));
+  logf(LOG_NONFATAL, "{} bytes", rc.getSize("image.png"));
+  logf(LOG_NONFATAL, "{} bytes", rc.getSize("test/test.txt"));
 
   gui gx(480, 240, 0, 0);
 
@@ -76,8 +112,12 @@ bool GameApplication::mainLoop() {
   //      }
   //    }
   //    SDL_UpdateWindowSurface(window);
+  //    configWatcher.update();
   //  }
   //  exit();
+  // Once per frame, like headlessLoop() does per tick: frees the snapshots
+  // that reloaded configs replaced.
+  configWatcher.update();
   if (finishedNaturally)
     return EXIT_SUCCESS;
   else
@@ -4,6 +4,7 @@
 #include "SDL2/SDL.h"
 #include "SDL2/SDL_image.h"
 #include <GameEngine>
+#include "physics/world.h"
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -14,8 +15,16 @@ class GameApplication : public Application {
   SDL_Renderer *renderer;
   SDL_Texture *texture;
 
+  // A pile of falling bodies stepped by tick(), to benchmark the physics
+  // headless; none unless --bodies is given.
+  unsigned int pileBodies = 0;
+  Physics::World world;
+  void buildPile();
+
   void exit() override;
 
+  void registerArguments(ArgumentParser &parser) override;
+  bool tick(double step) override;
   bool mainLoop() override;
 };
 
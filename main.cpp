@@ -7,7 +7,7 @@ int main(int argc, char *argv[]) {
   char **v = argv;
   app.argumentHandler(c, v);
   if (app.beginMainLoop()) {
-    app.log(1, "An error has occured.");
+    app.log(LOG_FATAL, "An error has occured.");
     return EXIT_FAILURE;
   }
   return EXIT_SUCCESS;
@@ -0,0 +1,167 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "check.h"
+#include "linearmath.h"
+#include "linearmath/batch.h"
+
+using namespace LinearMath;
+using namespace LinearMath::Batch;
+
+namespace {
+
+// Counts that leave every possible tail after the widest level's lanes.
+const size_t counts[] = {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 1037};
+
+struct arrays {
+  std::vector<std::vector<float>> data;
+
+  float *make(size_t count, std::mt19937 &random, float lo, float hi) {
+    std::uniform_real_distribution<float> values(lo, hi);
+    data.emplace_back(count);
+    for (float &value : data.back()) value = values(random);
+    return data.back().data();
+  }
+};
+
+template <typename T>
+void append(std::vector<uint32_t> &bits, const T *values, size_t count) {
+  static_assert(sizeof(T) == sizeof(uint32_t));
+  if (!count) return;
+  size_t start = bits.size();
+  bits.resize(start + count);
+  memcpy(bits.data() + start, values, count * sizeof(T));
+}
+
+// Every kernel at the current level on the same inputs, with the raw bits
+// of everything it wrote.
+std::vector<uint32_t> runAll() {
+  Mat4 m4 = Mat4::translation({1, 2, 3}) *
+            toMat4(normalize(Quat(0.3f, 0.2f, 0.1f, 1))) *
+            Mat4::scale({2, 3, 4});
+  Mat3 m3 = Mat3::translation({5, -1}) * Mat3::rotation(0.7f) *
+            Mat3::scale({2, -3});
+  std::vector<uint32_t> bits;
+
+  for (size_t n : counts) {
+    std::mt19937 random(static_cast<unsigned int>(n));
+    arrays a;
+    float *x = a.make(n, random, -10, 10), *y = a.make(n, random, -10, 10),
+          *z = a.make(n, random, -10, 10);
+    float *vx = a.make(n, random, -5, 5), *vy = a.make(n, random, -5, 5),
+          *vz = a.make(n, random, -5, 5);
+    if (n > 2) vx[2] = vy[2] = vz[2] = 0;  // normalize leaves these alone
+    float *ox = a.make(n, random, 0, 0), *oy = a.make(n, random, 0, 0),
+          *oz = a.make(n, random, 0, 0);
+
+    transformPoints(m3, {x, y}, {ox, oy}, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    transformPoints(m4, {x, y, z}, {ox, oy, oz}, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    append(bits, oz, n);
+    integrate(Points2{ox, oy}, Points2{vx, vy}, 0.25f, n);
+    integrate(Points3{x, y, z}, Points3{vx, vy, vz}, 1 / 60.0f, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    append(bits, x, n);
+    append(bits, y, n);
+    append(bits, z, n);
+    normalize(Points3{vx, vy, vz}, n);
+    normalize(Points2{ox, oy}, n);
+    append(bits, vx, n);
+    append(bits, vy, n);
+    append(bits, vz, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+
+    float *minX = a.make(n, random, -10, 0), *minY = a.make(n, random, -10, 0),
+          *minZ = a.make(n, random, -10, 0);
+    float *maxX = a.make(n, random, 0, 10), *maxY = a.make(n, random, 0, 10),
+          *maxZ = a.make(n, random, 0, 10);
+    float *bx = a.make(n, random, 0, 0), *by = a.make(n, random, 0, 0),
+          *bz = a.make(n, random, 0, 0), *cx = a.make(n, random, 0, 0),
+          *cy = a.make(n, random, 0, 0), *cz = a.make(n, random, 0, 0);
+    transformBounds(m3, {{minX, minY}, {maxX, maxY}}, {{bx, by}, {cx, cy}},
+                    n);
+    for (float *out : {bx, by, cx, cy}) append(bits, out, n);
+    transformBounds(m4, {{minX, minY, minZ}, {maxX, maxY, maxZ}},
+                    {{bx, by, bz}, {cx, cy, cz}}, n);
+    for (float *out : {bx, by, bz, cx, cy, cz}) append(bits, out, n);
+
+    float *angles = a.make(n, random, -100, 100);
+    sinCos(angles, ox, oy, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    LinearMath::Batch::atan2(y, x, ox, n);
+    append(bits, ox, n);
+    float *exponents = a.make(n, random, -80, 80);
+    LinearMath::Batch::exp(exponents, ox, n);
+    append(bits, ox, n);
+    float *positives = a.make(n, random, 1e-6f, 1e6f);
+    LinearMath::Batch::log(positives, ox, n);
+    append(bits, ox, n);
+    rotate(Points2{x, y}, angles, Points2{ox, oy}, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+
+    Ray ray = {{-12, -3}, {1, 0.2f}};
+    raycast(ray, 30, {{minX, minY}, {maxX, maxY}}, ox, n);
+    append(bits, ox, n);
+    std::vector<uint32_t> indices(n);
+    size_t found = overlapping(Aabb{{-1, -2}, {3, 1}},
+                               {{minX, minY}, {maxX, maxY}}, indices.data(),
+                               n);
+    bits.push_back(static_cast<uint32_t>(found));
+    append(bits, indices.data(), found);
+    float *radii = a.make(n, random, 0, 2);
+    found = overlapping(Circle{{2, 2}, 4}, Points2{x, y}, radii,
+                        indices.data(), n);
+    bits.push_back(static_cast<uint32_t>(found));
+    append(bits, indices.data(), found);
+
+    Random generator(n);
+    std::vector<uint32_t> raw(n);
+    generator.bits(raw.data(), n);
+    append(bits, raw.data(), n);
+    generator.uniform(ox, n, -3, 7);
+    append(bits, ox, n);
+    generator.normal(ox, n, 1, 2);
+    append(bits, ox, n);
+    generator.inCircle(Points2{ox, oy}, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    generator.onSphere(Points3{ox, oy, oz}, n);
+    append(bits, ox, n);
+    append(bits, oy, n);
+    append(bits, oz, n);
+  }
+  return bits;
+}
+
+}  // namespace
+
+int main() {
+  level supported = supportedLevel();
+  setLevel(LEVEL_SCALAR);
+  std::vector<uint32_t> scalar = runAll();
+  for (int l = LEVEL_SCALAR + 1; l <= supported; l++) {
+    CHECK(setLevel(static_cast<level>(l)) == l);
+    std::vector<uint32_t> bits = runAll();
+    CHECK(bits.size() == scalar.size());
+    size_t differing = 0;
+    for (size_t i = 0; i < bits.size() && i < scalar.size(); i++)
+      differing += bits[i] != scalar[i];
+    if (differing)
+      fprintf(stderr, "%s: %zu of %zu values differ from scalar\n",
+              levelName(static_cast<level>(l)), differing, scalar.size());
+    CHECK(!differing);
+  }
+  printf("compared %s and below against scalar\n", levelName(supported));
+  return checkResult();
+}
@@ -0,0 +1,27 @@
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal expectations for the test programs: a failed CHECK prints where
+// and carries on, and main() ends with `return checkResult();`.
+inline int &checkFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                          \
+  do {                                                            \
+    if (!(condition) && checkFailures()++ < 20)                   \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,      \
+              __LINE__, #condition);                              \
+  } while (0)
+
+inline int checkResult() {
+  if (!checkFailures()) return EXIT_SUCCESS;
+  fprintf(stderr, "%d checks failed\n", checkFailures());
+  return EXIT_FAILURE;
+}
+
+#endif  // TESTS_CHECK_H
@@ -0,0 +1,324 @@
+#include <stdio.h>
+
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "ecs/commandbuffer.h"
+#include "ecs/query.h"
+#include "ecs/registry.h"
+
+using namespace Ecs;
+
+namespace {
+
+struct Position {
+  float x, y;
+};
+struct Velocity {
+  float x, y;
+};
+struct Name {
+  std::string text;
+};
+struct alignas(64) Wide {
+  double values[20];
+};
+struct Tag {};
+
+// Counts live instances, to catch values the registry or a command buffer
+// forgets to destroy or destroys twice.
+std::atomic<int> liveCounted{0};
+struct Counted {
+  int value;
+  explicit Counted(int value) : value(value) { liveCounted++; }
+  Counted(Counted &&other) : value(other.value) { liveCounted++; }
+  ~Counted() { liveCounted--; }
+};
+
+// What each live entity should have, kept alongside the registry.
+struct expected {
+  Entity entity;
+  std::optional<Position> position;
+  std::optional<Velocity> velocity;
+  std::optional<std::string> name;
+  std::optional<double> wide;
+  std::optional<int> counted;
+  bool tag = false;
+};
+
+unsigned long long key(Entity entity) {
+  return static_cast<unsigned long long>(entity.index) << 32 |
+         entity.generation;
+}
+
+void compare(Registry &registry, const std::map<unsigned long long,
+                                                expected> &model) {
+  int counted = 0;
+  for (const auto &[k, e] : model) {
+    CHECK(registry.valid(e.entity));
+    Position *p = registry.get<Position>(e.entity);
+    CHECK(!p == !e.position);
+    if (p && e.position) CHECK(p->x == e.position->x && p->y == e.position->y);
+    Velocity *v = registry.get<Velocity>(e.entity);
+    CHECK(!v == !e.velocity);
+    if (v && e.velocity) CHECK(v->x == e.velocity->x && v->y == e.velocity->y);
+    Name *n = registry.get<Name>(e.entity);
+    CHECK(!n == !e.name);
+    if (n && e.name) CHECK(n->text == *e.name);
+    Wide *w = registry.get<Wide>(e.entity);
+    CHECK(!w == !e.wide);
+    if (w && e.wide) CHECK(w->values[3] == *e.wide);
+    if (w) CHECK(reinterpret_cast<size_t>(w) % alignof(Wide) == 0);
+    Counted *c = registry.get<Counted>(e.entity);
+    CHECK(!c == !e.counted);
+    if (c && e.counted) CHECK(c->value == *e.counted);
+    CHECK(registry.has<Tag>(e.entity) == e.tag);
+    counted += e.counted.has_value();
+  }
+  CHECK(registry.size() == model.size());
+  CHECK(liveCounted == counted);
+}
+
+// Random single changes to the registry, mirrored in the model, with the
+// two compared throughout; then queries and command buffers against the
+// same model.
+void randomOperations(JobSystem &jobs) {
+  Registry registry;
+  std::map<unsigned long long, expected> model;
+  std::vector<Entity> dead;
+  std::mt19937 random(7);
+  Query<Position, const Velocity> moving(registry);
+  Query<Name> untagged(registry, maskOf<Tag>());
+
+  auto pick = [&]() -> expected * {
+    if (model.empty()) return nullptr;
+    auto it = model.begin();
+    std::advance(it, random() % model.size());
+    return &it->second;
+  };
+
+  for (int step = 0; step < 20000; step++) {
+    unsigned int operation = random() % 12;
+    expected *e = operation >= 2 && operation < 10 ? pick() : nullptr;
+    if (operation >= 2 && operation < 10 && !e) continue;
+    float value = static_cast<float>(random() % 100);
+    switch (operation) {
+      case 0: {
+        expected created;
+        created.entity = registry.create();
+        model[key(created.entity)] = created;
+        break;
+      }
+      case 1: {
+        expected created;
+        created.position = Position{value, 1};
+        created.name = std::string(step % 50, 'a' + step % 26);
+        created.entity =
+            registry.create(*created.position, Name{*created.name});
+        model[key(created.entity)] = created;
+        break;
+      }
+      case 2:
+        CHECK(!registry.destroy(e->entity));
+        dead.push_back(e->entity);
+        model.erase(key(e->entity));
+        break;
+      case 3:
+        e->position = Position{value, 2};
+        CHECK(!registry.add(e->entity, *e->position));
+        break;
+      case 4:
+        e->velocity = Velocity{1, value};
+        CHECK(!registry.add(e->entity, *e->velocity));
+        break;
+      case 5:
+        e->name = std::string(random() % 50, 'z');
+        CHECK(!registry.add(e->entity, Name{*e->name}));
+        break;
+      case 6: {
+        Wide w = {};
+        w.values[3] = step;
+        e->wide = step;
+        CHECK(!registry.add(e->entity, w));
+        break;
+      }
+      case 7:
+        e->counted = step;
+        CHECK(!registry.add(e->entity, Counted(step)));
+        break;
+      case 8:
+        switch (random() % 5) {
+          case 0:
+            registry.remove<Position>(e->entity);
+            e->position.reset();
+            break;
+          case 1:
+            registry.remove<Velocity>(e->entity);
+            e->velocity.reset();
+            break;
+          case 2:
+            registry.remove<Name>(e->entity);
+            e->name.reset();
+            break;
+          case 3:
+            registry.remove<Wide>(e->entity);
+            e->wide.reset();
+            break;
+          case 4:
+            registry.remove<Counted>(e->entity);
+            e->counted.reset();
+            break;
+        }
+        break;
+      case 9:
+        if (e->tag)
+          registry.remove<Tag>(e->entity);
+        else
+          registry.add(e->entity, Tag{});
+        e->tag = !e->tag;
+        break;
+      case 10: {
+        // Stale handles change nothing.
+        if (dead.empty()) break;
+        Entity stale = dead[random() % dead.size()];
+        CHECK(registry.destroy(stale));
+        CHECK(registry.add(stale, Position{0, 0}));
+        CHECK(registry.remove<Position>(stale));
+        CHECK(!registry.get<Position>(stale));
+        CHECK(!registry.valid(stale));
+        break;
+      }
+      case 11: {
+        size_t visited = 0;
+        moving.each([&](Entity entity, Position &p, const Velocity &v) {
+          visited++;
+          auto found = model.find(key(entity));
+          CHECK(found != model.end());
+          if (found == model.end()) return;
+          CHECK(found->second.position && found->second.velocity);
+          p.x += v.x;
+          if (found->second.position) found->second.position->x += v.x;
+        });
+        size_t expectedCount = 0;
+        for (const auto &[k, x] : model)
+          expectedCount += x.position && x.velocity;
+        CHECK(visited == expectedCount);
+        CHECK(moving.count() == expectedCount);
+
+        std::atomic<size_t> names{0};
+        untagged.each([&](Name &) { names++; }, &jobs);
+        size_t expectedNames = 0;
+        for (const auto &[k, x] : model) expectedNames += x.name && !x.tag;
+        CHECK(names == expectedNames);
+        break;
+      }
+    }
+    if (step % 500 == 0) compare(registry, model);
+  }
+  compare(registry, model);
+
+  // Deferred changes made while iterating: a third of the untagged
+  // entities spawn a child, and about a tenth are destroyed.
+  CommandBuffer buffer;
+  std::vector<Entity> destroyed;
+  size_t children = 0;
+  untagged.each([&](Entity entity, Name &name) {
+    if (name.text.size() % 3 == 0) {
+      Entity child = buffer.create();
+      buffer.add(child, Name{"child of " + name.text});
+      buffer.add(child, Position{1, 2});
+      buffer.remove<Position>(child);
+      buffer.add(child, Velocity{3, 4});
+      buffer.add(child, Counted(-1));
+      children++;
+    }
+    if (entity.index % 10 == 0) {
+      buffer.destroy(entity);
+      buffer.add(entity, Counted(-2));  // skipped, since it's gone
+      destroyed.push_back(entity);
+    }
+  });
+  size_t before = registry.size();
+  buffer.apply(registry);
+  CHECK(buffer.empty());
+  for (Entity entity : destroyed) {
+    CHECK(!registry.valid(entity));
+    model.erase(key(entity));
+  }
+  Query<Name, Velocity, Counted> spawned(registry);
+  size_t found = 0;
+  spawned.each([&](Entity entity, Name &name, Velocity &v, Counted &c) {
+    if (c.value != -1) return;
+    found++;
+    CHECK(name.text.compare(0, 9, "child of ") == 0);
+    CHECK(v.x == 3 && v.y == 4);
+    CHECK(!registry.has<Position>(entity));
+    expected child;
+    child.entity = entity;
+    child.name = name.text;
+    child.velocity = v;
+    child.counted = -1;
+    model[key(entity)] = child;
+  });
+  CHECK(found == children);
+  CHECK(registry.size() == before + children - destroyed.size());
+  compare(registry, model);
+
+  registry.clear();
+  CHECK(registry.size() == 0);
+  CHECK(liveCounted == 0);
+}
+
+// Placeholders only mean something to the buffer that made them, and only
+// until it is next applied or cleared.
+void placeholders() {
+  Registry registry;
+  CommandBuffer first, second;
+  Entity mine = first.create();
+  Entity foreign = second.create();
+  first.add(mine, Counted(1));
+  first.add(foreign, Counted(2));
+  first.add(Entity{mine.index + 1, mine.generation}, Counted(3));
+  first.apply(registry);
+  CHECK(registry.size() == 1);
+  CHECK(liveCounted == 1);
+
+  // The same placeholder after the buffer was applied.
+  first.add(mine, Counted(4));
+  first.destroy(mine);
+  first.apply(registry);
+  CHECK(registry.size() == 1);
+  CHECK(liveCounted == 1);
+
+  second.clear();
+  second.add(foreign, Counted(5));
+  second.apply(registry);
+  CHECK(registry.size() == 1);
+  CHECK(liveCounted == 1);
+
+  // Values recorded but never applied are destroyed with the buffer.
+  {
+    CommandBuffer unapplied;
+    for (int i = 0; i < 100; i++) unapplied.add(unapplied.create(), Counted(i));
+  }
+  CHECK(liveCounted == 1);
+  registry.clear();
+  CHECK(liveCounted == 0);
+}
+
+}  // namespace
+
+int main() {
+  JobSystem jobs;
+  jobs.start(3);
+  randomOperations(jobs);
+  placeholders();
+  jobs.stop();
+  return checkResult();
+}
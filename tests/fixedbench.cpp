@@ -0,0 +1,99 @@
+// Times the operations Real code leans on, as float and as Fixed, and a
+// steering update written against both. Prints nanoseconds per operation;
+// build with optimizations for numbers worth comparing.
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <vector>
+
+#include "linearmath/real.h"
+
+using namespace LinearMath;
+
+namespace {
+
+constexpr int count = 1 << 20;
+
+template <typename F>
+double nanoseconds(int operations, F &&f) {
+  double best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    if (elapsed.count() < best) best = elapsed.count();
+  }
+  return best / operations;
+}
+
+template <typename Number, typename Vector>
+struct unit {
+  Vector position, velocity;
+};
+
+template <typename Number, typename Vector>
+void steer(std::vector<unit<Number, Vector>> &units, Vector target,
+           Number dt) {
+  for (unit<Number, Vector> &u : units) {
+    Vector to = target - u.position;
+    Number distance = length(to);
+    Vector desired = normalize(to) * Number(4.0f);
+    if (distance < Number(1.0f)) desired = desired * distance;
+    u.velocity = lerp(u.velocity, desired, Number(0.1f));
+    Number angle = angleOf(u.velocity);
+    u.velocity = u.velocity + direction(angle + Number(0.5f)) * Number(0.01f);
+    u.position = u.position + u.velocity * dt;
+  }
+}
+
+template <typename Number, typename Vector>
+void run(const char *name) {
+  std::vector<Number> x(count), y(count);
+  for (int i = 0; i < count; i++) {
+    x[i] = Number((i % 1000) * 0.37f + 0.01f);
+    y[i] = Number((i % 777) * 0.5f - 100);
+  }
+  // Folding every result into a sum that is printed keeps the loops alive.
+  Number sum = Number(0.0f);
+  auto each = [&](auto op) {
+    return nanoseconds(count, [&] {
+      Number s = Number(0.0f);
+      for (int i = 0; i < count; i++) s = s + op(x[i], y[i]);
+      sum = sum + s;
+    });
+  };
+
+  printf("%-6s", name);
+  printf(" %7.2f", each([](Number a, Number b) { return a * b; }));
+  printf(" %7.2f", each([](Number a, Number b) { return b / a; }));
+  printf(" %7.2f", each([](Number a, Number) { return sqrt(a); }));
+  printf(" %7.2f", each([](Number, Number b) { return sin(b); }));
+  printf(" %7.2f", each([](Number a, Number b) { return atan2(b, a); }));
+  printf(" %7.2f", each([](Number a, Number b) {
+           return length(Vector(a, b));
+         }));
+
+  constexpr int units = 10000, steps = 20;
+  std::vector<unit<Number, Vector>> swarm(units);
+  for (int i = 0; i < units; i++)
+    swarm[i].position = Vector(Number(float(i % 100)), Number(float(i / 100)));
+  printf(" %8.1f", nanoseconds(units * steps, [&] {
+           for (int step = 0; step < steps; step++)
+             steer(swarm, Vector(Number(50.0f), Number(50.0f)),
+                   Number(1 / 60.0f));
+         }));
+  printf("   (%g)\n", static_cast<float>(sum + swarm[0].position.x));
+}
+
+}  // namespace
+
+int main() {
+  printf("ns per   %7s %7s %7s %7s %7s %7s %8s\n", "mul", "div", "sqrt", "sin",
+         "atan2", "length", "steer");
+  run<float, Vec2>("float");
+  run<Fixed, FixedVec2>("fixed");
+  return 0;
+}
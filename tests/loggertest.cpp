@@ -0,0 +1,131 @@
+#include <stdio.h>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include "check.h"
+#include "logger/logger.h"
+
+namespace {
+
+std::string decoded(const std::string &path, bool *failed) {
+  FILE *out = tmpfile();
+  *failed = Logger::decode(path.c_str(), out);
+  std::string text(static_cast<size_t>(ftell(out)), '\0');
+  rewind(out);
+  text.resize(fread(text.data(), 1, text.size(), out));
+  fclose(out);
+  return text;
+}
+
+bool contains(const std::string &text, const char *part) {
+  return text.find(part) != std::string::npos;
+}
+
+void writeFile(const std::string &path, const std::string &bytes) {
+  FILE *file = fopen(path.c_str(), "wb");
+  fwrite(bytes.data(), 1, bytes.size(), file);
+  fclose(file);
+}
+
+template <typename T>
+void append(std::string &bytes, T value) {
+  bytes.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+// A formatted 'M' record with the given argument bytes, preceded by an 'F'
+// record for its format string.
+std::string formattedRecord(const char *format, const std::string &args) {
+  std::string bytes("GELOGv1\n", 8);
+  bytes += 'F';
+  append<unsigned long long>(bytes, 1);
+  append<unsigned short>(bytes, strlen(format));
+  bytes += format;
+  bytes += 'M';
+  append<unsigned long long>(bytes, 0);
+  bytes += static_cast<char>(LOG_INFO);
+  append<unsigned short>(bytes, 0);
+  bytes += '\1';
+  append<unsigned short>(bytes, 8 + args.size());
+  append<unsigned long long>(bytes, 1);
+  return bytes + args;
+}
+
+}  // namespace
+
+int main() {
+  std::filesystem::path dir = std::filesystem::temp_directory_path();
+  std::string path = (dir / "loggertest.bin").string();
+  std::string scratch = (dir / "loggertest.tmp").string();
+  std::string sink = (dir / "loggertest.sink").string();
+  Logger &logger = Logger::instance();
+  logger.setLevel(LOG_TRACE);
+
+  // Round trip: every argument type through the file and back.
+  CHECK(!logger.openBinary(path.c_str()));
+  std::string owned = "owned";
+  int value = 0;
+  logger.write(LOG_INFO, "plain message");
+  logger.writeFormat(LOG_WARNING, "int {} uint {} double {}", -42, 7u, 0.5);
+  logger.writeFormat(LOG_DEBUG, "bool {} char {} {{braces}}", true, 'x');
+  logger.writeFormat(LOG_INFO, "strings {} {} {}", "literal", owned,
+                     std::string_view("view"));
+  logger.writeFormat(LOG_INFO, "pointer {}", static_cast<void *>(&value));
+  logger.writeFormat(LOG_INFO, "missing {} {}", 1);
+  // Switching files flushes and closes this one.
+  CHECK(!logger.openBinary(sink.c_str()));
+
+  bool failed;
+  std::string text = decoded(path, &failed);
+  char pointer[32];
+  snprintf(pointer, sizeof(pointer), "pointer 0x%llx",
+           reinterpret_cast<unsigned long long>(&value));
+  CHECK(!failed);
+  CHECK(contains(text, "INFO  plain message\n"));
+  CHECK(contains(text, "WARN  int -42 uint 7 double 0.5\n"));
+  CHECK(contains(text, "DEBUG bool true char x {braces}\n"));
+  CHECK(contains(text, "strings literal owned view\n"));
+  CHECK(contains(text, pointer));
+  CHECK(contains(text, "missing 1 {}\n"));
+
+  // A file cut off anywhere decodes to the records before the cut.
+  std::string whole;
+  FILE *file = fopen(path.c_str(), "rb");
+  char buffer[4096];
+  for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file));)
+    whole.append(buffer, n);
+  fclose(file);
+  for (size_t size = 0; size < whole.size(); size++) {
+    writeFile(scratch, whole.substr(0, size));
+    std::string partial = decoded(scratch, &failed);
+    CHECK(text.compare(0, partial.size(), partial) == 0);
+  }
+
+  // Argument bytes that claim more than the record holds.
+  std::string args;
+  args += '\6';  // string
+  append<unsigned short>(args, 0xffff);
+  args += "abc";
+  writeFile(scratch, formattedRecord("string {} end", args));
+  text = decoded(scratch, &failed);
+  CHECK(!failed);
+  CHECK(contains(text, "string <truncated>\n"));
+  CHECK(!contains(text, "end"));
+
+  // Each argument type with its tag but not its value.
+  for (char type = 0; type < 7; type++) {
+    writeFile(scratch, formattedRecord("{} end", std::string(1, type)));
+    CHECK(contains(decoded(scratch, &failed), "INFO  <truncated>\n"));
+  }
+
+  args.assign(1, '\0');  // int, one byte short
+  args.append(7, '\0');
+  writeFile(scratch, formattedRecord("short {}", args));
+  CHECK(contains(decoded(scratch, &failed), "short <truncated>\n"));
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(scratch);
+  std::filesystem::remove(sink);
+  return checkResult();
+}
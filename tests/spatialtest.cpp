@@ -0,0 +1,174 @@
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "check.h"
+#include "linearmath/random.h"
+#include "spatial/dynamictree.h"
+#include "spatial/hashgrid.h"
+
+using namespace LinearMath;
+
+namespace {
+
+constexpr int count = 2000;
+constexpr float world = 400;
+
+struct scene {
+  std::vector<Aabb> boxes;
+  std::vector<Vec2> velocities;
+
+  float distance(uint32_t item, Vec2 point) const {
+    return length(point - closestPoint(boxes[item], point));
+  }
+};
+
+// Every query of the tree and the grid must agree with a loop over every
+// box. The tree holds only the items marked live; the grid is rebuilt
+// from all of them.
+void compare(const scene &s, const std::vector<bool> &live,
+             const DynamicTree &tree, const HashGrid &grid,
+             Xoshiro128Plus &random) {
+  for (int q = 0; q < 100; q++) {
+    Vec2 center = {uniform(random, -20, world + 20),
+                   uniform(random, -20, world + 20)};
+    float half = uniform(random, 0, q % 10 ? 10.0f : 150.0f);
+    Aabb box = {center - Vec2(half), center + Vec2(half * 0.7f)};
+
+    std::set<uint32_t> expected, expectedLive, fromTree, fromGrid;
+    for (uint32_t i = 0; i < count; i++) {
+      if (!overlaps(s.boxes[i], box)) continue;
+      expected.insert(i);
+      if (live[i]) expectedLive.insert(i);
+    }
+    size_t gridCalls = 0;
+    grid.query(box, [&](uint32_t item) {
+      gridCalls++;
+      fromGrid.insert(item);
+      return true;
+    });
+    CHECK(gridCalls == fromGrid.size());  // each item once
+    CHECK(fromGrid == expected);
+    // The tree reports fat boxes, so it may give more; filter them.
+    tree.query(box, [&](int32_t proxy) {
+      uint32_t item = tree.userData(proxy);
+      CHECK(live[item]);
+      if (overlaps(s.boxes[item], box)) fromTree.insert(item);
+      return true;
+    });
+    CHECK(fromTree == expectedLive);
+
+    Ray ray = {center, inCircle(random) * uniform(random, 0.1f, 5.0f)};
+    if (q % 7 == 0) ray.direction = {1, 0};
+    if (q % 11 == 0) ray.direction = {0, -3};
+    float maxT = q % 3 ? INFINITY : 50;
+    float expectedT = INFINITY, expectedLiveT = INFINITY;
+    RayHit hit;
+    for (uint32_t i = 0; i < count; i++) {
+      if (!raycast(ray, s.boxes[i], maxT, &hit)) continue;
+      expectedT = std::min(expectedT, hit.t);
+      if (live[i]) expectedLiveT = std::min(expectedLiveT, hit.t);
+    }
+    float gridT = INFINITY;
+    std::vector<uint32_t> seen;
+    grid.raycast(ray, maxT, [&](uint32_t item, float limit) {
+      seen.push_back(item);
+      RayHit h;
+      if (!raycast(ray, s.boxes[item], limit, &h) || h.t >= gridT)
+        return limit;
+      return gridT = h.t;
+    });
+    CHECK(std::set<uint32_t>(seen.begin(), seen.end()).size() == seen.size());
+    CHECK(gridT == expectedT);
+    float treeT = INFINITY;
+    tree.raycast(ray, maxT, [&](int32_t proxy, float limit) {
+      RayHit h;
+      if (!raycast(ray, s.boxes[tree.userData(proxy)], limit, &h) ||
+          h.t >= treeT)
+        return limit;
+      return treeT = h.t;
+    });
+    CHECK(treeT == expectedLiveT);
+
+    // Compared by distance, since ties may pick either item.
+    float maxDistance = q % 4 ? INFINITY : 15;
+    float nearest = maxDistance, nearestLive = maxDistance;
+    for (uint32_t i = 0; i < count; i++) {
+      float d = s.distance(i, center);
+      nearest = std::min(nearest, d);
+      if (live[i]) nearestLive = std::min(nearestLive, d);
+    }
+    uint32_t gridItem = grid.nearest(center, maxDistance, [&](uint32_t item) {
+      return s.distance(item, center);
+    });
+    CHECK((gridItem == HashGrid::npos ? maxDistance
+                                      : s.distance(gridItem, center)) ==
+          nearest);
+    int32_t treeProxy = tree.nearest(center, maxDistance, [&](int32_t proxy) {
+      return s.distance(tree.userData(proxy), center);
+    });
+    CHECK((treeProxy == DynamicTree::nullProxy
+               ? maxDistance
+               : s.distance(tree.userData(treeProxy), center)) ==
+          nearestLive);
+  }
+}
+
+}  // namespace
+
+int main() {
+  Xoshiro128Plus random(7);
+  scene s;
+  for (int i = 0; i < count; i++) {
+    Vec2 center = {uniform(random, 0, world), uniform(random, 0, world)};
+    float half = uniform(random, 0.5f, i % 100 ? 3.0f : 30.0f);
+    s.boxes.push_back({center - Vec2(half), center + Vec2(half)});
+    s.velocities.push_back(inCircle(random) * 2);
+  }
+  std::vector<bool> all(count, true), live(count, true);
+
+  // One tree built in bulk and refit, one built and moved a proxy at a
+  // time, with some proxies destroyed and recreated along the way.
+  DynamicTree bulk(0.5f), incremental(0.5f);
+  std::vector<uint32_t> items(count);
+  std::vector<int32_t> bulkIds(count), incrementalIds(count);
+  for (uint32_t i = 0; i < count; i++) items[i] = i;
+  bulk.createProxies(s.boxes.data(), items.data(), count, bulkIds.data());
+  for (uint32_t i = 0; i < count; i++)
+    incrementalIds[i] = incremental.createProxy(s.boxes[i], i);
+  HashGrid grid(8);
+
+  for (int step = 0; step < 60; step++) {
+    for (int i = 0; i < count; i++) {
+      Aabb &box = s.boxes[i];
+      box.min += s.velocities[i];
+      box.max += s.velocities[i];
+      if (box.min.x < 0 || box.max.x > world)
+        s.velocities[i].x = -s.velocities[i].x;
+      if (box.min.y < 0 || box.max.y > world)
+        s.velocities[i].y = -s.velocities[i].y;
+    }
+    bulk.moveProxies(bulkIds.data(), s.boxes.data(), count);
+    for (int i = 0; i < count; i++) {
+      if (step % 10 == 5 && i % 3 == step % 3) {
+        if (live[i])
+          incremental.destroyProxy(incrementalIds[i]);
+        else
+          incrementalIds[i] = incremental.createProxy(s.boxes[i], i);
+        live[i] = !live[i];
+      } else if (live[i]) {
+        incremental.moveProxy(incrementalIds[i], s.boxes[i]);
+      }
+    }
+    grid.build(s.boxes.data(), count);
+    if (step % 10) continue;
+
+    compare(s, all, bulk, grid, random);
+    compare(s, live, incremental, grid, random);
+  }
+  CHECK(bulk.proxyCount() == count);
+  return checkResult();
+}